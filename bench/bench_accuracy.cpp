@@ -0,0 +1,395 @@
+//
+// Accuracy of the DoubleDouble operators and functions over whole input
+// ranges, measured against __float128 (libquadmath), with the time per
+// call of both.
+//
+// For each function and range, n arguments are generated (random, plus
+// the ends of the range and a few edge cases inside it) and each result is compared to the
+// __float128 result for the same argument.  The arguments are generated
+// with at most 106 significant bits, so they are exact in __float128.
+// The error is reported in DoubleDouble ulps: for a reference value r with
+// 2**e <= |r| < 2**(e+1), one ulp is 2**(e - 105) (but never less than
+// 2**-1074).  __float128 has 113 bits, so the reference results are
+// accurate to about 1/128 of an ulp.
+//
+// "nonfinite" counts the arguments for which the result is not finite
+// and the reference is (or the reverse), or where one is NAN and the
+// other is not.  Those are left out of the max and mean.
+//
+// The arguments are a function of their index, so the results do not
+// depend on the number of threads.
+//
+// Usage: bench_accuracy [--n N] [--threads T] [name ...]
+// N is the number of arguments per range (default 1000000); T = 0 (the
+// default) uses one thread per hardware thread.  With names, only those
+// functions are checked.
+//
+
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <cfloat>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "doubledouble.h"
+#include "doubledouble_parallel.h"
+#include "timing.h"
+
+extern "C" {
+#include <quadmath.h>
+}
+
+using namespace doubledouble;
+
+typedef __float128 quad;
+
+enum range_kind {
+    linear,         // uniform in [lo, hi]
+    log_scale,      // log-uniform in [lo, hi], lo > 0
+    log_signed,     // log-uniform in [lo, hi] with a random sign
+};
+
+struct arg_range
+{
+    double lo;
+    double hi;
+    range_kind kind;
+};
+
+struct check_case
+{
+    const char *name;
+    int nargs;
+    DoubleDouble (*f)(const DoubleDouble&, const DoubleDouble&);
+    quad (*ref)(quad, quad);
+    arg_range x;
+    arg_range y;
+};
+
+static std::uint64_t splitmix64(std::uint64_t z)
+{
+    z += 0x9e3779b97f4a7c15u;
+    z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9u;
+    z = (z ^ (z >> 27))*0x94d049bb133111ebu;
+    return z ^ (z >> 31);
+}
+
+static double uniform(std::uint64_t h)
+{
+    return double(h >> 11)*0x1p-53;
+}
+
+//
+// A DoubleDouble in the range with a random lower part; the value has at
+// most 106 significant bits.
+//
+static DoubleDouble make_arg(const arg_range& r, std::uint64_t seed)
+{
+    std::uint64_t h1 = splitmix64(seed);
+    std::uint64_t h2 = splitmix64(h1);
+    double hi;
+    if (r.kind == linear) {
+        hi = r.lo + (r.hi - r.lo)*uniform(h1);
+    }
+    else {
+        hi = std::exp(std::log(r.lo) + (std::log(r.hi) - std::log(r.lo))*uniform(h1));
+        if (r.kind == log_signed && (h2 & 1)) {
+            hi = -hi;
+        }
+    }
+    if (hi == 0.0 || !std::isfinite(hi)) {
+        return DoubleDouble(hi);
+    }
+    int e;
+    std::frexp(hi, &e);
+    double lo = std::ldexp(double(std::int64_t(h2 >> 11) - (std::int64_t(1) << 52)),
+                           e - 106);
+    DoubleDouble x = two_sum(hi, lo);
+    if (x.upper < r.lo || x.upper > r.hi) {
+        // Keep edges like the domain of asin exact.
+        return DoubleDouble(hi);
+    }
+    return x;
+}
+
+static const double edge_points[] = {
+    0.0, -0.0, 0x1p-1000, 1e-300, 1e-20, 0.5, 1.0, 2.0,
+    1.5707963267948966, 3.141592653589793, 10.0, 100.0, 708.0, 709.7,
+    745.0, 1e300,
+};
+
+static bool in_range(const arg_range& r, double x)
+{
+    if (r.kind == log_signed) {
+        x = std::fabs(x);
+    }
+    return x >= r.lo && x <= r.hi;
+}
+
+//
+// The edge cases of a range: its ends and the edge points (and their
+// negatives) that are in the range.
+//
+static std::vector<double> range_edges(const arg_range& r)
+{
+    std::vector<double> edges{r.lo, r.hi};
+    for (double x : edge_points) {
+        for (double v : {x, -x}) {
+            if (in_range(r, v) && std::find(edges.begin(), edges.end(), v) == edges.end()) {
+                edges.push_back(v);
+            }
+        }
+    }
+    if (r.kind == log_signed) {
+        edges.push_back(-r.lo);
+        edges.push_back(-r.hi);
+    }
+    return edges;
+}
+
+//
+// Argument i of case k.  The first ones are the edges of the x range
+// (with the y argument at the middle of its range), the rest are random.
+//
+static void case_args(const check_case& c, const std::vector<double>& edges,
+                      std::size_t i, std::size_t k, DoubleDouble& x, DoubleDouble& y)
+{
+    std::uint64_t seed = (std::uint64_t(k) << 40) ^ (std::uint64_t(i) << 1);
+    if (i < edges.size()) {
+        x = DoubleDouble(edges[i]);
+        y = DoubleDouble(c.y.kind == linear ? (c.y.lo + c.y.hi)/2
+                                            : std::sqrt(c.y.lo*c.y.hi));
+    }
+    else {
+        x = make_arg(c.x, seed);
+        y = make_arg(c.y, seed | 1);
+    }
+}
+
+static quad to_quad(const DoubleDouble& x)
+{
+    return quad(x.upper) + x.lower;
+}
+
+struct error_stats
+{
+    std::size_t count{0};
+    std::size_t nonfinite{0};
+    double max_ulps{-1.0};
+    double sum_ulps{0.0};
+    DoubleDouble worst_x{0.0};
+    DoubleDouble worst_y{0.0};
+
+    void add(const error_stats& other)
+    {
+        count += other.count;
+        nonfinite += other.nonfinite;
+        sum_ulps += other.sum_ulps;
+        if (other.max_ulps > max_ulps) {
+            max_ulps = other.max_ulps;
+            worst_x = other.worst_x;
+            worst_y = other.worst_y;
+        }
+    }
+};
+
+static double error_ulps(const DoubleDouble& v, quad r)
+{
+    quad err = fabsq((quad(v.upper) - r) + v.lower);
+    if (r == 0) {
+        return double(ldexpq(err, 1074));
+    }
+    int e;
+    frexpq(r, &e);
+    int ulp_exp = std::max(e - 106, -1074);
+    return double(ldexpq(err, -ulp_exp));
+}
+
+static error_stats check_range(const check_case& c, const std::vector<double>& edges,
+                               std::size_t k, std::size_t begin, std::size_t end)
+{
+    error_stats s;
+    for (std::size_t i = begin; i < end; ++i) {
+        DoubleDouble x, y;
+        case_args(c, edges, i, k, x, y);
+        quad r = c.ref(to_quad(x), to_quad(y));
+        bool r_finite = !isnanq(r) && fabsq(r) <= DBL_MAX;
+        if (isnanq(r) && !std::isfinite(x.upper)) {
+            continue;
+        }
+        DoubleDouble v = c.f(x, y);
+        if (isnanq(r)) {
+            // Outside the domain (e.g. an edge point): not counted.
+            if (!std::isnan(v.upper)) {
+                ++s.nonfinite;
+            }
+            continue;
+        }
+        ++s.count;
+        if (!r_finite || !std::isfinite(v.upper)) {
+            if (r_finite || std::isnan(v.upper) || (r > 0) != (v.upper > 0)) {
+                ++s.nonfinite;
+            }
+            continue;
+        }
+        double ulps = error_ulps(v, r);
+        s.sum_ulps += ulps;
+        if (ulps > s.max_ulps) {
+            s.max_ulps = ulps;
+            s.worst_x = x;
+            s.worst_y = y;
+        }
+    }
+    return s;
+}
+
+static std::string describe(const arg_range& r)
+{
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%s[%g, %g]", r.kind == log_signed ? "+-" : "",
+                  r.lo, r.hi);
+    return buf;
+}
+
+static void run_case(const check_case& c, std::size_t k, std::size_t n,
+                     unsigned nthreads)
+{
+    std::vector<double> edges = range_edges(c.x);
+    n += edges.size();
+    nthreads = dd_parallel_nthreads(n, nthreads, 4096);
+    std::vector<error_stats> partial(nthreads);
+    dd_parallel_ranges(n, nthreads, [&](unsigned t, size_t begin, size_t end) {
+        partial[t] = check_range(c, edges, k, begin, end);
+    }, 4096);
+    error_stats s;
+    for (const auto& p : partial) {
+        s.add(p);
+    }
+
+    // Time per call, on one thread, over a sample of the random arguments.
+    static const std::size_t n_time = 4096;
+    std::vector<DoubleDouble> xs(n_time), ys(n_time);
+    std::vector<quad> qx(n_time), qy(n_time);
+    for (std::size_t i = 0; i < n_time; ++i) {
+        case_args(c, edges, edges.size() + i, k, xs[i], ys[i]);
+        qx[i] = to_quad(xs[i]);
+        qy[i] = to_quad(ys[i]);
+    }
+    double ns_dd = best_ns_per_op([&]() {
+        for (std::size_t i = 0; i < n_time; ++i) {
+            keep(c.f(xs[i], ys[i]));
+        }
+    }, n_time, 3);
+    double ns_quad = best_ns_per_op([&]() {
+        for (std::size_t i = 0; i < n_time; ++i) {
+            keep(c.ref(qx[i], qy[i]));
+        }
+    }, n_time, 3);
+
+    std::string range = describe(c.x);
+    if (c.nargs == 2) {
+        range += " x " + describe(c.y);
+    }
+    std::printf("%-10s %-36s %9zu %10.3f %9.4f %9zu %8.1f %8.1f   ",
+                c.name, range.c_str(), s.count, s.max_ulps,
+                s.count > s.nonfinite ? s.sum_ulps/(s.count - s.nonfinite) : 0.0,
+                s.nonfinite, ns_dd, ns_quad);
+    std::printf("x = (%.17g, %.17g)", s.worst_x.upper, s.worst_x.lower);
+    if (c.nargs == 2) {
+        std::printf(", y = (%.17g, %.17g)", s.worst_y.upper, s.worst_y.lower);
+    }
+    std::printf("\n");
+    std::fflush(stdout);
+}
+
+#define UNARY(name, dd_expr, ref_expr, ...) \
+    {name, 1, \
+     [](const DoubleDouble& x, const DoubleDouble&) { return dd_expr; }, \
+     [](quad x, quad) { return ref_expr; }, __VA_ARGS__, {0.0, 0.0, linear}}
+
+#define BINARY(name, dd_expr, ref_expr, ...) \
+    {name, 2, \
+     [](const DoubleDouble& x, const DoubleDouble& y) { return dd_expr; }, \
+     [](quad x, quad y) { return ref_expr; }, __VA_ARGS__}
+
+static const check_case cases[] = {
+    BINARY("+", x + y, x + y, {1e-10, 1e10, log_signed}, {1e-10, 1e10, log_signed}),
+    BINARY("-", x - y, x - y, {0.5, 2.0, linear}, {0.5, 2.0, linear}),
+    // The accurate addition (see "Accuracy tiers" in doubledouble.h).
+    BINARY("add_acc", x.add(y, dd_accurate), x + y, {1e-10, 1e10, log_signed},
+           {1e-10, 1e10, log_signed}),
+    BINARY("sub_acc", x.sub(y, dd_accurate), x - y, {0.5, 2.0, linear}, {0.5, 2.0, linear}),
+    BINARY("*", x * y, x * y, {1e-10, 1e10, log_signed}, {1e-10, 1e10, log_signed}),
+    BINARY("/", x / y, x / y, {1e-10, 1e10, log_signed}, {1e-10, 1e10, log_signed}),
+    UNARY("sqrt", x.sqrt(), sqrtq(x), {1e-290, 1e300, log_scale}),
+    // Below 2**-969 the lower parts are subnormal and lose bits.
+    UNARY("sqrt", x.sqrt(), sqrtq(x), {1e-307, 1e-290, log_scale}),
+    UNARY("powi(5)", x.powi(5), powq(x, 5), {0.5, 2.0, linear}),
+    UNARY("powi(-3)", x.powi(-3), powq(x, -3), {1e-10, 1e10, log_signed}),
+    UNARY("exp", x.exp(), expq(x), {-1.0, 1.0, linear}),
+    UNARY("exp", x.exp(), expq(x), {-700.0, 700.0, linear}),
+    UNARY("exp", x.exp(), expq(x), {-745.0, -708.0, linear}),
+    UNARY("expm1", x.expm1(), expm1q(x), {1e-20, 0.5, log_signed}),
+    UNARY("expm1", x.expm1(), expm1q(x), {-40.0, 40.0, linear}),
+    UNARY("log", x.log(), logq(x), {1e-290, 1e300, log_scale}),
+    UNARY("log", x.log(), logq(x), {0.999, 1.001, linear}),
+    UNARY("exp_fast", x.exp(dd_fast), expq(x), {-1.0, 1.0, linear}),
+    UNARY("exp_fast", x.exp(dd_fast), expq(x), {-700.0, 700.0, linear}),
+    UNARY("expm1_fast", x.expm1(dd_fast), expm1q(x), {1e-20, 0.5, log_signed}),
+    UNARY("expm1_fast", x.expm1(dd_fast), expm1q(x), {-40.0, 40.0, linear}),
+    UNARY("log_fast", x.log(dd_fast), logq(x), {1e-290, 1e300, log_scale}),
+    UNARY("log_fast", x.log(dd_fast), logq(x), {0.999, 1.001, linear}),
+    UNARY("log1p", x.log1p(), log1pq(x), {1e-20, 0.5, log_signed}),
+    UNARY("log1p", x.log1p(), log1pq(x), {-0.5, 1e10, linear}),
+    UNARY("sin", x.sin(), sinq(x), {-0.78, 0.78, linear}),
+    UNARY("sin", x.sin(), sinq(x), {-1e6, 1e6, linear}),
+    UNARY("cos", x.cos(), cosq(x), {-0.78, 0.78, linear}),
+    UNARY("cos", x.cos(), cosq(x), {-1e6, 1e6, linear}),
+    UNARY("tan", x.tan(), tanq(x), {-1e6, 1e6, linear}),
+    UNARY("atan", x.atan(), atanq(x), {1e-10, 1e10, log_signed}),
+    UNARY("asin", x.asin(), asinq(x), {-1.0, 1.0, linear}),
+    UNARY("acos", x.acos(), acosq(x), {-1.0, 1.0, linear}),
+    BINARY("atan2", atan2(x, y), atan2q(x, y), {-2.0, 2.0, linear}, {-2.0, 2.0, linear}),
+    UNARY("sinh", x.sinh(), sinhq(x), {1e-20, 0.5, log_signed}),
+    UNARY("sinh", x.sinh(), sinhq(x), {-20.0, 20.0, linear}),
+    UNARY("cosh", x.cosh(), coshq(x), {-20.0, 20.0, linear}),
+    UNARY("tanh", x.tanh(), tanhq(x), {1e-20, 0.5, log_signed}),
+    UNARY("tanh", x.tanh(), tanhq(x), {-20.0, 20.0, linear}),
+    UNARY("atanh", x.atanh(), atanhq(x), {-0.99, 0.99, linear}),
+    BINARY("hypot", hypot(x, y), hypotq(x, y), {1e-10, 1e10, log_signed},
+           {1e-10, 1e10, log_signed}),
+};
+
+int main(int argc, char *argv[])
+{
+    std::size_t n = 1000000;
+    unsigned nthreads = 0;
+    std::vector<std::string> names;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--n") == 0 && i + 1 < argc) {
+            n = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            nthreads = unsigned(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else {
+            names.push_back(argv[i]);
+        }
+    }
+
+    std::printf("%-10s %-36s %9s %10s %9s %9s %8s %8s   %s\n", "function", "range",
+                "n", "max ulps", "mean", "nonfinite", "ns (dd)", "ns (q)",
+                "worst argument");
+    std::size_t k = 0;
+    for (const auto& c : cases) {
+        ++k;
+        if (!names.empty()
+                && std::find(names.begin(), names.end(), c.name) == names.end()) {
+            continue;
+        }
+        run_case(c, k, n, nthreads);
+    }
+}
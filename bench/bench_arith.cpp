@@ -0,0 +1,81 @@
+//
+// Latency and throughput of the DoubleDouble arithmetic operators.
+//
+// "latency" times a chain of dependent operations; "throughput" times
+// independent operations over arrays.
+//
+
+#include <vector>
+#include "doubledouble.h"
+#include "timing.h"
+
+using namespace doubledouble;
+
+static const std::size_t n_chain = 10000000;
+static const std::size_t n_array = 4096;
+static const std::size_t n_pass = 2000;
+
+template <typename Op>
+void bench_latency(const char *name, Op op)
+{
+    double ns = best_ns_per_op([&]() {
+        DoubleDouble x{1.0, 1e-17};
+        const DoubleDouble y{1.0000000001, -3e-27};
+        for (std::size_t i = 0; i < n_chain; ++i) {
+            x = op(x, y);
+        }
+        keep(x);
+    }, n_chain);
+    print_result(name, ns);
+}
+
+template <typename Op>
+void bench_throughput(const char *name, Op op)
+{
+    std::vector<DoubleDouble> a(n_array), b(n_array), c(n_array);
+    for (std::size_t i = 0; i < n_array; ++i) {
+        a[i] = DoubleDouble(1.0 + i*1e-3, 1e-19*i);
+        b[i] = DoubleDouble(0.5 + i*1e-4, -2e-20*i);
+    }
+    double ns = best_ns_per_op([&]() {
+        for (std::size_t k = 0; k < n_pass; ++k) {
+            for (std::size_t i = 0; i < n_array; ++i) {
+                c[i] = op(a[i], b[i]);
+            }
+            keep(c[0]);
+        }
+    }, n_array*n_pass);
+    print_result(name, ns);
+}
+
+int main()
+{
+#ifdef DOUBLEDOUBLE_IGNORE_NONFINITE
+    std::printf("DOUBLEDOUBLE_IGNORE_NONFINITE is defined\n");
+#endif
+    bench_latency("latency dd + dd", [](auto x, auto y) { return x + y; });
+    bench_latency("latency dd - dd", [](auto x, auto y) { return x - y; });
+    bench_latency("latency dd * dd", [](auto x, auto y) { return x * y; });
+    bench_latency("latency dd / dd", [](auto x, auto y) { return x / y; });
+    bench_latency("latency dd + double", [](auto x, auto y) { return x + y.upper; });
+    bench_latency("latency dd * double", [](auto x, auto y) { return x * y.upper; });
+    bench_latency("latency dd / double", [](auto x, auto y) { return x / y.upper; });
+    bench_latency("latency dd * dd + dd", [](auto x, auto y) { return x * y + y; });
+    bench_latency("latency dd_fma", [](auto x, auto y) { return dd_fma(x, y, y); });
+    bench_latency("latency 1 / dd", [](auto x, auto) { return 1.0 / x; });
+    bench_latency("latency recip", [](auto x, auto) { return x.recip(); });
+
+    bench_throughput("throughput dd + dd", [](auto x, auto y) { return x + y; });
+    bench_throughput("throughput dd - dd", [](auto x, auto y) { return x - y; });
+    bench_throughput("throughput dd * dd", [](auto x, auto y) { return x * y; });
+    bench_throughput("throughput dd / dd", [](auto x, auto y) { return x / y; });
+    bench_throughput("throughput dd + double", [](auto x, auto y) { return x + y.upper; });
+    bench_throughput("throughput dd * double", [](auto x, auto y) { return x * y.upper; });
+    bench_throughput("throughput dd / double", [](auto x, auto y) { return x / y.upper; });
+    bench_throughput("throughput dd * dd + dd", [](auto x, auto y) { return x * y + y; });
+    bench_throughput("throughput dd_fma", [](auto x, auto y) { return dd_fma(x, y, y); });
+    bench_throughput("throughput dd * dd (same)", [](auto x, auto) { return x * x; });
+    bench_throughput("throughput sqr", [](auto x, auto) { return x.sqr(); });
+    bench_throughput("throughput 1 / dd", [](auto x, auto) { return 1.0 / x; });
+    bench_throughput("throughput recip", [](auto x, auto) { return x.recip(); });
+}
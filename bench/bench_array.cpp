@@ -0,0 +1,56 @@
+//
+// Batched kernels of doubledouble_array.h compared to a loop over a
+// std::vector<DoubleDouble> using the scalar operators.
+//
+// Build with e.g. `make ARCHFLAGS="-march=native -fno-math-errno"` to let
+// the compiler vectorize the kernels.
+//
+
+#include <vector>
+#include "doubledouble_array.h"
+#include "timing.h"
+
+using namespace doubledouble;
+
+static const std::size_t n = 4096;
+static const std::size_t n_pass = 2000;
+
+template <typename Op, typename Kernel>
+void bench_pair(const char *name, Op op, Kernel kernel)
+{
+    std::vector<DoubleDouble> a(n), b(n), c(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        a[i] = DoubleDouble(1.0 + i*1e-3, 1e-19*i);
+        b[i] = DoubleDouble(0.5 + i*1e-4, -2e-20*i);
+    }
+    DoubleDoubleArray sa(a), sb(b), sc(n);
+
+    double ns_scalar = best_ns_per_op([&]() {
+        for (std::size_t k = 0; k < n_pass; ++k) {
+            for (std::size_t i = 0; i < n; ++i) {
+                c[i] = op(a[i], b[i]);
+            }
+            keep(c[0]);
+        }
+    }, n*n_pass);
+    double ns_kernel = best_ns_per_op([&]() {
+        for (std::size_t k = 0; k < n_pass; ++k) {
+            kernel(sc, sa, sb);
+            keep(sc.upper()[0]);
+        }
+    }, n*n_pass);
+    std::printf("%-10s scalar %7.3f ns/op   kernel %7.3f ns/op   speedup %5.2f\n",
+                name, ns_scalar, ns_kernel, ns_scalar/ns_kernel);
+}
+
+int main()
+{
+    bench_pair("add", [](auto x, auto y) { return x + y; }, dd_add);
+    bench_pair("sub", [](auto x, auto y) { return x - y; }, dd_sub);
+    bench_pair("mul", [](auto x, auto y) { return x * y; }, dd_mul);
+    bench_pair("div", [](auto x, auto y) { return x / y; }, dd_div);
+    bench_pair("sqrt", [](auto x, auto) { return x.sqrt(); },
+               [](dd_span z, dd_const_span x, dd_const_span) { dd_sqrt(z, x); });
+    bench_pair("muladd", [](auto x, auto y) { return x*y + x; },
+               [](dd_span w, dd_const_span x, dd_const_span y) { dd_muladd(w, x, y, x); });
+}
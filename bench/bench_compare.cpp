@@ -0,0 +1,314 @@
+//
+// Latency and throughput of the DoubleDouble operators and of powi, exp,
+// expm1, log, log1p, sqrt, hypot and dsum, compared to the same
+// operations with double, long double and (when the compiler has it, and
+// BENCH_FLOAT128 is defined) __float128 from libquadmath.
+//
+// "latency" makes each operation depend on the previous result (for the
+// functions, through a multiplication by 0.0 and an addition, whose time
+// is included); "throughput" evaluates the operation on arrays of
+// independent arguments.  The number of iterations is fixed, and each time
+// is the best of several runs after a warm-up run.  The baselines compute
+// powi by binary powering, as DoubleDouble::powi does, and sum an array
+// with a single accumulator of their own type.
+//
+// Usage: bench_compare [--json path]
+// With --json, the results are also written to `path` (see write_json()
+// in timing.h), so that they can be compared between versions.
+//
+
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <random>
+#include "doubledouble.h"
+#include "timing.h"
+
+#ifdef BENCH_FLOAT128
+extern "C" {
+#include <quadmath.h>
+}
+#endif
+
+using namespace doubledouble;
+
+static const std::size_t n_array = 4096;
+static const std::size_t n_pass = 20;
+
+//
+// Each type is described by a traits class with its name, the conversion
+// from a DoubleDouble value, the leading double of a value (used only to
+// make the arguments of the latency loops depend on the previous result),
+// and the functions.
+//
+
+template <typename T>
+T powi_by_squaring(T x, int n)
+{
+    T r = 1;
+    T p = x;
+    unsigned m = n < 0 ? -unsigned(n) : unsigned(n);
+    while (true) {
+        if (m & 1) {
+            r = r*p;
+        }
+        m >>= 1;
+        if (m == 0) {
+            break;
+        }
+        p = p*p;
+    }
+    return n < 0 ? T(1)/r : r;
+}
+
+struct double_traits
+{
+    typedef double type;
+    static const char *name() { return "double"; }
+    static double from(const DoubleDouble& x) { return x.upper; }
+    static double leading(double x) { return x; }
+    static double sqrt(double x) { return std::sqrt(x); }
+    static double powi(double x, int n) { return powi_by_squaring(x, n); }
+    static double exp(double x) { return std::exp(x); }
+    static double expm1(double x) { return std::expm1(x); }
+    static double log(double x) { return std::log(x); }
+    static double log1p(double x) { return std::log1p(x); }
+    static double hypot(double x, double y) { return std::hypot(x, y); }
+    static double sum(std::size_t n, const double *x)
+    {
+        double s = 0.0;
+        for (std::size_t i = 0; i < n; ++i) {
+            s += x[i];
+        }
+        return s;
+    }
+};
+
+struct long_double_traits
+{
+    typedef long double type;
+    static const char *name() { return "long double"; }
+    static long double from(const DoubleDouble& x)
+    {
+        return (long double) x.upper + x.lower;
+    }
+    static double leading(long double x) { return double(x); }
+    static long double sqrt(long double x) { return std::sqrt(x); }
+    static long double powi(long double x, int n) { return powi_by_squaring(x, n); }
+    static long double exp(long double x) { return std::exp(x); }
+    static long double expm1(long double x) { return std::expm1(x); }
+    static long double log(long double x) { return std::log(x); }
+    static long double log1p(long double x) { return std::log1p(x); }
+    static long double hypot(long double x, long double y) { return std::hypot(x, y); }
+    static long double sum(std::size_t n, const long double *x)
+    {
+        long double s = 0.0;
+        for (std::size_t i = 0; i < n; ++i) {
+            s += x[i];
+        }
+        return s;
+    }
+};
+
+#ifdef BENCH_FLOAT128
+struct float128_traits
+{
+    typedef __float128 type;
+    static const char *name() { return "__float128"; }
+    static __float128 from(const DoubleDouble& x)
+    {
+        return (__float128) x.upper + x.lower;
+    }
+    static double leading(__float128 x) { return double(x); }
+    static __float128 sqrt(__float128 x) { return sqrtq(x); }
+    static __float128 powi(__float128 x, int n) { return powi_by_squaring(x, n); }
+    static __float128 exp(__float128 x) { return expq(x); }
+    static __float128 expm1(__float128 x) { return expm1q(x); }
+    static __float128 log(__float128 x) { return logq(x); }
+    static __float128 log1p(__float128 x) { return log1pq(x); }
+    static __float128 hypot(__float128 x, __float128 y) { return hypotq(x, y); }
+    static __float128 sum(std::size_t n, const __float128 *x)
+    {
+        __float128 s = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            s += x[i];
+        }
+        return s;
+    }
+};
+#endif
+
+struct doubledouble_traits
+{
+    typedef DoubleDouble type;
+    static const char *name() { return "DoubleDouble"; }
+    static DoubleDouble from(const DoubleDouble& x) { return x; }
+    static double leading(const DoubleDouble& x) { return x.upper; }
+    static DoubleDouble sqrt(const DoubleDouble& x) { return x.sqrt(); }
+    static DoubleDouble powi(const DoubleDouble& x, int n) { return x.powi(n); }
+    static DoubleDouble exp(const DoubleDouble& x) { return x.exp(); }
+    static DoubleDouble expm1(const DoubleDouble& x) { return x.expm1(); }
+    static DoubleDouble log(const DoubleDouble& x) { return x.log(); }
+    static DoubleDouble log1p(const DoubleDouble& x) { return x.log1p(); }
+    static DoubleDouble hypot(const DoubleDouble& x, const DoubleDouble& y)
+    {
+        return doubledouble::hypot(x, y);
+    }
+    static DoubleDouble sum(std::size_t n, const DoubleDouble *x)
+    {
+        return dsum_dd(n, x);
+    }
+};
+
+static std::vector<bench_record> records;
+
+static void report(const char *name, const char *type, double latency,
+                   double throughput)
+{
+    if (std::isnan(latency)) {
+        std::printf("%-8s %-14s latency         -      throughput %9.2f ns\n",
+                    name, type, throughput);
+    }
+    else {
+        std::printf("%-8s %-14s latency %9.2f ns   throughput %9.2f ns\n",
+                    name, type, latency, throughput);
+    }
+    records.push_back(bench_record{name, type, latency, throughput});
+}
+
+template <typename Traits>
+std::vector<typename Traits::type> sample(double lo, double hi, unsigned seed)
+{
+    std::mt19937_64 gen(seed);
+    std::uniform_real_distribution<double> u(lo, hi);
+    std::vector<typename Traits::type> a(n_array);
+    for (auto& x : a) {
+        x = Traits::from(DoubleDouble(u(gen)) + u(gen)*std::abs(hi)*1e-17);
+    }
+    return a;
+}
+
+//
+// op(x, y) for the arithmetic operators.  The latency loop computes
+// x = op(x, y) with y close to 1, so x stays in range.
+//
+template <typename Traits, typename Op>
+void bench_operator(const char *name, Op op)
+{
+    typedef typename Traits::type T;
+    std::vector<T> a = sample<Traits>(0.5, 2.0, 1);
+    std::vector<T> b = sample<Traits>(0.5, 2.0, 2);
+    std::vector<T> c(n_array);
+    const T y = Traits::from(DoubleDouble(1.0000000001, -3e-27));
+    double latency = best_ns_per_op([&]() {
+        T x = Traits::from(DoubleDouble(1.0, 1e-17));
+        for (std::size_t i = 0; i < n_array*n_pass; ++i) {
+            x = op(x, y);
+        }
+        keep(x);
+    }, n_array*n_pass);
+    double throughput = best_ns_per_op([&]() {
+        for (std::size_t k = 0; k < n_pass; ++k) {
+            for (std::size_t i = 0; i < n_array; ++i) {
+                c[i] = op(a[i], b[i]);
+            }
+            keep(c[0]);
+        }
+    }, n_array*n_pass);
+    report(name, Traits::name(), latency, throughput);
+}
+
+template <typename Traits, typename F>
+void bench_function(const char *name, F f, double lo, double hi)
+{
+    typedef typename Traits::type T;
+    std::vector<T> a = sample<Traits>(lo, hi, 3);
+    std::vector<T> c(n_array);
+    double latency = best_ns_per_op([&]() {
+        T r = 0;
+        for (std::size_t k = 0; k < n_pass; ++k) {
+            for (std::size_t i = 0; i < n_array; ++i) {
+                r = f(a[i] + Traits::leading(r)*0.0);
+            }
+        }
+        keep(r);
+    }, n_array*n_pass);
+    double throughput = best_ns_per_op([&]() {
+        for (std::size_t k = 0; k < n_pass; ++k) {
+            for (std::size_t i = 0; i < n_array; ++i) {
+                c[i] = f(a[i]);
+            }
+            keep(c[0]);
+        }
+    }, n_array*n_pass);
+    report(name, Traits::name(), latency, throughput);
+}
+
+//
+// The sum of an array has no latency of its own; only the time per
+// element is reported.
+//
+template <typename Traits>
+void bench_sum()
+{
+    typedef typename Traits::type T;
+    std::vector<T> a = sample<Traits>(-1.0, 1.0, 4);
+    double throughput = best_ns_per_op([&]() {
+        for (std::size_t k = 0; k < n_pass; ++k) {
+            keep(Traits::sum(a.size(), a.data()));
+        }
+    }, n_array*n_pass);
+    report("dsum", Traits::name(), NAN, throughput);
+}
+
+template <typename Traits>
+void bench_type()
+{
+    typedef typename Traits::type T;
+    bench_operator<Traits>("+", [](const T& x, const T& y) { return x + y; });
+    bench_operator<Traits>("-", [](const T& x, const T& y) { return x - y; });
+    bench_operator<Traits>("*", [](const T& x, const T& y) { return x * y; });
+    bench_operator<Traits>("/", [](const T& x, const T& y) { return x / y; });
+    bench_function<Traits>("sqrt", Traits::sqrt, 0.0, 1e10);
+    // The exponent is read from a volatile so that the powering loop is
+    // not specialized for it.
+    static volatile int n15 = 15;
+    bench_function<Traits>("powi(15)", [](const T& x) {
+        return Traits::powi(x, n15);
+    }, 0.5, 2.0);
+    bench_function<Traits>("exp", Traits::exp, -20.0, 20.0);
+    bench_function<Traits>("expm1", Traits::expm1, -0.5, 0.5);
+    bench_function<Traits>("log", Traits::log, 1e-10, 1e10);
+    bench_function<Traits>("log1p", Traits::log1p, -0.5, 1.0);
+    const T y = Traits::from(DoubleDouble(0.75, 1e-17));
+    bench_function<Traits>("hypot", [=](const T& x) {
+        return Traits::hypot(x, y);
+    }, -2.0, 2.0);
+    bench_sum<Traits>();
+}
+
+int main(int argc, char *argv[])
+{
+    const char *json_path = nullptr;
+    if (argc == 3 && std::strcmp(argv[1], "--json") == 0) {
+        json_path = argv[2];
+    }
+    else if (argc != 1) {
+        std::fprintf(stderr, "usage: %s [--json path]\n", argv[0]);
+        return 2;
+    }
+
+    bench_type<double_traits>();
+    bench_type<long_double_traits>();
+#ifdef BENCH_FLOAT128
+    bench_type<float128_traits>();
+#endif
+    bench_type<doubledouble_traits>();
+
+    if (json_path != nullptr && !write_json(json_path, "bench_compare", records)) {
+        std::fprintf(stderr, "cannot write %s\n", json_path);
+        return 1;
+    }
+    return 0;
+}
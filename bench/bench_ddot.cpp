@@ -0,0 +1,58 @@
+//
+// Throughput of ddot() compared to a serial loop of two_product() and
+// DoubleDouble addition, and to a plain double dot product.
+//
+
+#include <vector>
+#include <random>
+#include "doubledouble.h"
+#include "timing.h"
+
+using namespace doubledouble;
+
+static double serial_ddot(size_t n, const double *x, const double *y)
+{
+    DoubleDouble sum{0.0, 0.0};
+    for (size_t i = 0; i < n; ++i) {
+        sum = sum + two_product(x[i], y[i]);
+    }
+    return sum.upper;
+}
+
+static double naive_dot(size_t n, const double *x, const double *y)
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += x[i]*y[i];
+    }
+    return sum;
+}
+
+template <typename Dot>
+void bench_dot(const char *name, Dot dot, const std::vector<double>& x,
+               const std::vector<double>& y)
+{
+    double ns = best_ns_per_op([&]() {
+        keep(dot(x.size(), x.data(), y.data()));
+    }, x.size());
+    std::printf("%-14s n = %9zu   %7.3f ns/element   %7.2f GB/s\n",
+                name, x.size(), ns, 2*sizeof(double)/ns);
+}
+
+int main()
+{
+    std::mt19937_64 gen(12345);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    for (size_t n : {size_t(4096), size_t(1) << 20, size_t(1) << 25}) {
+        std::vector<double> x(n), y(n);
+        for (size_t i = 0; i < n; ++i) {
+            x[i] = u(gen);
+            y[i] = u(gen);
+        }
+        bench_dot("ddot", [](size_t n, const double *x, const double *y) {
+            return ddot(n, x, y);
+        }, x, y);
+        bench_dot("serial dd dot", serial_ddot, x, y);
+        bench_dot("double dot", naive_dot, x, y);
+    }
+}
@@ -0,0 +1,69 @@
+//
+// Time per value of the decimal conversions in doubledouble_decimal.h,
+// for random values with |x| in [1e-5, 1e5], and for comparison the
+// conversion of the two parts with std::to_chars and std::from_chars.
+//
+
+#include <string>
+#include <vector>
+#include <random>
+#include <cstring>
+#include "doubledouble_decimal.h"
+#include "timing.h"
+
+using namespace doubledouble;
+
+static const std::size_t n_values = 20000;
+
+int main()
+{
+    std::mt19937_64 gen(12345);
+    std::uniform_real_distribution<double> u(-5.0, 5.0);
+    std::vector<DoubleDouble> x(n_values);
+    for (auto& xi : x) {
+        xi = DoubleDouble(10.0).powi(int(u(gen)*3))*(DoubleDouble(u(gen))/3.0);
+    }
+    char buf[256];
+    std::vector<std::string> text(n_values), text32(n_values);
+    for (std::size_t i = 0; i < n_values; ++i) {
+        auto r = to_chars(buf, buf + sizeof(buf), x[i]);
+        text[i].assign(buf, r.ptr);
+        r = to_chars(buf, buf + sizeof(buf), x[i], 32);
+        text32[i].assign(buf, r.ptr);
+    }
+
+    double ns = best_ns_per_op([&]() {
+        for (const auto& xi : x) {
+            auto r = std::to_chars(buf, buf + sizeof(buf), xi.upper);
+            *r.ptr++ = ' ';
+            r = std::to_chars(r.ptr, buf + sizeof(buf), xi.lower);
+            keep(buf[0]);
+        }
+    }, n_values);
+    print_result("std::to_chars, both parts", ns);
+
+    ns = best_ns_per_op([&]() {
+        for (const auto& xi : x) {
+            to_chars(buf, buf + sizeof(buf), xi);
+            keep(buf[0]);
+        }
+    }, n_values);
+    print_result("to_chars, shortest", ns);
+
+    ns = best_ns_per_op([&]() {
+        for (const auto& xi : x) {
+            to_chars(buf, buf + sizeof(buf), xi, 32);
+            keep(buf[0]);
+        }
+    }, n_values);
+    print_result("to_chars, 32 digits", ns);
+
+    ns = best_ns_per_op([&]() {
+        for (const auto& s : text32) {
+            DoubleDouble y;
+            from_chars(s.data(), s.data() + s.size(), y);
+            keep(y);
+        }
+    }, n_values);
+    print_result("from_chars, 32 digits", ns);
+}
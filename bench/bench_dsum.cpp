@@ -0,0 +1,55 @@
+//
+// Throughput of dsum() in GB/s, compared to a serial DoubleDouble
+// accumulation (the implementation of dsum() before it used several
+// lanes) and to a plain double sum.
+//
+
+#include <vector>
+#include <random>
+#include "doubledouble.h"
+#include "timing.h"
+
+using namespace doubledouble;
+
+static double serial_dsum(size_t n, const double *x)
+{
+    DoubleDouble sum{0.0, 0.0};
+    for (size_t i = 0; i < n; ++i) {
+        sum = sum + x[i];
+    }
+    return sum.upper;
+}
+
+static double naive_sum(size_t n, const double *x)
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += x[i];
+    }
+    return sum;
+}
+
+template <typename Sum>
+void bench_sum(const char *name, Sum sum, const std::vector<double>& x)
+{
+    double ns = best_ns_per_op([&]() {
+        keep(sum(x.size(), &x[0]));
+    }, x.size());
+    std::printf("%-14s n = %9zu   %7.3f ns/element   %7.2f GB/s\n",
+                name, x.size(), ns, sizeof(double)/ns);
+}
+
+int main()
+{
+    std::mt19937_64 gen(12345);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    for (size_t n : {size_t(4096), size_t(1) << 20, size_t(1) << 26}) {
+        std::vector<double> x(n);
+        for (auto& v : x) {
+            v = u(gen);
+        }
+        bench_sum("dsum", [](size_t n, const double *p) { return dsum(n, p); }, x);
+        bench_sum("serial dd sum", serial_dsum, x);
+        bench_sum("double sum", naive_sum, x);
+    }
+}
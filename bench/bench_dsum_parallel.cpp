@@ -0,0 +1,39 @@
+//
+// Scaling of dsum_parallel() with the number of threads, in GB/s.
+//
+
+#include <vector>
+#include <random>
+#include <thread>
+#include "doubledouble_parallel.h"
+#include "timing.h"
+
+using namespace doubledouble;
+
+int main()
+{
+    const size_t n = size_t(1) << 27;
+    std::mt19937_64 gen(12345);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<double> x(n);
+    for (auto& v : x) {
+        v = u(gen);
+    }
+    unsigned hw = std::thread::hardware_concurrency();
+    if (hw == 0) {
+        hw = 1;
+    }
+    for (unsigned nthreads = 1; ; nthreads *= 2) {
+        if (nthreads > hw) {
+            nthreads = hw;
+        }
+        double ns = best_ns_per_op([&]() {
+            keep(dsum_parallel(n, x.data(), nthreads));
+        }, n);
+        std::printf("dsum_parallel  n = %zu  nthreads = %3u   %7.2f GB/s\n",
+                    n, nthreads, sizeof(double)/ns);
+        if (nthreads == hw) {
+            break;
+        }
+    }
+}
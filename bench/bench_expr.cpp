@@ -0,0 +1,70 @@
+//
+// Latency of some formulas evaluated with the DoubleDouble operators and
+// with the expression templates of doubledouble_expr.h.
+//
+// Each formula is iterated, x = f(x), so the time is the latency of one
+// evaluation.  The constants are chosen so that the iteration converges.
+//
+
+#include "doubledouble_expr.h"
+#include "timing.h"
+
+using namespace doubledouble;
+
+static const std::size_t n_chain = 2000000;
+
+template <typename F>
+void bench_formula(const char *name, F f)
+{
+    double ns = best_ns_per_op([&]() {
+        DoubleDouble x{0.75, 1e-17};
+        for (std::size_t i = 0; i < n_chain; ++i) {
+            x = f(x);
+        }
+        keep(x);
+    }, n_chain);
+    print_result(name, ns);
+}
+
+int main()
+{
+    const DoubleDouble a{0.5, 1e-17};
+    const DoubleDouble b{1.25, -3e-17};
+    const DoubleDouble c{0.375, 2e-18};
+    const DoubleDouble d{3.0, 1e-16};
+
+    bench_formula("a*x + b*c", [&](const DoubleDouble& x) {
+        return a*x + b*c;
+    });
+    bench_formula("a*x + b*c (lazy)", [&](const DoubleDouble& x) -> DoubleDouble {
+        return dd_lazy(a)*x + dd_lazy(b)*c;
+    });
+
+    bench_formula("(x + a)*(b - c)/d", [&](const DoubleDouble& x) {
+        return (x + a)*(b - c)/d;
+    });
+    bench_formula("(x + a)*(b - c)/d (lazy)", [&](const DoubleDouble& x) -> DoubleDouble {
+        return (dd_lazy(x) + a)*(dd_lazy(b) - c)/d;
+    });
+
+    bench_formula("x/d + a/d + b/d", [&](const DoubleDouble& x) {
+        return x/d + a/d + b/d;
+    });
+    bench_formula("x/d + a/d + b/d (lazy)", [&](const DoubleDouble& x) -> DoubleDouble {
+        return dd_lazy(x)/d + dd_lazy(a)/d + dd_lazy(b)/d;
+    });
+
+    bench_formula("pi*x**2*c/3", [&](const DoubleDouble& x) {
+        return dd_pi*x.sqr()*c/3;
+    });
+    bench_formula("pi*x**2*c/3 (lazy)", [&](const DoubleDouble& x) -> DoubleDouble {
+        return dd_lazy(dd_pi)*x.sqr()*c/3;
+    });
+
+    bench_formula("Horner, degree 5", [&](const DoubleDouble& x) {
+        return ((((c*x + a)*x + c)*x + a)*x + c)*x + a;
+    });
+    bench_formula("Horner, degree 5 (lazy)", [&](const DoubleDouble& x) -> DoubleDouble {
+        return ((((dd_lazy(c)*x + a)*x + c)*x + a)*x + c)*x + a;
+    });
+}
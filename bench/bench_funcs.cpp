@@ -0,0 +1,99 @@
+//
+// Latency and throughput of the DoubleDouble elementary functions.
+//
+// "latency" makes each argument depend on the previous result (through
+// an extra multiplication by 0.0 and a double addition, which the
+// compiler cannot remove); "throughput" evaluates the function on an
+// array of independent arguments.
+//
+
+#include <vector>
+#include <random>
+#include "doubledouble.h"
+#include "timing.h"
+
+using namespace doubledouble;
+
+static const std::size_t n_array = 4096;
+static const std::size_t n_pass = 100;
+
+template <typename F>
+void bench_function(const char *name, F f, double lo, double hi)
+{
+    std::mt19937_64 gen(12345);
+    std::uniform_real_distribution<double> u(lo, hi);
+    std::vector<DoubleDouble> a(n_array), c(n_array);
+    for (auto& x : a) {
+        x = DoubleDouble(u(gen), 0.0) + u(gen)*1e-17;
+    }
+    double latency = best_ns_per_op([&]() {
+        DoubleDouble r{0.0};
+        for (std::size_t k = 0; k < n_pass; ++k) {
+            for (std::size_t i = 0; i < n_array; ++i) {
+                r = f(a[i] + r.upper*0.0);
+            }
+        }
+        keep(r);
+    }, n_array*n_pass);
+    double throughput = best_ns_per_op([&]() {
+        for (std::size_t k = 0; k < n_pass; ++k) {
+            for (std::size_t i = 0; i < n_array; ++i) {
+                c[i] = f(a[i]);
+            }
+            keep(c[0]);
+        }
+    }, n_array*n_pass);
+    std::printf("%-10s [%6g, %6g]   latency %8.2f ns   throughput %8.2f ns\n",
+                name, lo, hi, latency, throughput);
+}
+
+int main()
+{
+    bench_function("exp", [](const DoubleDouble& x) { return x.exp(); }, -20.0, 20.0);
+    bench_function("exp", [](const DoubleDouble& x) { return x.exp(); }, -700.0, 700.0);
+    bench_function("expm1", [](const DoubleDouble& x) { return x.expm1(); }, -0.5, 0.5);
+    bench_function("expm1", [](const DoubleDouble& x) { return x.expm1(); }, -20.0, 20.0);
+    bench_function("log", [](const DoubleDouble& x) { return x.log(); }, 0.0, 1.0);
+    bench_function("log", [](const DoubleDouble& x) { return x.log(); }, 1.0, 1e300);
+    bench_function("log1p", [](const DoubleDouble& x) { return x.log1p(); }, -0.5, 1.0);
+    bench_function("sin", [](const DoubleDouble& x) { return x.sin(); }, -0.78, 0.78);
+    bench_function("sin", [](const DoubleDouble& x) { return x.sin(); }, -100.0, 100.0);
+    bench_function("cos", [](const DoubleDouble& x) { return x.cos(); }, -100.0, 100.0);
+    bench_function("tan", [](const DoubleDouble& x) { return x.tan(); }, -100.0, 100.0);
+    bench_function("sincos", [](const DoubleDouble& x) {
+        DoubleDouble s, c;
+        x.sincos(s, c);
+        return s + c;
+    }, -100.0, 100.0);
+    bench_function("atan", [](const DoubleDouble& x) { return x.atan(); }, -2.0, 2.0);
+    bench_function("atan2", [](const DoubleDouble& y) {
+        return atan2(y, DoubleDouble(-0.75));
+    }, -2.0, 2.0);
+    bench_function("asin", [](const DoubleDouble& x) { return x.asin(); }, -1.0, 1.0);
+    bench_function("acos", [](const DoubleDouble& x) { return x.acos(); }, -1.0, 1.0);
+    bench_function("sinh", [](const DoubleDouble& x) { return x.sinh(); }, -0.5, 0.5);
+    bench_function("sinh", [](const DoubleDouble& x) { return x.sinh(); }, -20.0, 20.0);
+    bench_function("cosh", [](const DoubleDouble& x) { return x.cosh(); }, -20.0, 20.0);
+    bench_function("tanh", [](const DoubleDouble& x) { return x.tanh(); }, -0.25, 0.25);
+    bench_function("tanh", [](const DoubleDouble& x) { return x.tanh(); }, -20.0, 20.0);
+    bench_function("atanh", [](const DoubleDouble& x) { return x.atanh(); }, -0.99, 0.99);
+
+    // The runtime exponent is read from a volatile so that the loop in
+    // powi(int) is not specialized for it.
+    volatile int n2 = 2, n3 = 3, n15 = 15, nm2 = -2;
+    bench_function("powi(2)", [&](const DoubleDouble& x) { return x.powi(n2); }, 0.5, 2.0);
+    bench_function("powi<2>", [](const DoubleDouble& x) { return x.powi<2>(); }, 0.5, 2.0);
+    bench_function("powi(3)", [&](const DoubleDouble& x) { return x.powi(n3); }, 0.5, 2.0);
+    bench_function("powi<3>", [](const DoubleDouble& x) { return x.powi<3>(); }, 0.5, 2.0);
+    bench_function("powi(15)", [&](const DoubleDouble& x) { return x.powi(n15); }, 0.5, 2.0);
+    bench_function("powi<15>", [](const DoubleDouble& x) { return x.powi<15>(); }, 0.5, 2.0);
+    bench_function("powi(-2)", [&](const DoubleDouble& x) { return x.powi(nm2); }, 0.5, 2.0);
+    bench_function("powi<-2>", [](const DoubleDouble& x) { return x.powi<-2>(); }, 0.5, 2.0);
+    const DoubleDoublePowers e(dd_e);
+    bench_function("e**n", [&](const DoubleDouble& x) {
+        return e(int(x.upper)) + x.lower;
+    }, -60.0, 60.0);
+    bench_function("e.powi(n)", [](const DoubleDouble& x) {
+        return dd_e.powi(int(x.upper)) + x.lower;
+    }, -60.0, 60.0);
+}
@@ -0,0 +1,97 @@
+//
+// dd_gemm() and dd_gemv() compared to naive loops over the DoubleDouble
+// operators.
+//
+// Usage: bench_gemm [max_size [naive_max_size [nthreads]]]
+//
+// Square matrices of size 64, 128, ..., max_size (default 1024) are used.
+// The naive triple loop is only timed up to naive_max_size (default 512),
+// because it is very slow for large sizes.  "GFLOP/s" counts one
+// DoubleDouble multiplication and one DoubleDouble addition as 2 flops.
+//
+
+#include <cstdlib>
+#include <vector>
+#include <random>
+#include "doubledouble_linalg.h"
+#include "timing.h"
+
+using namespace doubledouble;
+
+static void naive_gemm(size_t n, const std::vector<DoubleDouble>& A,
+                       const std::vector<DoubleDouble>& B,
+                       std::vector<DoubleDouble>& C)
+{
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            DoubleDouble s{0.0};
+            for (size_t p = 0; p < n; ++p) {
+                s = s + A[i*n + p]*B[p*n + j];
+            }
+            C[i*n + j] = s;
+        }
+    }
+}
+
+static void naive_gemv(size_t n, const std::vector<DoubleDouble>& A,
+                       const std::vector<DoubleDouble>& x,
+                       std::vector<DoubleDouble>& y)
+{
+    for (size_t i = 0; i < n; ++i) {
+        DoubleDouble s{0.0};
+        for (size_t j = 0; j < n; ++j) {
+            s = s + A[i*n + j]*x[j];
+        }
+        y[i] = s;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t max_size = argc > 1 ? std::atol(argv[1]) : 1024;
+    size_t naive_max_size = argc > 2 ? std::atol(argv[2]) : 512;
+    unsigned nthreads = argc > 3 ? std::atoi(argv[3]) : 1;
+
+    std::mt19937_64 gen(12345);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+
+    for (size_t n = 64; n <= max_size; n *= 2) {
+        std::vector<DoubleDouble> A(n*n), B(n*n), C(n*n), x(n), y(n);
+        for (size_t i = 0; i < n*n; ++i) {
+            A[i] = DoubleDouble(u(gen)) / 3.0;
+            B[i] = DoubleDouble(u(gen)) / 7.0;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            x[i] = DoubleDouble(u(gen)) / 3.0;
+        }
+        DoubleDoubleArray As(A), Bs(B), Cs(n*n), xs(x), ys(n);
+        double flops = 2.0*n*n*n;
+        int repeats = n <= 256 ? 5 : 1;
+
+        double ns = best_ns_per_op([&]() {
+            dd_gemm(n, n, n, As, n, Bs, n, Cs, n, nthreads);
+            keep(Cs.upper()[0]);
+        }, 1, repeats);
+        std::printf("dd_gemm  n = %5zu   %8.3f GFLOP/s", n, flops/ns);
+        if (n <= naive_max_size) {
+            double ns_naive = best_ns_per_op([&]() {
+                naive_gemm(n, A, B, C);
+                keep(C[0]);
+            }, 1, repeats);
+            std::printf("   naive %8.3f GFLOP/s   speedup %6.2f",
+                        flops/ns_naive, ns_naive/ns);
+        }
+        std::printf("\n");
+
+        ns = best_ns_per_op([&]() {
+            dd_gemv(n, n, As, n, xs, ys, nthreads);
+            keep(ys.upper()[0]);
+        }, 1);
+        double ns_naive = best_ns_per_op([&]() {
+            naive_gemv(n, A, x, y);
+            keep(y[0]);
+        }, 1);
+        std::printf("dd_gemv  n = %5zu   %8.3f GFLOP/s   naive %8.3f GFLOP/s   speedup %6.2f\n",
+                    n, 2.0*n*n/ns, 2.0*n*n/ns_naive, ns_naive/ns);
+    }
+}
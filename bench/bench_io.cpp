@@ -0,0 +1,82 @@
+//
+// Time per element to reload an array of DoubleDouble and sum it: from a
+// text file written with to_chars, and from the binary files of
+// doubledouble_io.h with both layouts.  The files are in the page cache,
+// so this is the cost of parsing or mapping, not of the disk.
+//
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <random>
+#include "doubledouble_decimal.h"
+#include "doubledouble_io.h"
+#include "timing.h"
+
+using namespace doubledouble;
+
+static const std::size_t n_values = 1000000;
+
+int main()
+{
+    std::mt19937_64 gen(12345);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<DoubleDouble> x(n_values);
+    for (auto& xi : x) {
+        xi = DoubleDouble(u(gen))/3.0;
+    }
+
+    const char *text_path = "bench_io.txt";
+    const char *pairs_path = "bench_io_pairs.dd";
+    const char *planes_path = "bench_io_planes.dd";
+
+    std::FILE *f = std::fopen(text_path, "w");
+    char buf[256];
+    for (const auto& xi : x) {
+        auto r = to_chars(buf, buf + sizeof(buf), xi);
+        *r.ptr++ = '\n';
+        std::fwrite(buf, 1, r.ptr - buf, f);
+    }
+    std::fclose(f);
+    dd_write_file(pairs_path, x, dd_file_layout::pairs);
+    dd_write_file(planes_path, DoubleDoubleArray(x), dd_file_layout::planes);
+
+    double ns = best_ns_per_op([&]() {
+        std::FILE *f = std::fopen(text_path, "r");
+        std::vector<DoubleDouble> y;
+        y.reserve(n_values);
+        char line[256];
+        while (std::fgets(line, sizeof(line), f) != nullptr) {
+            DoubleDouble v;
+            std::string s(line);
+            from_chars(s.data(), s.data() + s.size() - 1, v);
+            y.push_back(v);
+        }
+        std::fclose(f);
+        keep(dsum_dd(y.size(), y.data()));
+    }, n_values, 2);
+    print_result("text, from_chars + dsum", ns);
+
+    ns = best_ns_per_op([&]() {
+        DoubleDoubleFile file;
+        file.open(pairs_path);
+        keep(dsum_dd(file.size(), file.data()));
+    }, n_values);
+    print_result("pairs file + dsum", ns);
+
+    ns = best_ns_per_op([&]() {
+        DoubleDoubleFile file;
+        file.open(planes_path);
+        keep(dsum_dd(file.span()));
+    }, n_values);
+    print_result("planes file + dsum", ns);
+
+    ns = best_ns_per_op([&]() {
+        keep(dsum_dd(x.size(), x.data()));
+    }, n_values);
+    print_result("dsum, in memory", ns);
+
+    std::remove(text_path);
+    std::remove(pairs_path);
+    std::remove(planes_path);
+}
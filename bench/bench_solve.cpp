@@ -0,0 +1,84 @@
+//
+// dd_solve_refine() compared to Gaussian elimination with partial
+// pivoting done entirely in DoubleDouble.
+//
+// Usage: bench_solve [max_size]
+//
+
+#include <cstdlib>
+#include <vector>
+#include <random>
+#include "doubledouble_linalg.h"
+#include "timing.h"
+
+using namespace doubledouble;
+
+static void dd_gauss_solve(size_t n, std::vector<DoubleDouble> A,
+                           std::vector<DoubleDouble>& b)
+{
+    for (size_t k = 0; k < n; ++k) {
+        size_t p = k;
+        for (size_t i = k + 1; i < n; ++i) {
+            if (A[i*n + k].abs() > A[p*n + k].abs()) {
+                p = i;
+            }
+        }
+        for (size_t j = 0; j < n; ++j) {
+            std::swap(A[k*n + j], A[p*n + j]);
+        }
+        std::swap(b[k], b[p]);
+        for (size_t i = k + 1; i < n; ++i) {
+            DoubleDouble l = A[i*n + k] / A[k*n + k];
+            for (size_t j = k + 1; j < n; ++j) {
+                A[i*n + j] -= l*A[k*n + j];
+            }
+            b[i] -= l*b[k];
+        }
+    }
+    for (size_t i = n; i-- > 0; ) {
+        DoubleDouble s = b[i];
+        for (size_t j = i + 1; j < n; ++j) {
+            s -= A[i*n + j]*b[j];
+        }
+        b[i] = s / A[i*n + i];
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t max_size = argc > 1 ? std::atol(argv[1]) : 800;
+    std::mt19937_64 gen(12345);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+
+    for (size_t n = 100; n <= max_size; n *= 2) {
+        std::vector<double> A(n*n), b(n);
+        for (auto& v : A) {
+            v = u(gen);
+        }
+        for (auto& v : b) {
+            v = u(gen);
+        }
+        std::vector<DoubleDouble> x(n);
+        dd_refine_result res{};
+        double ns_refine = best_ns_per_op([&]() {
+            res = dd_solve_refine(n, A.data(), n, b.data(), x.data());
+            keep(x[0]);
+        }, 1, 3);
+
+        std::vector<DoubleDouble> Ad(A.begin(), A.end());
+        std::vector<DoubleDouble> xd;
+        double ns_dd = best_ns_per_op([&]() {
+            xd.assign(b.begin(), b.end());
+            dd_gauss_solve(n, Ad, xd);
+            keep(xd[0]);
+        }, 1, 1);
+
+        double maxdiff = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            maxdiff = std::max(maxdiff, std::fabs((x[i] - xd[i]).upper));
+        }
+        std::printf("n = %4zu   refine %10.3f ms (%d iterations)   "
+                    "DoubleDouble LU %10.3f ms   speedup %6.2f   max |x - x_dd| %.2e\n",
+                    n, ns_refine*1e-6, res.iterations, ns_dd*1e-6, ns_dd/ns_refine, maxdiff);
+    }
+}
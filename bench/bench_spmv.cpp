@@ -0,0 +1,106 @@
+//
+// Throughput of dd_csr_spmv() compared to a loop of two_product() and
+// DoubleDouble addition over each row, and to a plain double CSR SpMV.
+//
+// Usage: bench_spmv [nthreads]
+//
+
+#include <cstdlib>
+#include <vector>
+#include <random>
+#include "doubledouble.h"
+#include "doubledouble_linalg.h"
+#include "timing.h"
+
+using namespace doubledouble;
+
+struct CsrMatrix
+{
+    size_t m;
+    std::vector<int> row_ptr;
+    std::vector<int> col_idx;
+    std::vector<double> values;
+};
+
+//
+// m x n matrix with nnz_per_row nonzeros per row.  Half of the nonzeros
+// are near the diagonal and half are at random columns.
+//
+static CsrMatrix random_csr(size_t m, size_t n, size_t nnz_per_row,
+                            std::mt19937_64& gen)
+{
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::uniform_int_distribution<size_t> col(0, n - 1);
+    CsrMatrix A{m, {0}, {}, {}};
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t p = 0; p < nnz_per_row; ++p) {
+            size_t j = (p % 2 == 0) ? (i*n/m + p) % n : col(gen);
+            A.col_idx.push_back(int(j));
+            A.values.push_back(u(gen));
+        }
+        A.row_ptr.push_back(int(A.col_idx.size()));
+    }
+    return A;
+}
+
+static void serial_dd_spmv(const CsrMatrix& A, const double *x, double *y)
+{
+    for (size_t i = 0; i < A.m; ++i) {
+        DoubleDouble sum{0.0, 0.0};
+        for (int p = A.row_ptr[i]; p < A.row_ptr[i + 1]; ++p) {
+            sum = sum + two_product(A.values[p], x[A.col_idx[p]]);
+        }
+        y[i] = sum.upper;
+    }
+}
+
+static void double_spmv(const CsrMatrix& A, const double *x, double *y)
+{
+    for (size_t i = 0; i < A.m; ++i) {
+        double sum = 0.0;
+        for (int p = A.row_ptr[i]; p < A.row_ptr[i + 1]; ++p) {
+            sum += A.values[p]*x[A.col_idx[p]];
+        }
+        y[i] = sum;
+    }
+}
+
+template <typename Spmv>
+void bench_spmv(const char *name, Spmv spmv, const CsrMatrix& A,
+                const std::vector<double>& x)
+{
+    std::vector<double> y(A.m);
+    size_t nnz = A.values.size();
+    double ns = best_ns_per_op([&]() {
+        spmv(A, x.data(), y.data());
+        keep(y[0]);
+    }, nnz);
+    std::printf("%-16s m = %8zu  nnz/row = %3zu   %7.3f ns/nonzero\n",
+                name, A.m, nnz / A.m, ns);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned nthreads = argc > 1 ? unsigned(std::atoi(argv[1])) : 1;
+    std::mt19937_64 gen(12345);
+    for (size_t m : {size_t(10000), size_t(1000000)}) {
+        for (size_t nnz_per_row : {size_t(5), size_t(27), size_t(100)}) {
+            if (m*nnz_per_row > 30000000) {
+                continue;
+            }
+            CsrMatrix A = random_csr(m, m, nnz_per_row, gen);
+            std::vector<double> x(m);
+            std::uniform_real_distribution<double> u(-1.0, 1.0);
+            for (auto& v : x) {
+                v = u(gen);
+            }
+            bench_spmv("dd_csr_spmv", [&](const CsrMatrix& A, const double *x,
+                                          double *y) {
+                dd_csr_spmv(A.m, A.row_ptr.data(), A.col_idx.data(),
+                            A.values.data(), x, y, nthreads);
+            }, A, x);
+            bench_spmv("serial dd spmv", serial_dd_spmv, A, x);
+            bench_spmv("double spmv", double_spmv, A, x);
+        }
+    }
+}
@@ -0,0 +1,106 @@
+//
+// Latency and throughput of the two accuracy tiers (dd_accurate and
+// dd_fast, see "Accuracy tiers" in doubledouble.h) of add(), sub(),
+// exp(), expm1() and log().  The errors of the tiers are measured by
+// bench_accuracy (add_acc, sub_acc, exp_fast, expm1_fast and log_fast).
+//
+// The loops are those of bench_funcs: "latency" makes each argument
+// depend on the previous result (through an extra multiplication by 0.0
+// and a double addition, whose time is included); "throughput" evaluates
+// the function on an array of independent arguments.
+//
+
+#include <vector>
+#include <random>
+#include "doubledouble.h"
+#include "timing.h"
+
+using namespace doubledouble;
+
+static const std::size_t n_array = 4096;
+static const std::size_t n_pass = 100;
+
+struct timing
+{
+    double latency;
+    double throughput;
+};
+
+template <typename F>
+timing time_function(F f, const std::vector<DoubleDouble>& a)
+{
+    std::vector<DoubleDouble> c(a.size());
+    double latency = best_ns_per_op([&]() {
+        DoubleDouble r{0.0};
+        for (std::size_t k = 0; k < n_pass; ++k) {
+            for (std::size_t i = 0; i < a.size(); ++i) {
+                r = f(a[i] + r.upper*0.0);
+            }
+        }
+        keep(r);
+    }, a.size()*n_pass);
+    double throughput = best_ns_per_op([&]() {
+        for (std::size_t k = 0; k < n_pass; ++k) {
+            for (std::size_t i = 0; i < a.size(); ++i) {
+                c[i] = f(a[i]);
+            }
+            keep(c[0]);
+        }
+    }, a.size()*n_pass);
+    return timing{latency, throughput};
+}
+
+//
+// f(x, tier) is called with tier = dd_accurate and tier = dd_fast.
+//
+template <typename F>
+void bench_tiers(const char *name, F f, double lo, double hi)
+{
+    std::mt19937_64 gen(12345);
+    std::uniform_real_distribution<double> u(lo, hi);
+    std::vector<DoubleDouble> a(n_array);
+    for (auto& x : a) {
+        x = DoubleDouble(u(gen), 0.0) + u(gen)*1e-17;
+    }
+    timing acc = time_function([&](const DoubleDouble& x) {
+        return f(x, dd_accurate);
+    }, a);
+    timing fast = time_function([&](const DoubleDouble& x) {
+        return f(x, dd_fast);
+    }, a);
+    std::printf("%-6s [%6g, %6g]   latency %8.2f %8.2f ns   "
+                "throughput %8.2f %8.2f ns\n",
+                name, lo, hi, acc.latency, fast.latency,
+                acc.throughput, fast.throughput);
+}
+
+int main()
+{
+    std::printf("%-6s %-18s           %8s %8s               %8s %8s\n",
+                "", "", "accurate", "fast", "accurate", "fast");
+    const DoubleDouble y{0.75, 1e-17};
+    bench_tiers("add", [=](const DoubleDouble& x, auto tier) {
+        return x.add(y, tier);
+    }, -2.0, 2.0);
+    bench_tiers("sub", [=](const DoubleDouble& x, auto tier) {
+        return x.sub(y, tier);
+    }, -2.0, 2.0);
+    bench_tiers("exp", [](const DoubleDouble& x, auto tier) {
+        return x.exp(tier);
+    }, -20.0, 20.0);
+    bench_tiers("exp", [](const DoubleDouble& x, auto tier) {
+        return x.exp(tier);
+    }, -700.0, 700.0);
+    bench_tiers("expm1", [](const DoubleDouble& x, auto tier) {
+        return x.expm1(tier);
+    }, -0.5, 0.5);
+    bench_tiers("expm1", [](const DoubleDouble& x, auto tier) {
+        return x.expm1(tier);
+    }, -20.0, 20.0);
+    bench_tiers("log", [](const DoubleDouble& x, auto tier) {
+        return x.log(tier);
+    }, 0.0, 1.0);
+    bench_tiers("log", [](const DoubleDouble& x, auto tier) {
+        return x.log(tier);
+    }, 1.0, 1e300);
+}
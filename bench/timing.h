@@ -0,0 +1,112 @@
+//
+// Minimal timing helpers for the benchmarks in this directory.
+//
+
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+//
+// Prevent the compiler from optimizing away a computed value.
+//
+template <typename T>
+inline void keep(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+//
+// Run `f()` once as a warm-up, then `repeats` more times, and return
+// the best time per operation in nanoseconds.  `ops` is the number of
+// operations performed by one call of `f()`.
+//
+template <typename F>
+double best_ns_per_op(F f, std::size_t ops, int repeats = 5)
+{
+    f();
+    double best = 1e300;
+    for (int k = 0; k < repeats; ++k) {
+        auto t0 = std::chrono::steady_clock::now();
+        f();
+        auto t1 = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+        best = std::min(best, ns / ops);
+    }
+    return best;
+}
+
+inline void print_result(const char *name, double ns_per_op)
+{
+    std::printf("%-28s %9.3f ns/op\n", name, ns_per_op);
+}
+
+//
+// Results collected for a JSON report: one record per benchmark and
+// type, with the latency and the throughput in ns per operation.  A time
+// that was not measured is NaN and is written as null.
+//
+struct bench_record
+{
+    std::string name;
+    std::string type;
+    double latency_ns;
+    double throughput_ns;
+};
+
+inline std::string json_string(const std::string& s)
+{
+    std::string r = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            r += '\\';
+        }
+        r += c;
+    }
+    return r + "\"";
+}
+
+inline std::string json_number(double x)
+{
+    if (std::isnan(x)) {
+        return "null";
+    }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.4f", x);
+    return buf;
+}
+
+//
+// Write the records to `path` as
+//     {"benchmark": ..., "compiler": ..., "results": [{"name": ...,
+//      "type": ..., "latency_ns": ..., "throughput_ns": ...}, ...]}
+// Return false if the file could not be written.
+//
+inline bool write_json(const char *path, const char *benchmark,
+                       const std::vector<bench_record>& records)
+{
+    std::FILE *f = std::fopen(path, "w");
+    if (f == nullptr) {
+        return false;
+    }
+    std::fprintf(f, "{\n  \"benchmark\": %s,\n  \"compiler\": %s,\n  \"results\": [",
+                 json_string(benchmark).c_str(), json_string(__VERSION__).c_str());
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        const bench_record& r = records[i];
+        std::fprintf(f, "%s\n    {\"name\": %s, \"type\": %s, \"latency_ns\": %s, "
+                     "\"throughput_ns\": %s}", i > 0 ? "," : "",
+                     json_string(r.name).c_str(), json_string(r.type).c_str(),
+                     json_number(r.latency_ns).c_str(),
+                     json_number(r.throughput_ns).c_str());
+    }
+    std::fprintf(f, "\n  ]\n}\n");
+    return std::fclose(f) == 0;
+}
+
+#endif
@@ -75,12 +75,370 @@
 #include <cstdlib>
 #include <cmath>
 #include <cfloat>
+#include <cstddef>
 #include <cstdint>
 #include <array>
 #include <vector>
+#include <utility>
+#ifdef DOUBLEDOUBLE_INSTRUMENT
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#endif
 
 namespace doubledouble {
 
+//
+// Constant evaluation.
+//
+// The arithmetic (the operators, the comparisons, dd_fma(), sqr(),
+// recip(), abs(), powi() and the polynomial evaluation) is constexpr, so
+// derived constants and tables can be computed at compile time.  The
+// <cmath> functions are not constexpr in C++17, so the checks for NAN and
+// INF are written as comparisons, and when two_product() is evaluated at
+// compile time it uses Dekker's algorithm instead of fma().  That needs
+// __builtin_is_constant_evaluated() (gcc >= 9, clang >= 9, MSVC >= 19.25);
+// with other compilers dd_is_constant_evaluated() is always false, and
+// two_product() can be constant evaluated only if the compiler folds
+// fma().  Compilers also reject an operation that overflows or creates a
+// NAN (e.g. INF - INF, which two_sum() does for an INF operand) in a
+// constant expression, so arithmetic with nonfinite values generally
+// cannot be done at compile time.
+//
+
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define DOUBLEDOUBLE_HAS_IS_CONSTANT_EVALUATED
+#endif
+#endif
+#if !defined(DOUBLEDOUBLE_HAS_IS_CONSTANT_EVALUATED) \
+    && ((defined(__GNUC__) && __GNUC__ >= 9) \
+        || (defined(_MSC_VER) && _MSC_VER >= 1925))
+#define DOUBLEDOUBLE_HAS_IS_CONSTANT_EVALUATED
+#endif
+
+constexpr bool dd_is_constant_evaluated()
+{
+#ifdef DOUBLEDOUBLE_HAS_IS_CONSTANT_EVALUATED
+    return __builtin_is_constant_evaluated();
+#else
+    return false;
+#endif
+}
+
+//
+// Hardware fused multiply-add.
+//
+// The exact products of two_product() (and of the kernels in the other
+// headers) need x*y - fl(x*y).  fma() computes it in one instruction when
+// the compiler targets a CPU with FMA.  Otherwise (e.g. a baseline x86-64
+// build, without -mfma or -march=haswell) fma() is a call into the math
+// library, which on a CPU without FMA is a software emulation that makes
+// the multiplication and division many times slower.  So fma() is only
+// used when the compiler says that it is fast: __FMA__ (x86 with -mfma or
+// an -march that has FMA), __ARM_FEATURE_FMA (ARMv8 and others),
+// FP_FAST_FMA (from <cmath>), or MSVC with /arch:AVX2.  Otherwise Dekker's
+// product is used (see dd_product_error()).  The macro
+// DOUBLEDOUBLE_USE_FMA forces the use of fma(), and DOUBLEDOUBLE_NO_FMA
+// forces Dekker's product.  All give the same, exact, results.
+//
+// The FMA instruction is the fastest: in bench_arith, a multiplication
+// has about half the throughput cost with -mfma than with Dekker's
+// product.  A baseline build that runs on CPUs with FMA is about 10-30%
+// faster with DOUBLEDOUBLE_USE_FMA, because glibc's fma() then uses the
+// instruction, but it is very slow on CPUs without FMA.  The choice is
+// made at compile time; to run well on both, build the program twice (e.g.
+// with -march=x86-64 and -march=x86-64-v3) and pick the binary at run
+// time.  Function multiversioning does not help here: two_product() must
+// be inlined into every operator, and the macros above are the same in
+// every clone.
+//
+
+#if defined(DOUBLEDOUBLE_NO_FMA)
+inline constexpr bool dd_has_fma = false;
+#elif defined(DOUBLEDOUBLE_USE_FMA) || defined(__FMA__) \
+    || defined(__ARM_FEATURE_FMA) || defined(FP_FAST_FMA) \
+    || (defined(_MSC_VER) && defined(__AVX2__))
+inline constexpr bool dd_has_fma = true;
+#else
+inline constexpr bool dd_has_fma = false;
+#endif
+
+constexpr bool dd_isnan(double x)
+{
+    return x != x;
+}
+
+constexpr bool dd_isinf(double x)
+{
+    return x == INFINITY || x == -INFINITY;
+}
+
+constexpr bool dd_isfinite(double x)
+{
+    if (dd_is_constant_evaluated()) {
+        return -DBL_MAX <= x && x <= DBL_MAX;
+    }
+    // One comparison of |x| instead of two.
+    return std::isfinite(x);
+}
+
+//
+// Instrumentation.
+//
+// If the macro DOUBLEDOUBLE_INSTRUMENT is defined before this header is
+// included, every call of an operator or function increments a counter,
+// and so does each pass through a few special cases: the overflow and
+// underflow returns of exp(), the Taylor series branch of log1p(), the
+// canonicalization of a nonfinite result in the operators
+// (nonfinite_result) and in the constructor DoubleDouble(x, y)
+// (constructor_nonfinite).  The operations done inside the functions are
+// counted too.  The batched kernels of doubledouble_array.h count one
+// operation per element; the lanes of dsum() and ddot() are not counted.
+// Constant evaluation is not counted.
+//
+// Each thread has its own counters, so counting does not synchronize the
+// threads.  dd_counters_thread() returns the counts of the calling
+// thread, dd_counters_total() the sums over all threads (including the
+// threads that have exited), and dd_counters_dump() prints the nonzero
+// counts.  dd_counters_reset() sets the counters of all threads to 0;
+// operations done by other threads while it runs may be lost.
+//
+// Without DOUBLEDOUBLE_INSTRUMENT, DD_COUNT() expands to nothing, and the
+// instrumentation costs nothing.
+//
+
+#ifdef DOUBLEDOUBLE_INSTRUMENT
+
+#define DD_COUNTERS(X) \
+    X(add) X(add_double) X(sub) X(sub_double) X(mul) X(mul_double) \
+    X(div) X(div_double) X(fma) X(sqr) X(recip) X(sqrt) X(powi) \
+    X(powi_squarings) X(exp) X(expm1) X(log) X(log1p) X(sin) X(cos) \
+    X(tan) X(sincos) X(atan) X(asin) X(acos) X(atan2) X(sinh) X(cosh) \
+    X(tanh) X(atanh) X(hypot) \
+    X(exp_overflow) X(exp_underflow) X(log1p_taylor) X(nonfinite_result) \
+    X(constructor_nonfinite)
+
+#define DD_COUNTER_ENUM(name) name,
+enum class dd_counter {
+    DD_COUNTERS(DD_COUNTER_ENUM)
+    n_counters
+};
+#undef DD_COUNTER_ENUM
+
+inline const char *dd_counter_name(dd_counter c)
+{
+#define DD_COUNTER_NAME(name) #name,
+    static const char *names[] = {DD_COUNTERS(DD_COUNTER_NAME)};
+#undef DD_COUNTER_NAME
+    return names[static_cast<int>(c)];
+}
+
+constexpr std::size_t dd_n_counters = static_cast<std::size_t>(dd_counter::n_counters);
+
+struct dd_counts
+{
+    std::uint64_t n[dd_n_counters] = {};
+
+    std::uint64_t operator[](dd_counter c) const
+    {
+        return n[static_cast<std::size_t>(c)];
+    }
+
+    dd_counts& operator+=(const dd_counts& other)
+    {
+        for (std::size_t i = 0; i < dd_n_counters; ++i) {
+            n[i] += other.n[i];
+        }
+        return *this;
+    }
+};
+
+class dd_thread_counters;
+
+struct dd_counter_registry
+{
+    std::mutex mutex;
+    std::vector<dd_thread_counters *> threads;
+    dd_counts exited;
+};
+
+inline dd_counter_registry& dd_counters_registry()
+{
+    static dd_counter_registry registry;
+    return registry;
+}
+
+//
+// The counters of one thread.  Only the owning thread writes them; the
+// atomics (with relaxed loads and stores, which are plain moves) let
+// other threads read them.
+//
+class dd_thread_counters
+{
+    std::atomic<std::uint64_t> n[dd_n_counters];
+
+public:
+
+    dd_thread_counters()
+    {
+        for (auto& a : n) {
+            a.store(0, std::memory_order_relaxed);
+        }
+        dd_counter_registry& r = dd_counters_registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.threads.push_back(this);
+    }
+
+    ~dd_thread_counters()
+    {
+        dd_counter_registry& r = dd_counters_registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.exited += counts();
+        r.threads.erase(std::find(r.threads.begin(), r.threads.end(), this));
+    }
+
+    dd_thread_counters(const dd_thread_counters&) = delete;
+    dd_thread_counters& operator=(const dd_thread_counters&) = delete;
+
+    void add(dd_counter c, std::uint64_t k)
+    {
+        auto& a = n[static_cast<std::size_t>(c)];
+        a.store(a.load(std::memory_order_relaxed) + k, std::memory_order_relaxed);
+    }
+
+    dd_counts counts() const
+    {
+        dd_counts c;
+        for (std::size_t i = 0; i < dd_n_counters; ++i) {
+            c.n[i] = n[i].load(std::memory_order_relaxed);
+        }
+        return c;
+    }
+
+    void reset()
+    {
+        for (auto& a : n) {
+            a.store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+inline dd_thread_counters& dd_this_thread_counters()
+{
+    thread_local dd_thread_counters counters;
+    return counters;
+}
+
+inline void dd_count(dd_counter c, std::uint64_t k = 1)
+{
+    dd_this_thread_counters().add(c, k);
+}
+
+inline dd_counts dd_counters_thread()
+{
+    return dd_this_thread_counters().counts();
+}
+
+inline dd_counts dd_counters_total()
+{
+    dd_counter_registry& r = dd_counters_registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    dd_counts total = r.exited;
+    for (const dd_thread_counters *t : r.threads) {
+        total += t->counts();
+    }
+    return total;
+}
+
+inline void dd_counters_reset()
+{
+    dd_counter_registry& r = dd_counters_registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.exited = dd_counts();
+    for (dd_thread_counters *t : r.threads) {
+        t->reset();
+    }
+}
+
+inline void dd_counters_dump(std::FILE *f, const dd_counts& c)
+{
+    for (std::size_t i = 0; i < dd_n_counters; ++i) {
+        if (c.n[i] != 0) {
+            std::fprintf(f, "%-22s %llu\n", dd_counter_name(static_cast<dd_counter>(i)),
+                         static_cast<unsigned long long>(c.n[i]));
+        }
+    }
+}
+
+inline void dd_counters_dump(std::FILE *f = stderr)
+{
+    dd_counters_dump(f, dd_counters_total());
+}
+
+#define DD_COUNT_N(name, k) \
+    do { \
+        if (!::doubledouble::dd_is_constant_evaluated()) { \
+            ::doubledouble::dd_count(::doubledouble::dd_counter::name, (k)); \
+        } \
+    } while (0)
+
+#else
+
+#define DD_COUNT_N(name, k) ((void) 0)
+
+#endif
+
+#define DD_COUNT(name) DD_COUNT_N(name, 1)
+
+//
+// Tag type for the unchecked constructor DoubleDouble(x, y, dd_unchecked).
+struct dd_unchecked_t {
+    explicit constexpr dd_unchecked_t() = default;
+};
+
+inline constexpr dd_unchecked_t dd_unchecked{};
+
+//
+// Accuracy tiers.
+//
+// add(), sub(), exp(), expm1() and log() have overloads that take one of
+// the tags dd_accurate or dd_fast, so that the same generic code can be
+// instantiated for either tier:
+//
+// * x.add(y, dd_fast) and x.sub(y, dd_fast) are the "sloppy" addition
+//   used by the operators: the error is bounded by about 2**-105*(|x|+|y|),
+//   so the relative error is unbounded when x + y cancels.
+//   x.add(y, dd_accurate) and x.sub(y, dd_accurate) also add the lower
+//   parts with two_sum(); the relative error of the result is less than
+//   3*2**-106 (Joldes, Muller and Popescu, "Tight and rigorous error
+//   bounds for basic building blocks of double-word arithmetic", 2017).
+//   They take up to about twice as long.  If the macro
+//   DOUBLEDOUBLE_ACCURATE_ADD is defined before this header is included,
+//   the operators + and - (and += and -=) for two DoubleDoubles use the
+//   accurate addition (and so do the kernels in doubledouble_array.h).
+//
+// * x.exp(dd_accurate), x.expm1(dd_accurate) and x.log(dd_accurate) are
+//   the same as x.exp(), x.expm1() and x.log(), with a relative error of a
+//   few 2**-105.  The dd_fast versions evaluate polynomials of lower degree
+//   with more of the terms in double precision; their relative error is
+//   less than 2**-86 (about 26 significant digits), and they take about 15%
+//   (exp and log) to 65% (expm1 for |x| <= 1/2) less time.  See
+//   bench/bench_tiers.cpp for the times and bench/bench_accuracy.cpp for
+//   the errors.
+//
+struct dd_accurate_t {
+    explicit constexpr dd_accurate_t() = default;
+};
+
+inline constexpr dd_accurate_t dd_accurate{};
+
+struct dd_fast_t {
+    explicit constexpr dd_fast_t() = default;
+};
+
+inline constexpr dd_fast_t dd_fast{};
+
 class DoubleDouble
 {
 public:
@@ -94,15 +452,19 @@ public:
     constexpr
     DoubleDouble(double x, double y)
     {
-        if (std::isnan(x) || std::isnan(y)) {
+        if (dd_isnan(x) || dd_isnan(y)) {
+            DD_COUNT(constructor_nonfinite);
             upper = NAN;
             lower = NAN;
             return;
         }
         // XXX This canonicalization convention for INFs is experimental
         //     and subject to change.
-        bool xinf = std::isinf(x);
-        bool yinf = std::isinf(y);
+        bool xinf = dd_isinf(x);
+        bool yinf = dd_isinf(y);
+        if (xinf || yinf) {
+            DD_COUNT(constructor_nonfinite);
+        }
         if (xinf && yinf) {
             if (x != y) {
                 // x and y are INFs with opposite signs.  Since the numerical
@@ -137,50 +499,86 @@ public:
     constexpr
     DoubleDouble(double upper) : upper(upper)
     {
-        if (std::isnan(upper)) {
+        if (dd_isnan(upper)) {
             lower = NAN;
         }
     }
 
-    DoubleDouble operator-() const;
-    DoubleDouble operator+(double x) const;
-    DoubleDouble operator+(const DoubleDouble& x) const;
-    DoubleDouble operator-(double x) const;
-    DoubleDouble operator-(const DoubleDouble& x) const;
-    DoubleDouble operator*(double x) const;
-    DoubleDouble operator*(const DoubleDouble& x) const;
-    DoubleDouble operator/(double x) const;
-    DoubleDouble operator/(const DoubleDouble& x) const;
-
-    DoubleDouble& operator+=(double x);
-    DoubleDouble& operator+=(const DoubleDouble& x);
-    DoubleDouble& operator-=(double x);
-    DoubleDouble& operator-=(const DoubleDouble& x);
-    DoubleDouble& operator*=(double x);
-    DoubleDouble& operator*=(const DoubleDouble& x);
-    DoubleDouble& operator/=(double x);
-    DoubleDouble& operator/=(const DoubleDouble& x);
-
-    bool operator==(const DoubleDouble& x) const;
-    bool operator==(double x) const;
-    bool operator!=(const DoubleDouble& x) const;
-    bool operator!=(double x) const;
-    bool operator<(double x) const;
-    bool operator<(const DoubleDouble& x) const;
-    bool operator<=(double x) const;
-    bool operator<=(const DoubleDouble& x) const;
-    bool operator>(double x) const;
-    bool operator>(const DoubleDouble& x) const;
-    bool operator>=(double x) const;
-    bool operator>=(const DoubleDouble& x) const;
-
-    DoubleDouble powi(int n) const;
+    //
+    // Unchecked constructor: upper and lower are stored as given.
+    // The caller is responsible for ensuring that (x, y) is already
+    // normalized, i.e. x == x + y.  No NAN or INF canonicalization is
+    // done.  This is used internally by the error-free transformations
+    // and the arithmetic operators.
+    //
+    constexpr
+    DoubleDouble(double x, double y, dd_unchecked_t) : upper(x), lower(y)
+    {}
+
+    constexpr DoubleDouble operator-() const;
+    constexpr DoubleDouble operator+(double x) const;
+    constexpr DoubleDouble operator+(const DoubleDouble& x) const;
+    constexpr DoubleDouble operator-(double x) const;
+    constexpr DoubleDouble operator-(const DoubleDouble& x) const;
+    constexpr DoubleDouble operator*(double x) const;
+    constexpr DoubleDouble operator*(const DoubleDouble& x) const;
+    constexpr DoubleDouble operator/(double x) const;
+    constexpr DoubleDouble operator/(const DoubleDouble& x) const;
+
+    constexpr DoubleDouble add(const DoubleDouble& x, dd_fast_t) const;
+    constexpr DoubleDouble add(const DoubleDouble& x, dd_accurate_t) const;
+    constexpr DoubleDouble sub(const DoubleDouble& x, dd_fast_t) const;
+    constexpr DoubleDouble sub(const DoubleDouble& x, dd_accurate_t) const;
+
+    constexpr DoubleDouble& operator+=(double x);
+    constexpr DoubleDouble& operator+=(const DoubleDouble& x);
+    constexpr DoubleDouble& operator-=(double x);
+    constexpr DoubleDouble& operator-=(const DoubleDouble& x);
+    constexpr DoubleDouble& operator*=(double x);
+    constexpr DoubleDouble& operator*=(const DoubleDouble& x);
+    constexpr DoubleDouble& operator/=(double x);
+    constexpr DoubleDouble& operator/=(const DoubleDouble& x);
+
+    constexpr bool operator==(const DoubleDouble& x) const;
+    constexpr bool operator==(double x) const;
+    constexpr bool operator!=(const DoubleDouble& x) const;
+    constexpr bool operator!=(double x) const;
+    constexpr bool operator<(double x) const;
+    constexpr bool operator<(const DoubleDouble& x) const;
+    constexpr bool operator<=(double x) const;
+    constexpr bool operator<=(const DoubleDouble& x) const;
+    constexpr bool operator>(double x) const;
+    constexpr bool operator>(const DoubleDouble& x) const;
+    constexpr bool operator>=(double x) const;
+    constexpr bool operator>=(const DoubleDouble& x) const;
+
+    constexpr DoubleDouble powi(int n) const;
+    template <int N> constexpr DoubleDouble powi() const;
     DoubleDouble exp() const;
     DoubleDouble expm1() const;
     DoubleDouble log() const;
+    DoubleDouble exp(dd_fast_t) const;
+    DoubleDouble exp(dd_accurate_t) const;
+    DoubleDouble expm1(dd_fast_t) const;
+    DoubleDouble expm1(dd_accurate_t) const;
+    DoubleDouble log(dd_fast_t) const;
+    DoubleDouble log(dd_accurate_t) const;
     DoubleDouble log1p() const;
+    DoubleDouble sin() const;
+    DoubleDouble cos() const;
+    DoubleDouble tan() const;
+    void sincos(DoubleDouble& s, DoubleDouble& c) const;
+    DoubleDouble atan() const;
+    DoubleDouble asin() const;
+    DoubleDouble acos() const;
+    DoubleDouble sinh() const;
+    DoubleDouble cosh() const;
+    DoubleDouble tanh() const;
+    DoubleDouble atanh() const;
     DoubleDouble sqrt() const;
-    DoubleDouble abs() const;
+    constexpr DoubleDouble abs() const;
+    constexpr DoubleDouble sqr() const;
+    constexpr DoubleDouble recip() const;
 };
 
 //
@@ -188,202 +586,317 @@ public:
 //
 
 // 0
-inline const DoubleDouble dd_zero{0.0, 0.0};
+inline constexpr DoubleDouble dd_zero{0.0, 0.0};
 // 1
-inline const DoubleDouble dd_one{1.0, 0.0};
+inline constexpr DoubleDouble dd_one{1.0, 0.0};
 // sqrt(2)
-inline const DoubleDouble dd_sqrt2{1.4142135623730951, -9.667293313452913e-17};
+inline constexpr DoubleDouble dd_sqrt2{1.4142135623730951, -9.667293313452913e-17};
 // sqrt(1/2)
-inline const DoubleDouble dd_sqrt1_2{0.7071067811865476, -4.833646656726457e-17};
+inline constexpr DoubleDouble dd_sqrt1_2{0.7071067811865476, -4.833646656726457e-17};
 // e
-inline const DoubleDouble dd_e{2.7182818284590452, 1.44564689172925013472e-16};
+inline constexpr DoubleDouble dd_e{2.7182818284590452, 1.44564689172925013472e-16};
 // ln(2)
-inline const DoubleDouble dd_ln2{0.6931471805599453, 2.3190468138462996e-17};
+inline constexpr DoubleDouble dd_ln2{0.6931471805599453, 2.3190468138462996e-17};
 // pi
-inline const DoubleDouble dd_pi{3.1415926535897932, 1.22464679914735317636e-16};
+inline constexpr DoubleDouble dd_pi{3.1415926535897932, 1.22464679914735317636e-16};
 // pi/2
-inline const DoubleDouble dd_pi_2{1.5707963267948966, 6.123233995736766e-17};
+inline constexpr DoubleDouble dd_pi_2{1.5707963267948966, 6.123233995736766e-17};
 // 1/pi
-inline const DoubleDouble dd_1_pi{0.3183098861837907, -1.9678676675182486e-17};
+inline constexpr DoubleDouble dd_1_pi{0.3183098861837907, -1.9678676675182486e-17};
 // 1/sqrt(pi)
-inline const DoubleDouble dd_1_sqrtpi{0.5641895835477563,7.66772980658294e-18};
+inline constexpr DoubleDouble dd_1_sqrtpi{0.5641895835477563,7.66772980658294e-18};
 // 2/sqrt(pi)
-inline const DoubleDouble dd_2_sqrtpi{1.1283791670955126, 1.533545961316588e-17};
+inline constexpr DoubleDouble dd_2_sqrtpi{1.1283791670955126, 1.533545961316588e-17};
 // sqrt(pi/2)
-inline const DoubleDouble dd_sqrt_pi_2{1.2533141373155003, -9.164289990229583e-17};
+inline constexpr DoubleDouble dd_sqrt_pi_2{1.2533141373155003, -9.164289990229583e-17};
 // sqrt(2/pi)
-inline const DoubleDouble dd_sqrt_2_pi{0.7978845608028654, -4.98465440455546e-17};
+inline constexpr DoubleDouble dd_sqrt_2_pi{0.7978845608028654, -4.98465440455546e-17};
 // inf
-inline const DoubleDouble dd_inf{INFINITY, 0.0};
+inline constexpr DoubleDouble dd_inf{INFINITY, 0.0};
 
 
-inline DoubleDouble two_sum_quick(double x, double y)
+//
+// Handling of nonfinite values.
+//
+// The error-free transformations two_sum(), two_difference() and
+// two_product() return their results unchecked.  If an input is NAN or
+// INF (or the result overflows), the lower part of the result is not
+// meaningful.
+//
+// two_sum_quick() is the last step of every arithmetic operator.  By
+// default, when the upper part of its result is not finite, the result
+// is canonicalized in the same way as by the constructor
+// DoubleDouble(x, y) (e.g. NAN is always stored as (NAN, NAN)).  That
+// costs one well-predicted branch per operation.  If the macro
+// DOUBLEDOUBLE_IGNORE_NONFINITE is defined before this header is
+// included, the check is skipped, and the lower part of a nonfinite
+// result is unspecified.
+//
+
+constexpr DoubleDouble two_sum_quick(double x, double y)
 {
     double r = x + y;
     double e = y - (r - x);
-    return DoubleDouble(r, e);
+#ifndef DOUBLEDOUBLE_IGNORE_NONFINITE
+    if (!dd_isfinite(r)) {
+        DD_COUNT(nonfinite_result);
+        return DoubleDouble(r, e);
+    }
+#endif
+    return DoubleDouble(r, e, dd_unchecked);
 }
 
 
-inline DoubleDouble two_sum(double x, double y)
+constexpr DoubleDouble two_sum(double x, double y)
 {
     double r = x + y;
     double t = r - x;
     double e = (x - (r - t)) + (y - t);
-    return DoubleDouble(r, e);
+    return DoubleDouble(r, e, dd_unchecked);
 }
 
 
-inline DoubleDouble two_difference(double x, double y)
+constexpr DoubleDouble two_difference(double x, double y)
 {
     double r = x - y;
     double t = r - x;
     double e = (x - (r - t)) - (y + t);
-    return DoubleDouble(r, e);
+    return DoubleDouble(r, e, dd_unchecked);
+}
+
+
+//
+// Veltkamp's splitting: x = hi + lo, where hi and lo have at most 26
+// significant bits each.  x*134217729 must not overflow.
+//
+constexpr void dd_split(double x, double& hi, double& lo)
+{
+    double t = 134217729.0*x;
+    hi = t - (t - x);
+    lo = x - hi;
 }
 
+//
+// dd_product_error(x, y, r) returns x*y - r, where r = x*y rounded to
+// double; the result is exact (unless x*y overflows or is subnormal).
+// With hardware FMA (dd_has_fma, see above) it is fma(x, y, -r).
+// Otherwise it is Dekker's product, with x and y split by dd_split(): the
+// partial products of the halves are exact, and so are the sums.  An
+// operand with magnitude greater than 2**995 (and x, when |r| > 2**1000)
+// is scaled by 2**-28 first, so that neither the splitting nor xh*yh
+// overflows; the scaling is done with selects, so loops that call this
+// can still be vectorized.  Dekker's product is also used in constant
+// evaluation.
+//
+constexpr double dd_product_error(double x, double y, double r)
+{
+    if (dd_has_fma && !dd_is_constant_evaluated()) {
+        return fma(x, y, -r);
+    }
+    const double big = 3.3484643974570854e+299;  // 2**995
+    bool xbig = x > big || x < -big
+                || r > 1.0715086071862673e+301 || r < -1.0715086071862673e+301;
+    bool ybig = y > big || y < -big;
+    double xs = xbig ? x*3.725290298461914e-09 : x;
+    double ys = ybig ? y*3.725290298461914e-09 : y;
+    double rs = r*((xbig ? 3.725290298461914e-09 : 1.0)
+                   *(ybig ? 3.725290298461914e-09 : 1.0));
+    double xh = 0.0, xl = 0.0, yh = 0.0, yl = 0.0;
+    dd_split(xs, xh, xl);
+    dd_split(ys, yh, yl);
+    double e = ((xh*yh - rs) + xh*yl + xl*yh) + xl*yl;
+    return e*((xbig ? 268435456.0 : 1.0)*(ybig ? 268435456.0 : 1.0));
+}
 
-inline DoubleDouble two_product(double x, double y)
+constexpr DoubleDouble two_product(double x, double y)
 {
     double r = x*y;
-    double e = fma(x, y, -r);
-    return DoubleDouble(r, e);
+    return DoubleDouble(r, dd_product_error(x, y, r), dd_unchecked);
 }
 
 
-inline DoubleDouble DoubleDouble::operator-() const
+constexpr DoubleDouble DoubleDouble::operator-() const
 {
-    return DoubleDouble(-upper, -lower);
+    return DoubleDouble(-upper, -lower, dd_unchecked);
 }
 
-inline DoubleDouble DoubleDouble::operator+(double x) const
+constexpr DoubleDouble DoubleDouble::operator+(double x) const
 {
+    DD_COUNT(add_double);
     DoubleDouble re = two_sum(upper, x);
     re.lower += lower;
     return two_sum_quick(re.upper, re.lower);
 }
 
-inline DoubleDouble operator+(double x, const DoubleDouble& y)
+constexpr DoubleDouble operator+(double x, const DoubleDouble& y)
 {
     return y + x;
 }
 
-inline DoubleDouble DoubleDouble::operator+(const DoubleDouble& x) const
+constexpr DoubleDouble DoubleDouble::add(const DoubleDouble& x, dd_fast_t) const
 {
+    DD_COUNT(add);
     DoubleDouble re = two_sum(upper, x.upper);
     re.lower += lower + x.lower;
     return two_sum_quick(re.upper, re.lower);
 }
 
-inline DoubleDouble DoubleDouble::operator-(double x) const
+constexpr DoubleDouble DoubleDouble::add(const DoubleDouble& x, dd_accurate_t) const
 {
+    DD_COUNT(add);
+    DoubleDouble s = two_sum(upper, x.upper);
+    DoubleDouble t = two_sum(lower, x.lower);
+    s.lower += t.upper;
+    double r = s.upper + s.lower;
+    double e = s.lower - (r - s.upper);
+    return two_sum_quick(r, e + t.lower);
+}
+
+constexpr DoubleDouble DoubleDouble::operator+(const DoubleDouble& x) const
+{
+#ifdef DOUBLEDOUBLE_ACCURATE_ADD
+    return add(x, dd_accurate);
+#else
+    return add(x, dd_fast);
+#endif
+}
+
+constexpr DoubleDouble DoubleDouble::operator-(double x) const
+{
+    DD_COUNT(sub_double);
     DoubleDouble re = two_difference(upper, x);
     re.lower += lower;
     return two_sum_quick(re.upper, re.lower);
 }
 
-inline DoubleDouble operator-(double x, const DoubleDouble& y)
+constexpr DoubleDouble operator-(double x, const DoubleDouble& y)
 {
     return -y + x;
 }
 
-inline DoubleDouble DoubleDouble::operator-(const DoubleDouble& x) const
+constexpr DoubleDouble DoubleDouble::sub(const DoubleDouble& x, dd_fast_t) const
 {
+    DD_COUNT(sub);
     DoubleDouble re = two_difference(upper, x.upper);
     re.lower += lower - x.lower;
     return two_sum_quick(re.upper, re.lower);
 }
 
-inline DoubleDouble DoubleDouble::operator*(double x) const
+constexpr DoubleDouble DoubleDouble::sub(const DoubleDouble& x, dd_accurate_t) const
+{
+    DD_COUNT(sub);
+    DoubleDouble s = two_difference(upper, x.upper);
+    DoubleDouble t = two_difference(lower, x.lower);
+    s.lower += t.upper;
+    double r = s.upper + s.lower;
+    double e = s.lower - (r - s.upper);
+    return two_sum_quick(r, e + t.lower);
+}
+
+constexpr DoubleDouble DoubleDouble::operator-(const DoubleDouble& x) const
+{
+#ifdef DOUBLEDOUBLE_ACCURATE_ADD
+    return sub(x, dd_accurate);
+#else
+    return sub(x, dd_fast);
+#endif
+}
+
+constexpr DoubleDouble DoubleDouble::operator*(double x) const
 {
+    DD_COUNT(mul_double);
     DoubleDouble re = two_product(upper, x);
     re.lower += lower * x;
     return two_sum_quick(re.upper, re.lower);
 }
 
-inline DoubleDouble operator*(double x, const DoubleDouble& y)
+constexpr DoubleDouble operator*(double x, const DoubleDouble& y)
 {
     return y * x;
 }
 
-inline DoubleDouble DoubleDouble::operator*(const DoubleDouble& x) const
+constexpr DoubleDouble DoubleDouble::operator*(const DoubleDouble& x) const
 {
+    DD_COUNT(mul);
     DoubleDouble re = two_product(upper, x.upper);
     re.lower += upper*x.lower + lower*x.upper;
     return two_sum_quick(re.upper, re.lower);
 }
 
-inline DoubleDouble DoubleDouble::operator/(double x) const
+constexpr DoubleDouble DoubleDouble::operator/(double x) const
 {
+    DD_COUNT(div_double);
     double r = upper/x;
     DoubleDouble sf = two_product(r, x);
     double e = (upper - sf.upper - sf.lower + lower)/x;
     return two_sum_quick(r, e);
 }
 
-inline DoubleDouble operator/(double x, const DoubleDouble& y)
+constexpr DoubleDouble operator/(double x, const DoubleDouble& y)
 {
     return DoubleDouble(x) / y;
 }
 
-inline DoubleDouble DoubleDouble::operator/(const DoubleDouble& x) const
+constexpr DoubleDouble DoubleDouble::operator/(const DoubleDouble& x) const
 {
+    DD_COUNT(div);
     double r = upper/x.upper;
     DoubleDouble sf = two_product(r, x.upper);
     double e = (upper - sf.upper - sf.lower + lower - r*x.lower)/x.upper;
     return two_sum_quick(r, e);
 }
 
-inline DoubleDouble& DoubleDouble::operator+=(double x)
+constexpr DoubleDouble& DoubleDouble::operator+=(double x)
 {
+    DD_COUNT(add_double);
     DoubleDouble re = two_sum(upper, x);
     re.lower += lower;
     *this = two_sum_quick(re.upper, re.lower);
     return *this;
 }
 
-inline DoubleDouble& DoubleDouble::operator+=(const DoubleDouble& x)
+constexpr DoubleDouble& DoubleDouble::operator+=(const DoubleDouble& x)
 {
-    DoubleDouble re = two_sum(upper, x.upper);
-    re.lower += lower + x.lower;
-    *this = two_sum_quick(re.upper, re.lower);
+    *this = *this + x;
     return *this;
 }
 
-inline DoubleDouble& DoubleDouble::operator-=(double x)
+constexpr DoubleDouble& DoubleDouble::operator-=(double x)
 {
+    DD_COUNT(sub_double);
     DoubleDouble re = two_difference(upper, x);
     re.lower += lower;
     *this = two_sum_quick(re.upper, re.lower);
     return *this;
 }
 
-inline DoubleDouble& DoubleDouble::operator-=(const DoubleDouble& x)
+constexpr DoubleDouble& DoubleDouble::operator-=(const DoubleDouble& x)
 {
-    DoubleDouble re = two_difference(upper, x.upper);
-    re.lower += lower - x.lower;
-    *this = two_sum_quick(re.upper, re.lower);
+    *this = *this - x;
     return *this;
 }
 
-inline DoubleDouble& DoubleDouble::operator*=(double x)
+constexpr DoubleDouble& DoubleDouble::operator*=(double x)
 {
+    DD_COUNT(mul_double);
     DoubleDouble re = two_product(upper, x);
     re.lower += lower * x;
     *this = two_sum_quick(re.upper, re.lower);
     return *this;
 }
 
-inline DoubleDouble& DoubleDouble::operator*=(const DoubleDouble& x)
+constexpr DoubleDouble& DoubleDouble::operator*=(const DoubleDouble& x)
 {
+    DD_COUNT(mul);
     DoubleDouble re = two_product(upper, x.upper);
     re.lower += upper*x.lower + lower*x.upper;
     *this = two_sum_quick(re.upper, re.lower);
     return *this;
 }
 
-inline DoubleDouble& DoubleDouble::operator/=(double x)
+constexpr DoubleDouble& DoubleDouble::operator/=(double x)
 {
+    DD_COUNT(div_double);
     double r = upper/x;
     DoubleDouble sf = two_product(r, x);
     double e = (upper - sf.upper - sf.lower + lower)/x;
@@ -391,8 +904,9 @@ inline DoubleDouble& DoubleDouble::operator/=(double x)
     return *this;
 }
 
-inline DoubleDouble& DoubleDouble::operator/=(const DoubleDouble& x)
+constexpr DoubleDouble& DoubleDouble::operator/=(const DoubleDouble& x)
 {
+    DD_COUNT(div);
     double r = upper/x.upper;
     DoubleDouble sf = two_product(r, x.upper);
     double e = (upper - sf.upper - sf.lower + lower - r*x.lower)/x.upper;
@@ -400,111 +914,270 @@ inline DoubleDouble& DoubleDouble::operator/=(const DoubleDouble& x)
     return *this;
 }
 
-inline bool DoubleDouble::operator==(const DoubleDouble& x) const
+constexpr bool DoubleDouble::operator==(const DoubleDouble& x) const
 {
     // XXX Do the (upper, lower) representations need to be canonicalized first?
     return (upper == x.upper) && (lower == x.lower);
 }
 
-inline bool DoubleDouble::operator==(double x) const
+constexpr bool DoubleDouble::operator==(double x) const
 {
     // XXX Do the (upper, lower) representations need to be canonicalized first?
     return (upper == x) && (lower == 0.0);
 }
 
-inline bool operator==(double x, const DoubleDouble& y)
+constexpr bool operator==(double x, const DoubleDouble& y)
 {
     return y == x;
 }
 
-inline bool DoubleDouble::operator!=(const DoubleDouble& x) const
+constexpr bool DoubleDouble::operator!=(const DoubleDouble& x) const
 {
     // XXX Do the (upper, lower) representations need to be canonicalized first?
     return (upper != x.upper) || (lower != x.lower);
 }
 
-inline bool DoubleDouble::operator!=(double x) const
+constexpr bool DoubleDouble::operator!=(double x) const
 {
     // XXX Do the (upper, lower) representations need to be canonicalized first?
     return (upper != x) || (lower != 0.0);
 }
 
-inline bool operator!=(double x, const DoubleDouble& y)
+constexpr bool operator!=(double x, const DoubleDouble& y)
 {
     return y != x;
 }
 
-inline bool DoubleDouble::operator<(const DoubleDouble& x) const
+constexpr bool DoubleDouble::operator<(const DoubleDouble& x) const
 {
     // XXX Do the (upper, lower) representations need to be canonicalized first?
     return (upper < x.upper) || ((upper == x.upper) && (lower < x.lower));
 }
 
-inline bool DoubleDouble::operator<(double x) const
+constexpr bool DoubleDouble::operator<(double x) const
 {
     // XXX Do the (upper, lower) representations need to be canonicalized first?
     return (upper < x) || ((upper == x) && (lower < 0.0));
 }
 
-inline bool operator<(double x, const DoubleDouble& y)
+constexpr bool operator<(double x, const DoubleDouble& y)
 {
     return y >= x;
 }
 
-inline bool DoubleDouble::operator<=(const DoubleDouble& x) const
+constexpr bool DoubleDouble::operator<=(const DoubleDouble& x) const
 {
     // XXX Do the (upper, lower) representations need to be canonicalized first?
     return (upper < x.upper) || ((upper == x.upper) && (lower <= x.lower));
 }
 
-inline bool DoubleDouble::operator<=(double x) const
+constexpr bool DoubleDouble::operator<=(double x) const
 {
     // XXX Do the (upper, lower) representations need to be canonicalized first?
     return (upper < x) || ((upper == x) && (lower <= 0.0));
 }
 
-inline bool operator<=(double x, const DoubleDouble& y)
+constexpr bool operator<=(double x, const DoubleDouble& y)
 {
     return y >= x;
 }
 
-inline bool DoubleDouble::operator>(const DoubleDouble& x) const
+constexpr bool DoubleDouble::operator>(const DoubleDouble& x) const
 {
     // XXX Do the (upper, lower) representations need to be canonicalized first?
     return (upper > x.upper) || ((upper == x.upper) && (lower > x.lower));
 }
 
-inline bool DoubleDouble::operator>(double x) const
+constexpr bool DoubleDouble::operator>(double x) const
 {
     // XXX Do the (upper, lower) representations need to be canonicalized first?
     return (upper > x) || ((upper == x) && (lower > 0.0));
 }
 
-inline bool operator>(double x, const DoubleDouble& y)
+constexpr bool operator>(double x, const DoubleDouble& y)
 {
     return y <= x;
 }
 
-inline bool DoubleDouble::operator>=(const DoubleDouble& x) const
+constexpr bool DoubleDouble::operator>=(const DoubleDouble& x) const
 {
     // XXX Do the (upper, lower) representations need to be canonicalized first?
     return (upper > x.upper) || ((upper == x.upper) && (lower >= x.lower));
 }
 
-inline bool DoubleDouble::operator>=(double x) const
+constexpr bool DoubleDouble::operator>=(double x) const
 {
     // XXX Do the (upper, lower) representations need to be canonicalized first?
     return (upper > x) || ((upper == x) && (lower >= 0.0));
 }
 
-inline bool operator>=(double x, const DoubleDouble& y)
+constexpr bool operator>=(double x, const DoubleDouble& y)
 {
     return y <= x;
 }
 
-inline DoubleDouble DoubleDouble::powi(int n) const
+//
+// Fused operations.
+//
+// dd_fma(a, b, c) computes a*b + c, sqr() computes x*x and recip()
+// computes 1/x.  Each does the error-free transformations of the
+// separate operations and renormalizes only once at the end, so
+// dd_fma(a, b, c) is cheaper than a*b + c (and has about the same
+// error).  recip() uses the exact residual 1 - r*x.upper (computed with
+// fma() when the hardware has it) and a multiplication by r instead of a
+// second division.
+//
+
+constexpr DoubleDouble dd_fma(const DoubleDouble& a, const DoubleDouble& b,
+                              const DoubleDouble& c)
+{
+    DD_COUNT(fma);
+    DoubleDouble p = two_product(a.upper, b.upper);
+    p.lower += a.upper*b.lower + a.lower*b.upper;
+    DoubleDouble s = two_sum(p.upper, c.upper);
+    s.lower += p.lower + c.lower;
+    return two_sum_quick(s.upper, s.lower);
+}
+
+constexpr DoubleDouble dd_fma(const DoubleDouble& a, const DoubleDouble& b,
+                              double c)
+{
+    DD_COUNT(fma);
+    DoubleDouble p = two_product(a.upper, b.upper);
+    p.lower += a.upper*b.lower + a.lower*b.upper;
+    DoubleDouble s = two_sum(p.upper, c);
+    s.lower += p.lower;
+    return two_sum_quick(s.upper, s.lower);
+}
+
+constexpr DoubleDouble DoubleDouble::sqr() const
+{
+    DD_COUNT(sqr);
+    DoubleDouble p = two_product(upper, upper);
+    p.lower += 2*upper*lower;
+    return two_sum_quick(p.upper, p.lower);
+}
+
+constexpr DoubleDouble DoubleDouble::recip() const
+{
+    DD_COUNT(recip);
+    double r = 1.0/upper;
+    double d = 0.0;
+    if (dd_has_fma && !dd_is_constant_evaluated()) {
+        d = -fma(r, upper, -1.0);
+    }
+    else {
+        // Both terms are exact.
+        DoubleDouble p = two_product(r, upper);
+        d = (1.0 - p.upper) - p.lower;
+    }
+    double e = r*(d - r*lower);
+    return two_sum_quick(r, e);
+}
+
+//
+// Polynomial evaluation.
+//
+// dd_polyval<Scheme>(c, x) returns c[0] + c[1]*x + ... + c[N-1]*x**(N-1).
+// The coefficients may be double or DoubleDouble.  The scheme is one of
+//
+//   dd_poly_scheme::horner   Horner's rule.  N-1 dependent multiply-adds.
+//   dd_poly_scheme::horner2  Second-order Horner: the even and odd parts
+//                            are evaluated in x**2 with Horner's rule, as
+//                            two independent chains, and then combined.
+//   dd_poly_scheme::estrin   Estrin's scheme: pairs of terms are combined
+//                            with powers x**2, x**4, ..., so the longest
+//                            chain has about log2(N) multiply-adds.
+//
+// The schemes with shorter dependency chains do a few more operations
+// (the powers of x), but the independent operations overlap in the
+// pipeline, so they usually have lower latency.  They can also round
+// differently; all three are accurate for polynomials with terms that
+// decrease in magnitude, which is the usual case for an approximation
+// on a reduced interval.
+//
+// dd_ratval<Scheme>(p, q, x) returns dd_polyval(p, x)/dd_polyval(q, x).
+//
+
+enum class dd_poly_scheme {
+    horner,
+    horner2,
+    estrin
+};
+
+//
+// Horner's rule for c[0] + c[stride]*x + ... + c[(n-1)*stride]*x**(n-1).
+//
+template <typename Coeff>
+constexpr DoubleDouble dd_horner(const Coeff *c, std::size_t n,
+                                 std::size_t stride, const DoubleDouble& x)
+{
+    DoubleDouble r(c[(n - 1)*stride]);
+    for (std::size_t k = n - 1; k-- > 0;) {
+        r = dd_fma(r, x, c[k*stride]);
+    }
+    return r;
+}
+
+template <typename Coeff, std::size_t N>
+constexpr DoubleDouble dd_estrin(const std::array<Coeff, N>& c,
+                                 const DoubleDouble& x)
+{
+    std::array<DoubleDouble, (N + 1)/2> t;
+    for (std::size_t k = 0; k < N/2; ++k) {
+        t[k] = dd_fma(x, DoubleDouble(c[2*k + 1]), c[2*k]);
+    }
+    if (N % 2 == 1) {
+        t[N/2] = DoubleDouble(c[N - 1]);
+    }
+    DoubleDouble p = x.sqr();
+    for (std::size_t m = (N + 1)/2; m > 1; m = (m + 1)/2) {
+        for (std::size_t k = 0; k < m/2; ++k) {
+            t[k] = dd_fma(t[2*k + 1], p, t[2*k]);
+        }
+        if (m % 2 == 1) {
+            t[m/2] = t[m - 1];
+        }
+        if (m > 2) {
+            p = p.sqr();
+        }
+    }
+    return t[0];
+}
+
+template <dd_poly_scheme Scheme = dd_poly_scheme::estrin,
+          typename Coeff, std::size_t N>
+constexpr DoubleDouble dd_polyval(const std::array<Coeff, N>& c,
+                                  const DoubleDouble& x)
+{
+    static_assert(N > 0, "a polynomial must have at least one coefficient");
+    if constexpr (Scheme == dd_poly_scheme::horner || N < 3) {
+        return dd_horner(c.data(), N, 1, x);
+    }
+    else if constexpr (Scheme == dd_poly_scheme::horner2) {
+        DoubleDouble x2 = x.sqr();
+        DoubleDouble even = dd_horner(c.data(), (N + 1)/2, 2, x2);
+        DoubleDouble odd = dd_horner(c.data() + 1, N/2, 2, x2);
+        return dd_fma(odd, x, even);
+    }
+    else {
+        return dd_estrin(c, x);
+    }
+}
+
+template <dd_poly_scheme Scheme = dd_poly_scheme::estrin,
+          typename Coeff1, std::size_t N1, typename Coeff2, std::size_t N2>
+constexpr DoubleDouble dd_ratval(const std::array<Coeff1, N1>& p,
+                                 const std::array<Coeff2, N2>& q,
+                                 const DoubleDouble& x)
 {
-    int i = std::abs(n);
+    return dd_polyval<Scheme>(p, x) / dd_polyval<Scheme>(q, x);
+}
+
+constexpr DoubleDouble DoubleDouble::powi(int n) const
+{
+    DD_COUNT(powi);
+    int i = n < 0 ? -n : n;
     DoubleDouble b = *this;
     DoubleDouble r(1);
     while (1) {
@@ -515,85 +1188,594 @@ inline DoubleDouble DoubleDouble::powi(int n) const
             break;
         }
         i >>= 1;
-        b = b*b;
+        b = b.sqr();
+        DD_COUNT(powi_squarings);
     }
     if (n < 0) {
-        return dd_one / r;
+        return r.recip();
     }
     return r;
 }
 
+//
+// powi<N>() computes x**N with the multiplications of an addition chain
+// for N that is chosen at compile time.  For N <= 128 the chain is a
+// shortest one (found by a search over star chains, which are optimal
+// for all N < 12509); e.g. x**15 takes 5 multiplications instead of the
+// 6 of the binary method used by powi(n).  Larger N use the binary
+// method, unrolled.  A step that doubles the exponent uses sqr().  For
+// N < 0, the result is powi<-N>().recip().
+//
 
-inline DoubleDouble DoubleDouble::exp() const
+struct dd_addition_chain
 {
-    if (upper > 709.782712893384) {
-        return dd_inf;
-    }
-    int n = int(round(upper));
-    DoubleDouble x(upper - n, lower);
-    DoubleDouble u = (((((((((((x +
-                     156)*x + 12012)*x +
-                     600600)*x + 21621600)*x +
-                     588107520)*x + 12350257920)*x +
-                     201132771840)*x + 2514159648000)*x +
-                     23465490048000)*x + 154872234316800)*x +
-                     647647525324800)*x + 1295295050649600;
-    DoubleDouble v = (((((((((((x -
-                     156)*x + 12012)*x -
-                     600600)*x + 21621600)*x -
-                     588107520)*x + 12350257920)*x -
-                     201132771840)*x + 2514159648000)*x -
-                     23465490048000)*x + 154872234316800)*x -
-                     647647525324800)*x + 1295295050649600;
-    return dd_e.powi(n) * (u / v);
-}
+    // value[0] = 1, value[length] = n, and
+    // value[i] = value[i - 1] + value[other[i]] for i = 1, ..., length.
+    int length = 0;
+    int value[12] = {1};
+    int other[12] = {};
+};
 
-inline DoubleDouble DoubleDouble::sqrt() const
+constexpr bool dd_star_chain_search(dd_addition_chain& c, int i, int limit,
+                                    int n)
 {
-    if (upper == 0 && lower == 0) {
-        return dd_zero;
+    int last = c.value[i - 1];
+    if (last == n) {
+        c.length = i - 1;
+        return true;
     }
-    double r = std::sqrt(upper);
-    DoubleDouble sf = two_product(r, r);
-    double e = (upper - sf.upper - sf.lower + lower) * 0.5 / r;
-    return two_sum_quick(r, e);
+    if (i > limit) {
+        return false;
+    }
+    int reach = last;
+    for (int k = i; k <= limit; ++k) {
+        reach *= 2;
+    }
+    if (reach < n) {
+        return false;
+    }
+    for (int j = i - 1; j >= 0; --j) {
+        int v = last + c.value[j];
+        if (v <= n) {
+            c.value[i] = v;
+            c.other[i] = j;
+            if (dd_star_chain_search(c, i + 1, limit, n)) {
+                return true;
+            }
+        }
+    }
+    return false;
 }
 
-// XXX See the various relative tolerances in the unit tests
-// for cases where it would be nice to get a more accurate
-// result.
-inline DoubleDouble DoubleDouble::log() const
+constexpr dd_addition_chain dd_shortest_chain(int n)
 {
-    DoubleDouble r(std::log(upper));
-    DoubleDouble u = r.exp();
-    r = r - DoubleDouble(2.0)*(u - *this)/(u + *this);
-    return r;
+    dd_addition_chain c;
+    int limit = 0;
+    while (!dd_star_chain_search(c, 1, limit, n)) {
+        ++limit;
+    }
+    return c;
 }
 
-// inline DoubleDouble DoubleDouble::log1p() const
-// {
-//     DoubleDouble u = *this + 1.0;
-//     if (u == 0.0) {
-//         return *this;
-//     }
-//     return u.log()*(*this)/(u - 1.0);
-// }
+template <int N>
+struct dd_powi_chain
+{
+    static constexpr dd_addition_chain chain = dd_shortest_chain(N);
+};
 
-//
-// This needs a second look.  See the various relative tolerances
-// in the unit tests for cases where I think it should do better.
-//
-inline DoubleDouble DoubleDouble::log1p() const
+template <int N, int... I>
+constexpr DoubleDouble dd_powi_chain_eval(const DoubleDouble& x,
+                                          std::integer_sequence<int, I...>)
 {
-    if ((*this).abs() < 1e-5) {
-        // Taylor polynomial:
-        return (*this)*(1.0 + (*this)*(-0.5 + (*this)*(1.0/DoubleDouble(3.0) + (*this)*(-0.25 + (*this)*(1.0/DoubleDouble(5.0) - (*this)/6.0)))));
-    }
-    DoubleDouble xp1 = (*this) + 1.0;
-    return xp1.log();
+    constexpr const dd_addition_chain& c = dd_powi_chain<N>::chain;
+    DoubleDouble p[sizeof...(I) + 1];
+    p[0] = x;
+    ((p[I + 1] = (c.other[I + 1] == I) ? p[I].sqr() : p[I]*p[c.other[I + 1]]),
+     ...);
+    return p[sizeof...(I)];
 }
 
-inline DoubleDouble DoubleDouble::abs() const
+template <int N>
+constexpr DoubleDouble DoubleDouble::powi() const
+{
+    if constexpr (N < 0) {
+        return powi<-N>().recip();
+    }
+    else if constexpr (N == 0) {
+        return dd_one;
+    }
+    else if constexpr (N > 128) {
+        DoubleDouble h = powi<N/2>().sqr();
+        if constexpr (N % 2 == 1) {
+            return h*(*this);
+        }
+        else {
+            return h;
+        }
+    }
+    else {
+        constexpr int length = dd_powi_chain<N>::chain.length;
+        return dd_powi_chain_eval<N>(*this,
+                                     std::make_integer_sequence<int, length>{});
+    }
+}
+
+//
+// DoubleDoublePowers holds the powers x**k, |k| <= kmax, of a fixed x,
+// for code that needs many integer powers of the same number (e.g.
+// dd_e.powi(n) for many n).  x**k is computed as x**(k/2)*x**(k - k/2),
+// so its error grows like log2(k) as for powi(), and x**-k is
+// x**k.recip().  For |n| > kmax, p(n) combines two table entries with
+// powi().
+//
+class DoubleDoublePowers
+{
+    int kmax;
+    std::vector<DoubleDouble> pos;
+    std::vector<DoubleDouble> neg;
+
+public:
+
+    // kmax is at least 1.
+    explicit DoubleDoublePowers(const DoubleDouble& x, int kmax = 64)
+        : kmax(kmax < 1 ? 1 : kmax), pos(this->kmax + 1), neg(this->kmax + 1)
+    {
+        pos[0] = dd_one;
+        pos[1] = x;
+        for (int k = 2; k <= this->kmax; ++k) {
+            pos[k] = (k % 2 == 0) ? pos[k/2].sqr() : pos[k/2]*pos[k - k/2];
+        }
+        for (int k = 0; k <= this->kmax; ++k) {
+            neg[k] = pos[k].recip();
+        }
+    }
+
+    DoubleDouble operator()(int n) const
+    {
+        if (n >= 0) {
+            if (n <= kmax) {
+                return pos[n];
+            }
+            return pos[kmax].powi(n/kmax)*pos[n % kmax];
+        }
+        if (n >= -kmax) {
+            return neg[-n];
+        }
+        return neg[kmax].powi(-(n/kmax))*neg[-(n % kmax)];
+    }
+};
+
+
+//
+// exp(x) is computed as 2**k * 2**(j/64) * exp(r), where
+// x = (64*k + j)*ln(2)/64 + r, 0 <= j < 64 and |r| <= ln(2)/128.
+//
+// ln(2)/64 is split into three parts.  The first two have 36 significant
+// bits, so their products with m = 64*k + j (|m| < 2**17) are exact, and
+// r is computed with an error of about 2**-114.  2**(j/64) is looked up
+// in exp2_table, exp(r) - 1 is the Taylor polynomial of degree 11 (the
+// terms of degree 7 and higher in double precision), and the final
+// scaling by 2**k is exact.  exp(dd_fast) uses the Taylor polynomial of
+// degree 9, with the terms of degree 5 and higher in double precision.
+//
+
+inline constexpr double exp_ln2_64_1 = 0.010830424696223417;
+inline constexpr double exp_ln2_64_2 = 2.5728046223228848e-14;
+inline constexpr double exp_ln2_64_3 = 4.784126150029144e-26;
+inline constexpr double exp_64_ln2 = 92.33248261689366;
+
+// 2**(j/64), j = 0, ..., 63.
+inline constexpr std::array<DoubleDouble, 64> exp2_table{
+    DoubleDouble(1.0, 0.0),
+    DoubleDouble(1.0108892860517005, -1.5234778603368577e-17),
+    DoubleDouble(1.0218971486541166, 5.109225028973444e-17),
+    DoubleDouble(1.0330248790212284, 7.600838874027088e-18),
+    DoubleDouble(1.0442737824274138, 8.551889705537965e-17),
+    DoubleDouble(1.0556451783605572, 1.759325738772092e-18),
+    DoubleDouble(1.0671404006768237, -7.899853966841582e-17),
+    DoubleDouble(1.0787607977571199, -6.656660436056593e-17),
+    DoubleDouble(1.0905077326652577, -3.046782079812471e-17),
+    DoubleDouble(1.102382583307841, 5.2660368715706944e-17),
+    DoubleDouble(1.1143867425958924, 1.0410278456845571e-16),
+    DoubleDouble(1.1265216186082418, 5.165856758795457e-17),
+    DoubleDouble(1.1387886347566916, 8.912812676025408e-17),
+    DoubleDouble(1.1511892299529827, 3.250710218863827e-17),
+    DoubleDouble(1.1637248587775775, 3.8292048369240935e-17),
+    DoubleDouble(1.1763969916502812, 5.554203254218079e-17),
+    DoubleDouble(1.189207115002721, 3.982015231465646e-17),
+    DoubleDouble(1.202156731452703, 6.644981499252301e-17),
+    DoubleDouble(1.215247359980469, -7.712630692681488e-17),
+    DoubleDouble(1.22848053610687, -1.89878163130253e-17),
+    DoubleDouble(1.241857812073484, 4.658027591836937e-17),
+    DoubleDouble(1.255380757024691, -6.7113898212968784e-18),
+    DoubleDouble(1.2690509571917332, 2.667932131342186e-18),
+    DoubleDouble(1.2828700160787783, 1.713594918243561e-17),
+    DoubleDouble(1.2968395546510096, 2.5382502794888315e-17),
+    DoubleDouble(1.3109612115247644, -7.181536135519454e-17),
+    DoubleDouble(1.3252366431597413, -2.8587312100388614e-17),
+    DoubleDouble(1.339667524053303, 8.927282594831732e-17),
+    DoubleDouble(1.3542555469368927, 7.70094837980299e-17),
+    DoubleDouble(1.3690024229745905, 9.593797919118849e-17),
+    DoubleDouble(1.383909881963832, -6.770511658794786e-17),
+    DoubleDouble(1.3989796725383112, -9.614213209051323e-17),
+    DoubleDouble(1.4142135623730951, -9.667293313452913e-17),
+    DoubleDouble(1.42961333839197, -1.2031642489053655e-17),
+    DoubleDouble(1.4451808069770467, -3.0237581349939873e-17),
+    DoubleDouble(1.460917794180647, -5.600377186075216e-17),
+    DoubleDouble(1.4768261459394993, -3.483994556892796e-17),
+    DoubleDouble(1.4929077282912648, 1.4192920154284036e-17),
+    DoubleDouble(1.5091644275934228, -1.016455327754295e-16),
+    DoubleDouble(1.5255981507445384, -1.1024941712342561e-16),
+    DoubleDouble(1.5422108254079407, 7.949834809697621e-17),
+    DoubleDouble(1.559004400237837, 3.7812070533575275e-17),
+    DoubleDouble(1.5759808451078865, -1.0136916471278304e-17),
+    DoubleDouble(1.593142151342267, -1.0094406542311964e-16),
+    DoubleDouble(1.6104903319492543, 2.4707192569797888e-17),
+    DoubleDouble(1.6280274218573478, -6.712955084707084e-17),
+    DoubleDouble(1.645755478153965, -1.0125679913674773e-16),
+    DoubleDouble(1.6636765803267364, 5.8909926967131e-17),
+    DoubleDouble(1.681792830507429, 8.199010020581497e-17),
+    DoubleDouble(1.7001063537185235, -8.0237193703977e-18),
+    DoubleDouble(1.718619298122478, -1.851380418263111e-17),
+    DoubleDouble(1.7373338352737062, 3.164389299292957e-17),
+    DoubleDouble(1.7562521603732995, 2.960140695448873e-17),
+    DoubleDouble(1.7753764925265212, 6.429731796556572e-17),
+    DoubleDouble(1.7947090750031072, 1.8227458427912087e-17),
+    DoubleDouble(1.8142521755003989, -9.969531538920349e-17),
+    DoubleDouble(1.8340080864093424, 3.283107224245627e-17),
+    DoubleDouble(1.8539791250833855, 9.761887490727594e-17),
+    DoubleDouble(1.8741676341103, -6.122763413004143e-17),
+    DoubleDouble(1.8945759815869656, 3.4034035352165297e-17),
+    DoubleDouble(1.9152065613971474, -1.0619946056195963e-16),
+    DoubleDouble(1.9360617934922943, 1.0332385960676326e-16),
+    DoubleDouble(1.9571441241754002, 8.960767791036668e-17),
+    DoubleDouble(1.978456026387951, 4.0388753109278167e-17)
+};
+
+// 1/k!, k = 2, ..., 6.
+inline constexpr std::array<DoubleDouble, 5> exp_taylor{
+    DoubleDouble(0.5, 0.0),
+    DoubleDouble(0.16666666666666666, 9.25185853854297e-18),
+    DoubleDouble(0.041666666666666664, 2.3129646346357427e-18),
+    DoubleDouble(0.008333333333333333, 1.1564823173178714e-19),
+    DoubleDouble(0.001388888888888889, -5.300543954373577e-20)
+};
+
+// 1/k!, k = 7, ..., 11.  These terms are less than 2**-64 for
+// |r| <= ln(2)/128, so they only need double precision.
+inline constexpr std::array<double, 5> exp_taylor_tail{
+    0.0001984126984126984,
+    2.48015873015873e-05,
+    2.7557319223985893e-06,
+    2.755731922398589e-07,
+    2.505210838544172e-08
+};
+
+// r = x - m*ln(2)/64.
+inline DoubleDouble exp_reduce(const DoubleDouble& x, int m)
+{
+    // x.upper - m*exp_ln2_64_1 is exact.
+    DoubleDouble r = two_difference(x.upper - m*exp_ln2_64_1, m*exp_ln2_64_2);
+    return (r + x.lower) - m*exp_ln2_64_3;
+}
+
+// exp(r) - 1 for |r| <= ln(2)/128.
+inline DoubleDouble exp_poly(const DoubleDouble& r, dd_accurate_t)
+{
+    // exp(r) - 1 = r + r**2*(q(r) + r**5*h(r))
+    double r2 = r.upper*r.upper;
+    double h = r2*r2*r.upper*(exp_taylor_tail[0] + r.upper*exp_taylor_tail[1]
+                              + r2*(exp_taylor_tail[2]
+                                    + r.upper*exp_taylor_tail[3]
+                                    + r2*exp_taylor_tail[4]));
+    return dd_fma(r.sqr(), dd_polyval(exp_taylor, r) + h, r);
+}
+
+inline DoubleDouble exp_poly(const DoubleDouble& r, dd_fast_t)
+{
+    // exp(r) - 1 = r + r**2*(1/2 + r/6 + r**2/24 + r**3*h(r))
+    double r2 = r.upper*r.upper;
+    double h = r2*r.upper*(exp_taylor[3].upper + r.upper*exp_taylor[4].upper
+                           + r2*(exp_taylor_tail[0]
+                                 + r.upper*exp_taylor_tail[1]
+                                 + r2*exp_taylor_tail[2]));
+    DoubleDouble q = dd_fma(dd_fma(r, exp_taylor[2], exp_taylor[1]), r,
+                            exp_taylor[0]);
+    return dd_fma(r.sqr(), q + h, r);
+}
+
+template <typename Tier>
+inline DoubleDouble exp_impl(const DoubleDouble& x, Tier tier)
+{
+    DD_COUNT(exp);
+    if (x.upper > 709.782712893384) {
+        DD_COUNT(exp_overflow);
+        return dd_inf;
+    }
+    if (!(x.upper >= -745.2)) {
+        // exp(x) underflows to 0, or x is NAN.
+        DD_COUNT(exp_underflow);
+        return std::isnan(x.upper) ? DoubleDouble(NAN) : dd_zero;
+    }
+    int m = int(std::nearbyint(x.upper*exp_64_ln2));
+    int k = m >> 6;
+    int j = m & 63;
+    DoubleDouble p = exp_poly(exp_reduce(x, m), tier);
+    const DoubleDouble& t = exp2_table[j];
+    DoubleDouble y = dd_fma(t, p, t);
+    return two_sum_quick(std::ldexp(y.upper, k), std::ldexp(y.lower, k));
+}
+
+inline DoubleDouble DoubleDouble::exp() const
+{
+    return exp_impl(*this, dd_accurate);
+}
+
+inline DoubleDouble DoubleDouble::exp(dd_accurate_t) const
+{
+    return exp_impl(*this, dd_accurate);
+}
+
+inline DoubleDouble DoubleDouble::exp(dd_fast_t) const
+{
+    return exp_impl(*this, dd_fast);
+}
+
+inline DoubleDouble DoubleDouble::sqrt() const
+{
+    DD_COUNT(sqrt);
+    if (upper == 0 && lower == 0) {
+        return dd_zero;
+    }
+    double r = std::sqrt(upper);
+    DoubleDouble sf = two_product(r, r);
+    double e = (upper - sf.upper - sf.lower + lower) * 0.5 / r;
+    return two_sum_quick(r, e);
+}
+
+//
+// log(x) is computed as e*ln(2) + log(c) + log(f/c), where x = 2**e * f
+// with sqrt(1/2) <= f < sqrt(2), and c = j/128 is the nearest multiple of
+// 1/128 to f.  log(c) is looked up in log_table, and
+//
+//     log(f/c) = 2*atanh(s) = 2*(s + s**3/3 + s**5/5 + ...),
+//
+// where s = (f - c)/(f + c) and |s| < 2**-8.4.  The series is summed up to
+// s**15; the terms from s**9 on are less than 2**-64*|s| and are
+// evaluated in double.  log(dd_fast) sums the series up to s**9, with only
+// the s**3 term in double-double.  Because f is close to 1 when e is 0,
+// there is no cancellation in the final sum when x is close to 1.
+//
+// log_kernel(a, b, l, tier) returns log(a + b + l), where a > 0 is finite,
+// |b| <= ulp(a)/2 and |l| <= |a|*2**-52.  The three parts allow log1p() to
+// pass 1 + x exactly.
+//
+
+// log(j/128), j = 91, ..., 181.
+inline constexpr std::array<DoubleDouble, 91> log_table{
+    DoubleDouble(-0.34117075740276714, 1.9366790062602867e-17),
+    DoubleDouble(-0.33024168687057687, 1.0828321637483858e-17),
+    DoubleDouble(-0.3194307707663612, -1.354256857264811e-18),
+    DoubleDouble(-0.3087354816496133, 1.6199186085148102e-17),
+    DoubleDouble(-0.29815337231907635, 1.720695867445866e-17),
+    DoubleDouble(-0.2876820724517809, -2.607160616442564e-17),
+    DoubleDouble(-0.27731928541623435, 7.44528405583513e-18),
+    DoubleDouble(-0.26706278524904525, 7.32891532732017e-18),
+    DoubleDouble(-0.2569104137850272, -2.502843296152504e-17),
+    DoubleDouble(-0.24686007793152578, -1.361743371748368e-17),
+    DoubleDouble(-0.2369097470783577, -1.9682402978398164e-18),
+    DoubleDouble(-0.22705745063534608, -9.551415762738488e-18),
+    DoubleDouble(-0.2173012756899814, -1.6168452453763015e-18),
+    DoubleDouble(-0.2076393647782445, -1.2053243216686129e-17),
+    DoubleDouble(-0.1980699137620938, -3.742843482461439e-18),
+    DoubleDouble(-0.18859116980755003, 7.432164219196925e-18),
+    DoubleDouble(-0.179201429457711, 1.0785017454858423e-17),
+    DoubleDouble(-0.16989903679539747, 4.868008764439071e-19),
+    DoubleDouble(-0.16068238169047347, 3.650183553047837e-18),
+    DoubleDouble(-0.15154989812720093, -5.1669593684615594e-18),
+    DoubleDouble(-0.14250006260728304, 9.926388234225749e-18),
+    DoubleDouble(-0.13353139262452263, 3.664457663660085e-18),
+    DoubleDouble(-0.1246424452072766, 5.808912678940971e-18),
+    DoubleDouble(-0.1158318155251217, -4.338484369808096e-18),
+    DoubleDouble(-0.1070981355563671, 1.73705104015906e-18),
+    DoubleDouble(-0.09844007281325252, 4.439009633675136e-18),
+    DoubleDouble(-0.08985632912186105, 6.273760163689594e-19),
+    DoubleDouble(-0.0813456394539524, -5.07707635593117e-18),
+    DoubleDouble(-0.07290677080808779, 6.306860257532778e-18),
+    DoubleDouble(-0.06453852113757118, 6.470486661692933e-18),
+    DoubleDouble(-0.05623971832287608, 3.2835149805605613e-18),
+    DoubleDouble(-0.048009219186360606, -1.4390903347292205e-18),
+    DoubleDouble(-0.039845908547199674, 3.129547680315208e-18),
+    DoubleDouble(-0.0317486983145803, -3.0382263084680858e-18),
+    DoubleDouble(-0.023716526617316044, 1.5774243488668215e-18),
+    DoubleDouble(-0.015748356968139168, -1.0021578630528974e-18),
+    DoubleDouble(-0.007843177461025893, -2.764708154124904e-19),
+    DoubleDouble(0.0, 0.0),
+    DoubleDouble(0.007782140442054949, -1.2819179123343845e-20),
+    DoubleDouble(0.015504186535965254, -3.278321022892429e-19),
+    DoubleDouble(0.02316705928153438, -1.1769544932063305e-18),
+    DoubleDouble(0.030771658666753687, 1.0431732029005968e-18),
+    DoubleDouble(0.0383188643021366, -2.357996157351286e-18),
+    DoubleDouble(0.0458095360312942, 1.902959866474257e-18),
+    DoubleDouble(0.053244514518812285, -1.665575816973663e-18),
+    DoubleDouble(0.06062462181643484, 2.6424025938726934e-18),
+    DoubleDouble(0.06795066190850775, -1.2802141240611733e-18),
+    DoubleDouble(0.07522342123758753, -5.930604196293241e-18),
+    DoubleDouble(0.08244366921107459, 5.700437773813987e-18),
+    DoubleDouble(0.08961215868968714, -5.4268129336647135e-18),
+    DoubleDouble(0.09672962645855111, -5.597397486289965e-19),
+    DoubleDouble(0.10379679368164356, 5.47772415726659e-18),
+    DoubleDouble(0.11081436634029011, 1.183748342825649e-18),
+    DoubleDouble(0.11778303565638346, -1.1971685747593677e-18),
+    DoubleDouble(0.12470347850095724, -4.6522609636496624e-18),
+    DoubleDouble(0.13157635778871926, 1.1123000879729588e-17),
+    DoubleDouble(0.13840232285911913, 4.447777301357527e-18),
+    DoubleDouble(0.1451820098444979, 8.242418783022475e-18),
+    DoubleDouble(0.15191604202584197, 6.4838631244022194e-18),
+    DoubleDouble(0.15860503017663857, 1.1257003872182592e-17),
+    DoubleDouble(0.16524957289530717, -1.0094935622322628e-17),
+    DoubleDouble(0.17185025692665923, -6.0224538210113705e-18),
+    DoubleDouble(0.1784076574728183, -1.2432553788701131e-17),
+    DoubleDouble(0.184922338494012, 3.0236614153574064e-18),
+    DoubleDouble(0.19139485299962947, -1.2129496905792884e-17),
+    DoubleDouble(0.19782574332991987, 1.2821194372980142e-17),
+    DoubleDouble(0.2042155414286909, 2.7338281018722773e-18),
+    DoubleDouble(0.21056476910734964, -4.249405314729895e-18),
+    DoubleDouble(0.21687393830061436, 4.551026193234283e-18),
+    DoubleDouble(0.22314355131420976, -9.091270597324799e-18),
+    DoubleDouble(0.22937410106484582, 9.927671823978025e-18),
+    DoubleDouble(0.2355660713127669, -2.3943371495187355e-18),
+    DoubleDouble(0.24171993688714516, 8.900990022166643e-18),
+    DoubleDouble(0.24783616390458127, -1.2432209578702523e-17),
+    DoubleDouble(0.25391520998096345, -8.048097394424201e-18),
+    DoubleDouble(0.25995752443692605, 2.069806938978935e-17),
+    DoubleDouble(0.26596354849713794, 5.3393802761314314e-18),
+    DoubleDouble(0.27193371548364176, 7.83319637697442e-19),
+    DoubleDouble(0.2778684510034563, -9.16018294909263e-19),
+    DoubleDouble(0.2837681731306446, -2.032665581126656e-17),
+    DoubleDouble(0.28963329258304266, 2.0535953219858174e-17),
+    DoubleDouble(0.2954642128938359, -2.16461086040599e-17),
+    DoubleDouble(0.3012613305781618, -9.048511144048564e-18),
+    DoubleDouble(0.3070250352949119, -1.2319916200101964e-17),
+    DoubleDouble(0.3127557100038969, -1.451808353098951e-17),
+    DoubleDouble(0.3184537311185346, 2.7114779367326236e-17),
+    DoubleDouble(0.324119468654212, -7.958214381893813e-18),
+    DoubleDouble(0.329753286372468, 2.122020616196946e-18),
+    DoubleDouble(0.3353555419211378, 1.834564437059473e-17),
+    DoubleDouble(0.3409265869705932, 1.7467136443544747e-17),
+    DoubleDouble(0.34646676734620857, 1.028583585496265e-17)
+};
+
+// 2/3, 2/5 and 2/7.
+inline constexpr std::array<DoubleDouble, 3> log_atanh{
+    DoubleDouble(0.6666666666666666, 3.700743415417188e-17),
+    DoubleDouble(0.4, -2.2204460492503132e-17),
+    DoubleDouble(0.2857142857142857, 1.586032892321652e-17)
+};
+
+// 2/9, 2/11, 2/13 and 2/15.
+inline constexpr std::array<double, 4> log_atanh_tail{
+    0.2222222222222222,
+    0.18181818181818182,
+    0.15384615384615385,
+    0.13333333333333333
+};
+
+// (2*atanh(s) - 2*s)/s**3, with s2 = s**2.
+inline DoubleDouble log_series(const DoubleDouble& s2, dd_accurate_t)
+{
+    double t = s2.upper;
+    double h = t*t*t*(log_atanh_tail[0] + t*log_atanh_tail[1]
+                      + t*t*(log_atanh_tail[2] + t*log_atanh_tail[3]));
+    return dd_polyval(log_atanh, s2) + h;
+}
+
+inline DoubleDouble log_series(const DoubleDouble& s2, dd_fast_t)
+{
+    double t = s2.upper;
+    double h = t*(log_atanh[1].upper + t*(log_atanh[2].upper
+                                          + t*log_atanh_tail[0]));
+    return log_atanh[0] + h;
+}
+
+template <typename Tier>
+inline DoubleDouble log_kernel(double a, double b, double l, Tier tier)
+{
+    int e;
+    double fa = std::frexp(a, &e);
+    if (fa < 0.7071067811865476) {
+        fa *= 2;
+        e -= 1;
+    }
+    double fb = std::ldexp(b, -e);
+    double fl = std::ldexp(l, -e);
+    int j = int(std::nearbyint(fa*128));
+    double c = j/128.0;
+    // d = f - c.  fa - c is exact.
+    DoubleDouble d = two_sum(fa - c, fb);
+    d = two_sum(d.upper, d.lower + fl);
+    DoubleDouble s = d / (d + 2*c);
+    DoubleDouble s2 = s.sqr();
+    DoubleDouble a2 = dd_fma(s*s2, log_series(s2, tier), s*2.0);
+    // Sum e*ln(2) + log(c) + a2.  The upper parts are added with error
+    // free transformations, and all the lower parts once at the end.
+    const DoubleDouble& lc = log_table[j - 91];
+    DoubleDouble p = two_product(e, dd_ln2.upper);
+    DoubleDouble u = two_sum(p.upper, lc.upper);
+    DoubleDouble v = two_sum(u.upper, a2.upper);
+    double lo = u.lower + v.lower + ((p.lower + e*dd_ln2.lower)
+                                     + (lc.lower + a2.lower));
+    return two_sum_quick(v.upper, lo);
+}
+
+template <typename Tier>
+inline DoubleDouble log_impl(const DoubleDouble& x, Tier tier)
+{
+    DD_COUNT(log);
+    if (!(x.upper > 0 && x.upper < INFINITY)) {
+        if (x.upper == 0) {
+            return -dd_inf;
+        }
+        // x < 0, NAN or INF.
+        return (x.upper > 0) ? dd_inf : DoubleDouble(NAN);
+    }
+    return log_kernel(x.upper, x.lower, 0.0, tier);
+}
+
+inline DoubleDouble DoubleDouble::log() const
+{
+    return log_impl(*this, dd_accurate);
+}
+
+inline DoubleDouble DoubleDouble::log(dd_accurate_t) const
+{
+    return log_impl(*this, dd_accurate);
+}
+
+inline DoubleDouble DoubleDouble::log(dd_fast_t) const
+{
+    return log_impl(*this, dd_fast);
+}
+
+//
+// log1p(x) passes 1 + x to log_kernel() as the exact sum of three
+// doubles.  When x < -0.5, 1 + x.upper is exact, and 1 + x is a
+// DoubleDouble.  For |x| < 2**-12, the Taylor polynomial
+// x - x**2/2 + ... - x**10/10 is used; its leading term is exact.
+//
+
+// (-1)**(k+1)/k, k = 2, ..., 10.
+inline constexpr std::array<DoubleDouble, 9> log1p_taylor{
+    DoubleDouble(-0.5, 0.0),
+    DoubleDouble(0.3333333333333333, 1.850371707708594e-17),
+    DoubleDouble(-0.25, 0.0),
+    DoubleDouble(0.2, -1.1102230246251566e-17),
+    DoubleDouble(-0.16666666666666666, -9.25185853854297e-18),
+    DoubleDouble(0.14285714285714285, 7.93016446160826e-18),
+    DoubleDouble(-0.125, 0.0),
+    DoubleDouble(0.1111111111111111, 6.1679056923619804e-18),
+    DoubleDouble(-0.1, 5.551115123125783e-18)
+};
+
+inline DoubleDouble DoubleDouble::log1p() const
+{
+    DD_COUNT(log1p);
+    if (std::fabs(upper) < 0.000244140625) {
+        DD_COUNT(log1p_taylor);
+        return *this + (*this)*(*this)*dd_polyval(log1p_taylor, *this);
+    }
+    if (upper < -0.5) {
+        return two_sum(1.0 + upper, lower).log();
+    }
+    if (!(upper < INFINITY)) {
+        // NAN or INF.
+        return DoubleDouble(upper);
+    }
+    DoubleDouble a = two_sum(1.0, upper);
+    return log_kernel(a.upper, a.lower, lower, dd_accurate);
+}
+
+constexpr DoubleDouble DoubleDouble::abs() const
 {
     if (*this < 0.0) {
         return -*this;
@@ -603,7 +1785,7 @@ inline DoubleDouble DoubleDouble::abs() const
     }
 }
 
-static const std::array<DoubleDouble, 10> numer{
+inline constexpr std::array<DoubleDouble, 10> numer{
     DoubleDouble(-0.028127670288085938, 1.46e-37),
     DoubleDouble(0.5127815691121048, -4.248816580490825e-17),
     DoubleDouble(-0.0632631785207471, 4.733650586348708e-18),
@@ -616,7 +1798,7 @@ static const std::array<DoubleDouble, 10> numer{
     DoubleDouble(4.526182006900779e-11, -1.9856249941108077e-27)
 };
 
-static const std::array<DoubleDouble, 11> denom{
+inline constexpr std::array<DoubleDouble, 11> denom{
     DoubleDouble(1.0),
     DoubleDouble(-0.4544126470907431, -2.2553855773661143e-17),
     DoubleDouble(0.09682713193619222, -4.961446925746919e-19),
@@ -634,29 +1816,11 @@ static const std::array<DoubleDouble, 11> denom{
 //
 // Rational approximation of expm1(x) for -1/2 < x < 1/2
 //
-inline DoubleDouble expm1_rational_approx(const DoubleDouble& x)
-{
-    const DoubleDouble Y = DoubleDouble(1.028127670288086);
-    const DoubleDouble num = (((((((((numer[9]*x + numer[8])
-                                              *x + numer[7])
-                                              *x + numer[6])
-                                              *x + numer[5])
-                                              *x + numer[4])
-                                              *x + numer[3])
-                                              *x + numer[2])
-                                              *x + numer[1])
-                                              *x + numer[0]);
-    const DoubleDouble den = ((((((((((denom[10]*x + denom[9])
-                                               *x + denom[8])
-                                               *x + denom[7])
-                                               *x + denom[6])
-                                               *x + denom[5])
-                                               *x + denom[4])
-                                               *x + denom[3])
-                                               *x + denom[2])
-                                               *x + denom[1])
-                                               *x + denom[0]);
-    return x*Y + x * num/den;
+constexpr DoubleDouble expm1_rational_approx(const DoubleDouble& x)
+{
+    const double Y = 1.028127670288086;
+    const DoubleDouble r = dd_ratval(numer, denom, x);
+    return dd_fma(x, r, x*Y);
 }
 
 
@@ -669,6 +1833,7 @@ inline DoubleDouble expm1_rational_approx(const DoubleDouble& x)
 
 inline DoubleDouble DoubleDouble::expm1() const
 {
+    DD_COUNT(expm1);
     DoubleDouble a = (*this).abs();
     if (a.upper > 0.5) {
         if (a.upper > LOG_MAX_VALUE) {
@@ -687,12 +1852,616 @@ inline DoubleDouble DoubleDouble::expm1() const
     return expm1_rational_approx(*this);
 }
 
+inline DoubleDouble DoubleDouble::expm1(dd_accurate_t) const
+{
+    return expm1();
+}
+
+//
+// expm1(dd_fast) uses the argument reduction and the polynomial of
+// exp(dd_fast) for |x| <= 1/2, where x = m*ln(2)/64 + r and |m| <= 46:
+// expm1(x) = p for m = 0, and t*p + (t - 1) otherwise, where t = 2**(m/64)
+// and p = exp(r) - 1.  t - 1 is exact, and |expm1(x)| > 2**-8 when m is
+// not 0, so there is no cancellation.
+//
+inline DoubleDouble DoubleDouble::expm1(dd_fast_t) const
+{
+    DD_COUNT(expm1);
+    if (!(std::fabs(upper) <= 0.5)) {
+        // Also for NAN.
+        return exp(dd_fast) - 1.0;
+    }
+    int m = int(std::nearbyint(upper*exp_64_ln2));
+    DoubleDouble p = exp_poly(exp_reduce(*this, m), dd_fast);
+    if (m == 0) {
+        return p;
+    }
+    DoubleDouble t = exp2_table[m & 63];
+    if (m < 0) {
+        t = DoubleDouble(0.5*t.upper, 0.5*t.lower, dd_unchecked);
+    }
+    return dd_fma(t, p, t - 1.0);
+}
+
+//
+// Trigonometric functions.
+//
+// The argument is reduced to r = x - k*pi/2, |r| <= pi/4, with pi/2 split
+// into three doubles (trig_pi_2_1 + trig_pi_2_2 + trig_pi_2_3, about 160
+// bits).  The products of k with the first two parts are computed exactly
+// with two_product(), so the absolute error of r is about 2**-159*|x|.
+// For |x| < 2**20 that is below 2**-106*|r| unless r is within 2**-33 of
+// zero.  (There is no Payne-Hanek reduction for huge arguments.)
+//
+// Then r = i/16 + t with |t| <= 1/32, sin(i/16) and cos(i/16) are looked
+// up in sin_table and cos_table, sin(t) and cos(t) - 1 are evaluated with
+// their Taylor polynomials (the terms less than 2**-55 in double), and
+//
+//     sin(r) = sin(i/16) + (sin(i/16)*(cos(t) - 1) + cos(i/16)*sin(t))
+//     cos(r) = cos(i/16) + (cos(i/16)*(cos(t) - 1) - sin(i/16)*sin(t))
+//
+// sincos() computes both with one reduction; tan() is sin(r)/cos(r).
+//
+
+inline constexpr double trig_2_pi = 0.6366197723675814;
+inline constexpr double trig_pi_4 = 0.7853981633974483;
+inline constexpr double trig_pi_2_1 = 1.5707963267948966;
+inline constexpr double trig_pi_2_2 = 6.123233995736766e-17;
+inline constexpr double trig_pi_2_3 = -1.4973849048591698e-33;
+
+// sin(i/16), i = 0, ..., 13.
+inline constexpr std::array<DoubleDouble, 14> sin_table{
+    DoubleDouble(0.0, 0.0),
+    DoubleDouble(0.0624593178423802, -2.040259504585711e-18),
+    DoubleDouble(0.12467473338522769, -2.925947496057858e-18),
+    DoubleDouble(0.18640329676226988, 2.3493796901281573e-18),
+    DoubleDouble(0.24740395925452294, -7.53102495590706e-18),
+    DoubleDouble(0.30743851458038085, 1.1004366442765296e-19),
+    DoubleDouble(0.36627252908604757, -9.938814562106524e-18),
+    DoubleDouble(0.42367625720393803, -2.331800700068871e-17),
+    DoubleDouble(0.479425538604203, -5.103969860556013e-18),
+    DoubleDouble(0.5333026735360201, 5.129318115032044e-17),
+    DoubleDouble(0.5850972729404622, -5.4883972461161805e-17),
+    DoubleDouble(0.6346070800152693, -3.4568582392624965e-17),
+    DoubleDouble(0.6816387600233341, 4.410467313197903e-17),
+    DoubleDouble(0.7260086552607126, -1.573621815339587e-17)
+};
+
+// cos(i/16), i = 0, ..., 13.
+inline constexpr std::array<DoubleDouble, 14> cos_table{
+    DoubleDouble(1.0, 0.0),
+    DoubleDouble(0.9980475107000991, 3.3232291674141346e-17),
+    DoubleDouble(0.992197667229329, 4.754870575189364e-17),
+    DoubleDouble(0.9824733131012553, -3.919920375420088e-17),
+    DoubleDouble(0.9689124217106447, 5.071436662403936e-17),
+    DoubleDouble(0.9515679480481722, -3.8614834675674123e-17),
+    DoubleDouble(0.9305076219123143, 4.488760003328074e-18),
+    DoubleDouble(0.9058136834259364, 4.2864666490805214e-17),
+    DoubleDouble(0.8775825618903728, -4.2623149864279997e-17),
+    DoubleDouble(0.8459244992310679, 1.549506647350329e-17),
+    DoubleDouble(0.8109631195052179, -3.091333486122179e-17),
+    DoubleDouble(0.7728349461524715, 4.231014921891023e-17),
+    DoubleDouble(0.7316888688738209, -1.0475824306512768e-17),
+    DoubleDouble(0.6876855622205048, 3.5430696752823923e-17)
+};
+
+// -1/3!, 1/5!, -1/7!
+inline constexpr std::array<DoubleDouble, 3> sin_taylor{
+    DoubleDouble(-0.16666666666666666, -9.25185853854297e-18),
+    DoubleDouble(0.008333333333333333, 1.1564823173178714e-19),
+    DoubleDouble(-0.0001984126984126984, -1.7209558293420705e-22)
+};
+
+// 1/9!, -1/11!, 1/13!
+inline constexpr std::array<double, 3> sin_taylor_tail{
+    2.7557319223985893e-06,
+    -2.505210838544172e-08,
+    1.6059043836821613e-10
+};
+
+// -1/2!, 1/4!, -1/6!
+inline constexpr std::array<DoubleDouble, 3> cos_taylor{
+    DoubleDouble(-0.5, 0.0),
+    DoubleDouble(0.041666666666666664, 2.3129646346357427e-18),
+    DoubleDouble(-0.001388888888888889, 5.300543954373577e-20)
+};
+
+// 1/8!, -1/10!, 1/12!, -1/14!
+inline constexpr std::array<double, 4> cos_taylor_tail{
+    2.48015873015873e-05,
+    -2.755731922398589e-07,
+    2.08767569878681e-09,
+    -1.1470745597729725e-11
+};
+
+//
+// Set r = x - k*pi/2 and return k mod 4.  x must be finite.
+//
+// pi/2 is stored in three parts, about 160 bits, so the absolute error
+// of r is about |x|*2**-160 and accuracy is lost gradually as |x| grows:
+// the relative error of sin(x) is about 3e-32 for x = 2**56, 1e-31 for
+// 2**60, 7e-28 for 2**70 and 2e-23 for 2**90, and no accurate digits are
+// left only near 2**200.  When |x| > 2**53 or so, k is rounded and one
+// step can leave r as large as about 2**-52*|x|, so the step is repeated
+// until r is in the range of the kernels.
+//
+inline int trig_reduce(const DoubleDouble& x, DoubleDouble& r)
+{
+    r = x;
+    if (std::fabs(x.upper) <= trig_pi_4) {
+        return 0;
+    }
+    int q = 0;
+    do {
+        double k = std::nearbyint(r.upper*trig_2_pi);
+        DoubleDouble p1 = two_product(k, trig_pi_2_1);
+        DoubleDouble p2 = two_product(k, trig_pi_2_2);
+        // r.upper - p1.upper is exact.
+        DoubleDouble t = two_sum(r.upper - p1.upper, -p1.lower);
+        t = t + r.lower;
+        t = t - p2.upper;
+        r = t - (p2.lower + k*trig_pi_2_3);
+        q += int(std::fmod(k, 4.0));
+    } while (std::fabs(r.upper) > 0.8);
+    return q & 3;
+}
+
+//
+// sin(t) - t and cos(t) - 1 for |t| <= 1/32.
+//
+inline DoubleDouble trig_sin_poly(const DoubleDouble& t, const DoubleDouble& t2)
+{
+    double u = t2.upper;
+    double h = u*u*u*(sin_taylor_tail[0] + u*(sin_taylor_tail[1]
+                                              + u*sin_taylor_tail[2]));
+    return t*t2*(dd_polyval(sin_taylor, t2) + h);
+}
+
+inline DoubleDouble trig_cos_poly(const DoubleDouble& t2)
+{
+    double u = t2.upper;
+    double h = u*u*u*(cos_taylor_tail[0] + u*cos_taylor_tail[1]
+                      + u*u*(cos_taylor_tail[2] + u*cos_taylor_tail[3]));
+    return t2*(dd_polyval(cos_taylor, t2) + h);
+}
+
+//
+// sin(r) and cos(r) for |r| <= pi/4 (a little more is fine).
+// trig_kernel() computes only one of them.
+//
+inline void sincos_kernel(const DoubleDouble& r, DoubleDouble& s,
+                          DoubleDouble& c)
+{
+    int i = int(std::nearbyint(r.upper*16));
+    DoubleDouble t = r - i/16.0;
+    DoubleDouble t2 = t.sqr();
+    DoubleDouble sin_t = t + trig_sin_poly(t, t2);
+    DoubleDouble cos_t_m1 = trig_cos_poly(t2);
+    if (i == 0) {
+        s = sin_t;
+        c = 1.0 + cos_t_m1;
+        return;
+    }
+    DoubleDouble sa = sin_table[std::abs(i)];
+    const DoubleDouble& ca = cos_table[std::abs(i)];
+    if (i < 0) {
+        sa = -sa;
+    }
+    s = sa + dd_fma(sa, cos_t_m1, ca*sin_t);
+    c = ca + dd_fma(ca, cos_t_m1, -(sa*sin_t));
+}
+
+inline DoubleDouble trig_kernel(const DoubleDouble& r, bool cosine)
+{
+    int i = int(std::nearbyint(r.upper*16));
+    DoubleDouble t = r - i/16.0;
+    DoubleDouble t2 = t.sqr();
+    if (i == 0) {
+        return cosine ? 1.0 + trig_cos_poly(t2) : t + trig_sin_poly(t, t2);
+    }
+    DoubleDouble sin_t = t + trig_sin_poly(t, t2);
+    DoubleDouble cos_t_m1 = trig_cos_poly(t2);
+    DoubleDouble sa = sin_table[std::abs(i)];
+    const DoubleDouble& ca = cos_table[std::abs(i)];
+    if (i < 0) {
+        sa = -sa;
+    }
+    if (cosine) {
+        return ca + dd_fma(ca, cos_t_m1, -(sa*sin_t));
+    }
+    return sa + dd_fma(sa, cos_t_m1, ca*sin_t);
+}
+
+inline void DoubleDouble::sincos(DoubleDouble& s, DoubleDouble& c) const
+{
+    DD_COUNT(sincos);
+    if (!std::isfinite(upper)) {
+        s = DoubleDouble(NAN);
+        c = DoubleDouble(NAN);
+        return;
+    }
+    DoubleDouble r, sr, cr;
+    int q = trig_reduce(*this, r);
+    sincos_kernel(r, sr, cr);
+    switch (q) {
+        case 0:  s = sr;  c = cr;  break;
+        case 1:  s = cr;  c = -sr; break;
+        case 2:  s = -sr; c = -cr; break;
+        default: s = -cr; c = sr;  break;
+    }
+}
+
+inline DoubleDouble DoubleDouble::sin() const
+{
+    DD_COUNT(sin);
+    if (!std::isfinite(upper)) {
+        return DoubleDouble(NAN);
+    }
+    DoubleDouble r;
+    int q = trig_reduce(*this, r);
+    // sin(x) is sin(r), cos(r), -sin(r) or -cos(r) for q = 0, 1, 2, 3.
+    DoubleDouble y = trig_kernel(r, q & 1);
+    return (q & 2) ? -y : y;
+}
+
+inline DoubleDouble DoubleDouble::cos() const
+{
+    DD_COUNT(cos);
+    if (!std::isfinite(upper)) {
+        return DoubleDouble(NAN);
+    }
+    DoubleDouble r;
+    int q = trig_reduce(*this, r);
+    // cos(x) is cos(r), -sin(r), -cos(r) or sin(r) for q = 0, 1, 2, 3.
+    DoubleDouble y = trig_kernel(r, !(q & 1));
+    return ((q + 1) & 2) ? -y : y;
+}
+
+inline DoubleDouble DoubleDouble::tan() const
+{
+    DD_COUNT(tan);
+    if (!std::isfinite(upper)) {
+        return DoubleDouble(NAN);
+    }
+    DoubleDouble r, sr, cr;
+    int q = trig_reduce(*this, r);
+    sincos_kernel(r, sr, cr);
+    return (q & 1) ? -cr/sr : sr/cr;
+}
+
+//
+// Inverse trigonometric functions.
+//
+// atan_kernel(y, x) returns atan(y/x) for 0 <= y <= x.  With c = i/64 the
+// nearest multiple of 1/64 to y/x,
+//
+//     atan(y/x) = atan(c) + atan(t),   t = (y - c*x)/(x + c*y),
+//
+// and |t| <= 1/128.  atan(c) is looked up in atan_table, and atan(t) is
+// evaluated with its Taylor polynomial t - t**3/3 + ... - t**15/15; the
+// terms from t**9 on are less than 2**-56*|t| and are evaluated in
+// double.  Because t is computed from y and x directly, atan2() needs
+// only one DoubleDouble division.  asin() and acos() are computed with
+// atan2().
+//
+
+// atan(i/64), i = 0, ..., 64.
+inline constexpr std::array<DoubleDouble, 65> atan_table{
+    DoubleDouble(0.0, 0.0),
+    DoubleDouble(0.015623728620476831, -4.913600136566304e-19),
+    DoubleDouble(0.031239833430268277, -1.188442711587748e-18),
+    DoubleDouble(0.046840712915969654, -1.655677442254952e-19),
+    DoubleDouble(0.06241880999595735, -1.5490756308295046e-18),
+    DoubleDouble(0.0779666338315423, 5.804551873143357e-18),
+    DoubleDouble(0.09347678115858947, -6.2844725995420954e-18),
+    DoubleDouble(0.10894195698986579, 6.8267122072409585e-18),
+    DoubleDouble(0.12435499454676144, -3.1253241424539383e-18),
+    DoubleDouble(0.13970887428916365, -2.9579864247315813e-18),
+    DoubleDouble(0.15499674192394097, 9.585415594114324e-18),
+    DoubleDouble(0.1702119252854744, -3.541164079802125e-18),
+    DoubleDouble(0.18534794999569476, 4.180692268843079e-18),
+    DoubleDouble(0.2003985538258785, 3.1399542871844493e-18),
+    DoubleDouble(0.21535769969773805, 4.738160130078733e-19),
+    DoubleDouble(0.23021958727684372, 1.2313404529142703e-17),
+    DoubleDouble(0.24497866312686414, 1.0698755618734451e-17),
+    DoubleDouble(0.2596296294082575, 1.9238754924615304e-17),
+    DoubleDouble(0.2741674511196588, 8.261353575163773e-18),
+    DoubleDouble(0.2885873618940774, -1.428369957377257e-17),
+    DoubleDouble(0.3028848683749714, -1.1010827903001369e-17),
+    DoubleDouble(0.31705575320914703, -1.893928924292642e-17),
+    DoubleDouble(0.3310960767041321, -7.952610375793799e-18),
+    DoubleDouble(0.34500217720710513, -2.2938804755578304e-17),
+    DoubleDouble(0.35877067027057225, -2.4623815582638635e-17),
+    DoubleDouble(0.3723984466767542, 1.9612311504845653e-17),
+    DoubleDouble(0.38588266939807375, 2.378822732491941e-17),
+    DoubleDouble(0.39922076957525254, 2.246598105617042e-17),
+    DoubleDouble(0.4124104415973873, -1.587652227770689e-17),
+    DoubleDouble(0.42544963737004227, 2.3315530741892885e-17),
+    DoubleDouble(0.43833655985795783, -2.494277030626541e-17),
+    DoubleDouble(0.4510696559885235, -2.2703795229420475e-17),
+    DoubleDouble(0.4636476090008061, 2.2698777452961687e-17),
+    DoubleDouble(0.4760693303227612, 1.4654487332256713e-17),
+    DoubleDouble(0.48833395105640554, -1.1373236189329585e-17),
+    DoubleDouble(0.5004408131472942, -4.7181675085518756e-17),
+    DoubleDouble(0.5123894603107377, -2.5462781472855804e-17),
+    DoubleDouble(0.5241796287829132, 5.520094119641666e-18),
+    DoubleDouble(0.5358112379604637, -4.0637956834825575e-18),
+    DoubleDouble(0.5472843809874369, 4.923709671396255e-17),
+    DoubleDouble(0.5585993153435624, -5.4556305485916264e-18),
+    DoubleDouble(0.5697564534829784, 1.2255062085054184e-17),
+    DoubleDouble(0.5807563535676704, -1.441464378193067e-17),
+    DoubleDouble(0.5915997103351114, 4.920495453686772e-17),
+    DoubleDouble(0.6022873461349642, 2.950430737228402e-17),
+    DoubleDouble(0.6128202021652414, -3.1552061848586226e-17),
+    DoubleDouble(0.6231993299340659, 2.672403885140095e-17),
+    DoubleDouble(0.6334258829691446, -2.7290767436015276e-17),
+    DoubleDouble(0.6435011087932844, 1.5834785051444286e-17),
+    DoubleDouble(0.6534263411807619, 3.5800634857340095e-17),
+    DoubleDouble(0.6632029927060933, -3.076054864429649e-17),
+    DoubleDouble(0.6728325475937632, -1.899315009714705e-17),
+    DoubleDouble(0.6823165548747481, 6.943223671560008e-18),
+    DoubleDouble(0.6916566218531999, -8.117151192285796e-18),
+    DoubleDouble(0.7008544078844502, -1.987626234335816e-17),
+    DoubleDouble(0.7099116184635249, -4.597166450584887e-17),
+    DoubleDouble(0.7188299996216245, -2.1478388444456983e-17),
+    DoubleDouble(0.7276113326265107, 2.569325697391839e-18),
+    DoubleDouble(0.7362574289814281, 3.473937648299457e-17),
+    DoubleDouble(0.7447701257160751, 3.708315849135547e-17),
+    DoubleDouble(0.7531512809621944, -2.4256934659182068e-17),
+    DoubleDouble(0.7614027698055784, 9.850030332752822e-18),
+    DoubleDouble(0.7695264804056583, -3.704991905602721e-17),
+    DoubleDouble(0.7775243103733478, -2.6676490951944502e-17),
+    DoubleDouble(0.7853981633974483, 3.061616997868383e-17)
+};
+
+// -1/3, 1/5 and -1/7.
+inline constexpr std::array<DoubleDouble, 3> atan_taylor{
+    DoubleDouble(-0.3333333333333333, -1.850371707708594e-17),
+    DoubleDouble(0.2, -1.1102230246251566e-17),
+    DoubleDouble(-0.14285714285714285, -7.93016446160826e-18)
+};
+
+// 1/9, -1/11, 1/13 and -1/15.
+inline constexpr std::array<double, 4> atan_taylor_tail{
+    0.1111111111111111,
+    -0.09090909090909091,
+    0.07692307692307693,
+    -0.06666666666666667
+};
+
+inline DoubleDouble atan_kernel(const DoubleDouble& y, const DoubleDouble& x)
+{
+    int i = int(std::nearbyint(64*(y.upper/x.upper)));
+    DoubleDouble t;
+    if (i == 0) {
+        t = y/x;
+    }
+    else {
+        double c = i/64.0;
+        t = (y - x*c)/(x + y*c);
+    }
+    DoubleDouble t2 = t.sqr();
+    double u = t2.upper;
+    double h = u*u*u*(atan_taylor_tail[0] + u*atan_taylor_tail[1]
+                      + u*u*(atan_taylor_tail[2] + u*atan_taylor_tail[3]));
+    DoubleDouble a = dd_fma(t*t2, dd_polyval(atan_taylor, t2) + h, t);
+    return (i == 0) ? a : atan_table[i] + a;
+}
+
+inline DoubleDouble atan2(const DoubleDouble& y, const DoubleDouble& x)
+{
+    DD_COUNT(atan2);
+    if (std::isnan(y.upper) || std::isnan(x.upper)) {
+        return DoubleDouble(NAN);
+    }
+    DoubleDouble r;
+    if (std::isinf(y.upper) || std::isinf(x.upper)) {
+        if (!std::isinf(x.upper)) {
+            r = dd_pi_2;
+        }
+        else if (!std::isinf(y.upper)) {
+            r = dd_zero;
+        }
+        else {
+            r = dd_pi_2*0.5;
+        }
+    }
+    else if (y.upper == 0 || x.upper == 0) {
+        r = (y.upper == 0) ? dd_zero : dd_pi_2;
+    }
+    else {
+        DoubleDouble ay = y.abs();
+        DoubleDouble ax = x.abs();
+        // Keep x + c*y and y - c*x well inside the range of double.
+        double m = std::fmax(ay.upper, ax.upper);
+        if (m > 1e300) {
+            ay = ay*5.421010862427522e-20;
+            ax = ax*5.421010862427522e-20;
+        }
+        else if (m < 1e-290) {
+            ay = ay*18446744073709551616.0;
+            ax = ax*18446744073709551616.0;
+        }
+        r = (ay <= ax) ? atan_kernel(ay, ax) : dd_pi_2 - atan_kernel(ax, ay);
+    }
+    if (std::signbit(x.upper)) {
+        r = dd_pi - r;
+    }
+    return std::signbit(y.upper) ? -r : r;
+}
+
+inline DoubleDouble DoubleDouble::atan() const
+{
+    DD_COUNT(atan);
+    if (std::isnan(upper)) {
+        return DoubleDouble(NAN);
+    }
+    DoubleDouble a = abs();
+    DoubleDouble r;
+    if (a.upper <= 1) {
+        r = atan_kernel(a, dd_one);
+    }
+    else if (a.upper < INFINITY) {
+        r = dd_pi_2 - atan_kernel(dd_one, a);
+    }
+    else {
+        r = dd_pi_2;
+    }
+    return (upper < 0) ? -r : r;
+}
+
+//
+// asin(x) = atan2(x, sqrt(1 - x**2)) and acos(x) = atan2(sqrt(1 - x**2), x).
+// For |x| >= 1/2, 1 - x**2 is computed as (1 - x)*(1 + x) to avoid the
+// cancellation.
+//
+
+inline DoubleDouble one_minus_square(const DoubleDouble& x)
+{
+    if (std::fabs(x.upper) < 0.5) {
+        return dd_fma(-x, x, 1.0);
+    }
+    return (1.0 - x)*(1.0 + x);
+}
+
+inline DoubleDouble DoubleDouble::asin() const
+{
+    DD_COUNT(asin);
+    if (!(std::fabs(upper) <= 1)) {
+        return DoubleDouble(NAN);
+    }
+    DoubleDouble c = one_minus_square(*this).sqrt();
+    return doubledouble::atan2(*this, c);
+}
+
+inline DoubleDouble DoubleDouble::acos() const
+{
+    DD_COUNT(acos);
+    if (!(std::fabs(upper) <= 1)) {
+        return DoubleDouble(NAN);
+    }
+    DoubleDouble s = one_minus_square(*this).sqrt();
+    return doubledouble::atan2(s, *this);
+}
+
+//
+// Hyperbolic functions.
+//
+// For small |x|, sinh(x), cosh(x) and tanh(x) are computed from
+// e = expm1(x) or e = expm1(2*x), using expm1_rational_approx():
+//
+//     sinh(x) = (e + e/(e + 1))/2,       |x| < 1/2, e = expm1(x)
+//     cosh(x) = 1 + e**2/(2*(e + 1)),    |x| < 1/2, e = expm1(x)
+//     tanh(x) = e/(e + 2),               |x| < 1/4, e = expm1(2*x)
+//
+// Otherwise they are computed from exp(|x|).  When exp(-2*|x|) is less
+// than 2**-108 (|x| > 37.5), the terms with exp(-|x|) are dropped, so
+// there is no division at all.  Just below the overflow threshold of
+// sinh and cosh, exp(|x|/2)**2/2 is used because exp(|x|) overflows.
+//
+// atanh(x) = log1p(2*x/(1 - x))/2.
+//
+
+#define HYPERBOLIC_BIG 37.5
+#define HYPERBOLIC_MAX_VALUE 710.475860073944
+
+// exp(a)/2 for 0 <= a <= HYPERBOLIC_MAX_VALUE.
+inline DoubleDouble half_exp(const DoubleDouble& a)
+{
+    if (a.upper > LOG_MAX_VALUE) {
+        DoubleDouble e = (a*0.5).exp();
+        return (e*0.5)*e;
+    }
+    return a.exp()*0.5;
+}
+
+inline DoubleDouble DoubleDouble::sinh() const
+{
+    DD_COUNT(sinh);
+    DoubleDouble a = abs();
+    DoubleDouble r;
+    if (a.upper < 0.5) {
+        DoubleDouble e = expm1_rational_approx(a);
+        r = (e + e/(e + 1.0))*0.5;
+    }
+    else if (a.upper < HYPERBOLIC_BIG) {
+        DoubleDouble e = a.exp();
+        r = e*0.5 - 0.5/e;
+    }
+    else if (a.upper <= HYPERBOLIC_MAX_VALUE) {
+        r = half_exp(a);
+    }
+    else if (std::isnan(a.upper)) {
+        return DoubleDouble(NAN);
+    }
+    else {
+        r = dd_inf;
+    }
+    return (upper < 0) ? -r : r;
+}
+
+inline DoubleDouble DoubleDouble::cosh() const
+{
+    DD_COUNT(cosh);
+    DoubleDouble a = abs();
+    if (a.upper < 0.5) {
+        DoubleDouble e = expm1_rational_approx(a);
+        return 1.0 + e.sqr()/((e + 1.0)*2.0);
+    }
+    if (a.upper < HYPERBOLIC_BIG) {
+        DoubleDouble e = a.exp();
+        return e*0.5 + 0.5/e;
+    }
+    if (a.upper <= HYPERBOLIC_MAX_VALUE) {
+        return half_exp(a);
+    }
+    return std::isnan(a.upper) ? DoubleDouble(NAN) : dd_inf;
+}
+
+inline DoubleDouble DoubleDouble::tanh() const
+{
+    DD_COUNT(tanh);
+    DoubleDouble a = abs();
+    DoubleDouble r;
+    if (a.upper < 0.25) {
+        DoubleDouble e = expm1_rational_approx(a*2.0);
+        r = e/(e + 2.0);
+    }
+    else if (a.upper < HYPERBOLIC_BIG) {
+        DoubleDouble e = (a*2.0).exp() - 1.0;
+        r = e/(e + 2.0);
+    }
+    else if (std::isnan(a.upper)) {
+        return DoubleDouble(NAN);
+    }
+    else {
+        r = dd_one;
+    }
+    return (upper < 0) ? -r : r;
+}
+
+inline DoubleDouble DoubleDouble::atanh() const
+{
+    DD_COUNT(atanh);
+    DoubleDouble a = abs();
+    if (!(a < 1.0)) {
+        if (a == 1.0) {
+            return (upper < 0) ? -dd_inf : dd_inf;
+        }
+        // |x| > 1 or NAN.
+        return DoubleDouble(NAN);
+    }
+    DoubleDouble r = ((a + a)/(1.0 - a)).log1p()*0.5;
+    return (upper < 0) ? -r : r;
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Additional functions
 //////////////////////////////////////////////////////////////////////////
 
 inline DoubleDouble hypot(const DoubleDouble& x, const DoubleDouble &y)
 {
+    DD_COUNT(hypot);
     if (std::isinf(x.upper) || std::isinf(y.upper)) {
         return dd_inf;
     }
@@ -704,20 +2473,60 @@ inline DoubleDouble hypot(const DoubleDouble& x, const DoubleDouble &y)
     }
     auto u = x/m;
     auto v = y/m;
-    return m*(u*u + v*v).sqrt();
+    return m*dd_fma(u, u, v.sqr()).sqrt();
 }
 
 //
-// dsum() sums an array of doubles. DoubleDouble is used internally.
+// dsum_dd() sums an array of doubles and returns the DoubleDouble sum.
+// dsum() returns the sum rounded to double.
+//
+// The sum is accumulated in DSUM_LANES independent DoubleDouble partial
+// sums: lane j accumulates x[j], x[j + DSUM_LANES], x[j + 2*DSUM_LANES],
+// etc.  The lanes do not depend on each other, so their updates can
+// overlap in the pipeline, and the compiler can vectorize the inner loop
+// over the lanes.  The partial sums are combined pairwise with
+// DoubleDouble addition at the end.  Each lane update is the same
+// computation as DoubleDouble::operator+(double), except that nonfinite
+// values are not canonicalized until the partial sums are combined.
 //
 
-inline double dsum(size_t n, const double *x)
+#define DSUM_LANES 32
+
+inline DoubleDouble dsum_dd(size_t n, const double *x)
 {
-    DoubleDouble sum{0.0, 0.0};
-    for (size_t i = 0; i < n; ++i) {
+    double su[DSUM_LANES] = {0.0};
+    double sl[DSUM_LANES] = {0.0};
+    size_t i = 0;
+    for (; i + DSUM_LANES <= n; i += DSUM_LANES) {
+        for (size_t j = 0; j < DSUM_LANES; ++j) {
+            double xj = x[i + j];
+            double r = su[j] + xj;
+            double t = r - su[j];
+            double e = (su[j] - (r - t)) + (xj - t);
+            e += sl[j];
+            su[j] = r + e;
+            sl[j] = e - (su[j] - r);
+        }
+    }
+    DoubleDouble lanes[DSUM_LANES];
+    for (size_t j = 0; j < DSUM_LANES; ++j) {
+        lanes[j] = DoubleDouble(su[j], sl[j], dd_unchecked);
+    }
+    for (size_t stride = DSUM_LANES/2; stride > 0; stride /= 2) {
+        for (size_t j = 0; j < stride; ++j) {
+            lanes[j] = lanes[j] + lanes[j + stride];
+        }
+    }
+    DoubleDouble sum = lanes[0];
+    for (; i < n; ++i) {
         sum = sum + x[i];
     }
-    return sum.upper;
+    return sum;
+}
+
+inline double dsum(size_t n, const double *x)
+{
+    return dsum_dd(n, x).upper;
 }
 
 inline double dsum(const std::vector<double>& x)
@@ -731,6 +2540,155 @@ inline double dsum(const std::array<double, N>& x)
     return dsum(x.size(), &x[0]);
 }
 
+//
+// dd_lanes_sum(n, term) returns the DoubleDouble sum of the terms
+// (tu, tl) produced by term(i, tu, tl) for i = 0, ..., n-1.  As in
+// dsum_dd(), the sum is accumulated in DSUM_LANES independent lanes; each
+// lane update is the computation of operator+(const DoubleDouble&), so it
+// is the accurate addition if DOUBLEDOUBLE_ACCURATE_ADD is defined (but a
+// nonfinite lane is not canonicalized until the lanes are combined).
+//
+
+template <typename Term>
+inline DoubleDouble dd_lanes_sum(size_t n, Term term)
+{
+    double su[DSUM_LANES] = {0.0};
+    double sl[DSUM_LANES] = {0.0};
+    size_t i = 0;
+    for (; i + DSUM_LANES <= n; i += DSUM_LANES) {
+        for (size_t j = 0; j < DSUM_LANES; ++j) {
+            double tu, tl;
+            term(i + j, tu, tl);
+            double r = su[j] + tu;
+            double t = r - su[j];
+            double e = (su[j] - (r - t)) + (tu - t);
+#ifdef DOUBLEDOUBLE_ACCURATE_ADD
+            double s = sl[j] + tl;
+            double v = s - sl[j];
+            double f = (sl[j] - (s - v)) + (tl - v);
+            e += s;
+            double r2 = r + e;
+            e = (e - (r2 - r)) + f;
+            r = r2;
+#else
+            e += sl[j] + tl;
+#endif
+            su[j] = r + e;
+            sl[j] = e - (su[j] - r);
+        }
+    }
+    DoubleDouble lanes[DSUM_LANES];
+    for (size_t j = 0; j < DSUM_LANES; ++j) {
+        lanes[j] = DoubleDouble(su[j], sl[j], dd_unchecked);
+    }
+    for (size_t stride = DSUM_LANES/2; stride > 0; stride /= 2) {
+        for (size_t j = 0; j < stride; ++j) {
+            lanes[j] = lanes[j] + lanes[j + stride];
+        }
+    }
+    DoubleDouble sum = lanes[0];
+    for (; i < n; ++i) {
+        double tu, tl;
+        term(i, tu, tl);
+        sum = sum + DoubleDouble(tu, tl, dd_unchecked);
+    }
+    return sum;
+}
+
+//
+// dsum_dd() and dsum() of an array of DoubleDouble sum the elements
+// with DoubleDouble accumulators (see dd_lanes_sum()).
+//
+
+inline DoubleDouble dsum_dd(size_t n, const DoubleDouble *x)
+{
+    return dd_lanes_sum(n, [=](size_t i, double& tu, double& tl) {
+        tu = x[i].upper;
+        tl = x[i].lower;
+    });
+}
+
+inline double dsum(size_t n, const DoubleDouble *x)
+{
+    return dsum_dd(n, x).upper;
+}
+
+//
+// ddot_dd() computes the dot product of two arrays and returns the
+// DoubleDouble result.  ddot() returns the result rounded to double.
+//
+// Each product x[i]*y[i] of doubles is computed exactly with
+// two_product(), and the products are summed with DoubleDouble
+// accumulators (see dd_lanes_sum()).  The result is accurate as if it
+// were computed in DoubleDouble precision, even when the dot product is
+// badly conditioned.
+//
+// In the strided versions, the elements used are x[i*incx] and y[i*incy]
+// for i = 0, ..., n-1.  With DoubleDouble operands, the term of each
+// product is the product of the upper parts plus its exact error
+// (dd_product_error()) and the cross terms (upper*lower; the product of
+// the lower parts is negligible).  The term is not renormalized before it
+// is added to the lane sums, which renormalize anyway.
+//
+
+inline DoubleDouble ddot_dd(size_t n, const double *x, const double *y)
+{
+    return dd_lanes_sum(n, [=](size_t i, double& tu, double& tl) {
+        tu = x[i]*y[i];
+        tl = dd_product_error(x[i], y[i], tu);
+    });
+}
+
+inline DoubleDouble ddot_dd(size_t n, const double *x, ptrdiff_t incx,
+                            const double *y, ptrdiff_t incy)
+{
+    return dd_lanes_sum(n, [=](size_t i, double& tu, double& tl) {
+        double xi = x[ptrdiff_t(i)*incx];
+        double yi = y[ptrdiff_t(i)*incy];
+        tu = xi*yi;
+        tl = dd_product_error(xi, yi, tu);
+    });
+}
+
+inline DoubleDouble ddot_dd(size_t n, const DoubleDouble *x, const double *y)
+{
+    return dd_lanes_sum(n, [=](size_t i, double& tu, double& tl) {
+        tu = x[i].upper*y[i];
+        tl = dd_product_error(x[i].upper, y[i], tu) + x[i].lower*y[i];
+    });
+}
+
+inline DoubleDouble ddot_dd(size_t n, const double *x, const DoubleDouble *y)
+{
+    return ddot_dd(n, y, x);
+}
+
+inline DoubleDouble ddot_dd(size_t n, const DoubleDouble *x,
+                            const DoubleDouble *y)
+{
+    return dd_lanes_sum(n, [=](size_t i, double& tu, double& tl) {
+        tu = x[i].upper*y[i].upper;
+        tl = dd_product_error(x[i].upper, y[i].upper, tu)
+             + (x[i].upper*y[i].lower + x[i].lower*y[i].upper);
+    });
+}
+
+inline double ddot(size_t n, const double *x, const double *y)
+{
+    return ddot_dd(n, x, y).upper;
+}
+
+inline double ddot(size_t n, const double *x, ptrdiff_t incx,
+                   const double *y, ptrdiff_t incy)
+{
+    return ddot_dd(n, x, incx, y, incy).upper;
+}
+
+inline double ddot(const std::vector<double>& x, const std::vector<double>& y)
+{
+    return ddot(x.size(), x.data(), y.data());
+}
+
 } // namespace
 
 #endif
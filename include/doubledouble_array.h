@@ -0,0 +1,367 @@
+//
+// Structure-of-arrays storage and batched arithmetic for DoubleDouble.
+// Copyright © 2022 Warren Weckesser
+//
+// MIT license:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the “Software”), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// DoubleDoubleArray stores the upper and lower parts of its elements in
+// two separate arrays, each aligned to DD_ARRAY_ALIGNMENT bytes.  dd_span
+// and dd_const_span are non-owning views of such a pair of arrays.
+//
+// The batched kernels dd_add(), dd_sub(), dd_mul(), dd_div(), dd_sqrt()
+// and dd_muladd() give results that are bit-for-bit identical to the
+// corresponding DoubleDouble operators applied element by element.  They
+// are written as loops with no dependences between elements, so the
+// compiler vectorizes them for whatever instruction set it targets.  The
+// instruction set is selected at compile time; e.g. compile with
+// `-O3 -mavx2 -mfma` for AVX2+FMA, `-O3 -mavx512f` for AVX-512, or
+// `-O3 -march=native`.  Without hardware FMA, the exact products are
+// computed with Dekker's algorithm (see dd_product_error() in
+// doubledouble.h), which is slower but still vectorized.  The sqrt
+// kernel is only vectorized when errno is not set by sqrt()
+// (`-fno-math-errno`).
+//
+// If DOUBLEDOUBLE_ACCURATE_ADD is defined, dd_add(), dd_sub() and the
+// addition in dd_muladd() use the accurate addition, like the operators.
+//
+// The output of a kernel may be the same as one of its inputs; otherwise
+// the output must not overlap the inputs.  All spans passed to a kernel
+// must have the same size.
+//
+
+#ifndef DOUBLEDOUBLE_ARRAY_H
+#define DOUBLEDOUBLE_ARRAY_H
+
+#include <cstddef>
+#include <cmath>
+#include <cfloat>
+#include <new>
+#include <algorithm>
+#include <vector>
+#include "doubledouble.h"
+
+namespace doubledouble {
+
+#define DD_ARRAY_ALIGNMENT 64
+
+struct dd_span
+{
+    double *upper;
+    double *lower;
+    std::size_t size;
+};
+
+struct dd_const_span
+{
+    const double *upper;
+    const double *lower;
+    std::size_t size;
+
+    constexpr dd_const_span(const double *upper, const double *lower,
+                            std::size_t size)
+        : upper(upper), lower(lower), size(size)
+    {}
+
+    constexpr dd_const_span(const dd_span& s)
+        : upper(s.upper), lower(s.lower), size(s.size)
+    {}
+};
+
+class DoubleDoubleArray
+{
+    std::size_t n{0};
+    double *hi{nullptr};
+    double *lo{nullptr};
+
+    static double *allocate(std::size_t n)
+    {
+        if (n == 0) {
+            return nullptr;
+        }
+        void *p = ::operator new(n*sizeof(double),
+                                 std::align_val_t(DD_ARRAY_ALIGNMENT));
+        return static_cast<double *>(p);
+    }
+
+    static void deallocate(double *p)
+    {
+        if (p != nullptr) {
+            ::operator delete(p, std::align_val_t(DD_ARRAY_ALIGNMENT));
+        }
+    }
+
+public:
+
+    DoubleDoubleArray() {}
+
+    // All elements are initialized to 0.
+    explicit DoubleDoubleArray(std::size_t n)
+        : n(n), hi(allocate(n)), lo(allocate(n))
+    {
+        std::fill(hi, hi + n, 0.0);
+        std::fill(lo, lo + n, 0.0);
+    }
+
+    explicit DoubleDoubleArray(const std::vector<DoubleDouble>& x)
+        : DoubleDoubleArray(x.size())
+    {
+        for (std::size_t i = 0; i < n; ++i) {
+            hi[i] = x[i].upper;
+            lo[i] = x[i].lower;
+        }
+    }
+
+    DoubleDoubleArray(const DoubleDoubleArray& other)
+        : n(other.n), hi(allocate(other.n)), lo(allocate(other.n))
+    {
+        std::copy(other.hi, other.hi + n, hi);
+        std::copy(other.lo, other.lo + n, lo);
+    }
+
+    DoubleDoubleArray(DoubleDoubleArray&& other) noexcept
+        : n(other.n), hi(other.hi), lo(other.lo)
+    {
+        other.n = 0;
+        other.hi = nullptr;
+        other.lo = nullptr;
+    }
+
+    DoubleDoubleArray& operator=(DoubleDoubleArray other) noexcept
+    {
+        std::swap(n, other.n);
+        std::swap(hi, other.hi);
+        std::swap(lo, other.lo);
+        return *this;
+    }
+
+    ~DoubleDoubleArray()
+    {
+        deallocate(hi);
+        deallocate(lo);
+    }
+
+    std::size_t size() const { return n; }
+
+    double *upper() { return hi; }
+    const double *upper() const { return hi; }
+    double *lower() { return lo; }
+    const double *lower() const { return lo; }
+
+    DoubleDouble operator[](std::size_t i) const
+    {
+        return DoubleDouble(hi[i], lo[i], dd_unchecked);
+    }
+
+    void set(std::size_t i, const DoubleDouble& x)
+    {
+        hi[i] = x.upper;
+        lo[i] = x.lower;
+    }
+
+    dd_span span() { return dd_span{hi, lo, n}; }
+    dd_const_span span() const { return dd_const_span(hi, lo, n); }
+
+    operator dd_span() { return span(); }
+    operator dd_const_span() const { return span(); }
+};
+
+//
+// The kernels below repeat the formulas of the corresponding operators
+// in doubledouble.h, with the last two_sum_quick() written out.  They
+// must be kept in sync with those operators.
+//
+// Every nonfinite result of two_sum_quick() is canonicalized by the
+// DoubleDouble(x, y) constructor to (NAN, NAN): the lower part of such a
+// result is always NAN or an INF with the opposite sign.  dd_store()
+// does that canonicalization with a select instead of a branch, so the
+// loops can still be vectorized.
+//
+
+inline void dd_store(double *upper, double *lower, std::size_t i,
+                     double x, double y)
+{
+    double r = x + y;
+    double e = y - (r - x);
+#ifndef DOUBLEDOUBLE_IGNORE_NONFINITE
+    bool finite = std::fabs(r) <= DBL_MAX;
+    r = finite ? r : NAN;
+    e = finite ? e : NAN;
+#endif
+    upper[i] = r;
+    lower[i] = e;
+}
+
+#ifdef DOUBLEDOUBLE_ACCURATE_ADD
+//
+// Given (r, e) = two_sum(xu, yu), dd_accurate_tail() adds xl + yl the way
+// DoubleDouble::add(y, dd_accurate) does, leaving the last two_sum_quick()
+// to dd_store().
+//
+inline void dd_accurate_tail(double& r, double& e, double xl, double yl)
+{
+    double s = xl + yl;
+    double t = s - xl;
+    double f = (xl - (s - t)) + (yl - t);
+    e += s;
+    double r2 = r + e;
+    e = (e - (r2 - r)) + f;
+    r = r2;
+}
+#endif
+
+inline void dd_add(dd_span z, dd_const_span x, dd_const_span y)
+{
+    DD_COUNT_N(add, z.size);
+    for (std::size_t i = 0; i < z.size; ++i) {
+        double xu = x.upper[i];
+        double yu = y.upper[i];
+        double r = xu + yu;
+        double t = r - xu;
+        double e = (xu - (r - t)) + (yu - t);
+#ifdef DOUBLEDOUBLE_ACCURATE_ADD
+        dd_accurate_tail(r, e, x.lower[i], y.lower[i]);
+#else
+        e += x.lower[i] + y.lower[i];
+#endif
+        dd_store(z.upper, z.lower, i, r, e);
+    }
+}
+
+inline void dd_sub(dd_span z, dd_const_span x, dd_const_span y)
+{
+    DD_COUNT_N(sub, z.size);
+    for (std::size_t i = 0; i < z.size; ++i) {
+        double xu = x.upper[i];
+        double yu = y.upper[i];
+        double r = xu - yu;
+        double t = r - xu;
+        double e = (xu - (r - t)) - (yu + t);
+#ifdef DOUBLEDOUBLE_ACCURATE_ADD
+        dd_accurate_tail(r, e, x.lower[i], -y.lower[i]);
+#else
+        e += x.lower[i] - y.lower[i];
+#endif
+        dd_store(z.upper, z.lower, i, r, e);
+    }
+}
+
+inline void dd_mul(dd_span z, dd_const_span x, dd_const_span y)
+{
+    DD_COUNT_N(mul, z.size);
+    for (std::size_t i = 0; i < z.size; ++i) {
+        double xu = x.upper[i];
+        double yu = y.upper[i];
+        double r = xu*yu;
+        double e = dd_product_error(xu, yu, r);
+        e += xu*y.lower[i] + x.lower[i]*yu;
+        dd_store(z.upper, z.lower, i, r, e);
+    }
+}
+
+inline void dd_div(dd_span z, dd_const_span x, dd_const_span y)
+{
+    DD_COUNT_N(div, z.size);
+    for (std::size_t i = 0; i < z.size; ++i) {
+        double xu = x.upper[i];
+        double yu = y.upper[i];
+        double r = xu/yu;
+        double p = r*yu;
+        double pe = dd_product_error(r, yu, p);
+        double e = (xu - p - pe + x.lower[i] - r*y.lower[i])/yu;
+        dd_store(z.upper, z.lower, i, r, e);
+    }
+}
+
+inline void dd_sqrt(dd_span z, dd_const_span x)
+{
+    DD_COUNT_N(sqrt, z.size);
+    for (std::size_t i = 0; i < z.size; ++i) {
+        double xu = x.upper[i];
+        double xl = x.lower[i];
+        bool zero = (xu == 0 && xl == 0);
+        double r = std::sqrt(xu);
+        double p = r*r;
+        double pe = dd_product_error(r, r, p);
+        double e = (xu - p - pe + xl) * 0.5 / r;
+        // DoubleDouble::sqrt() returns dd_zero when x is zero.
+        r = zero ? 0.0 : r;
+        e = zero ? 0.0 : e;
+        dd_store(z.upper, z.lower, i, r, e);
+    }
+}
+
+//
+// dd_muladd() computes w = x*y + z, with the same rounding as the
+// expression x*y + z evaluated with the DoubleDouble operators.
+//
+inline void dd_muladd(dd_span w, dd_const_span x, dd_const_span y,
+                      dd_const_span z)
+{
+    DD_COUNT_N(mul, w.size);
+    DD_COUNT_N(add, w.size);
+    for (std::size_t i = 0; i < w.size; ++i) {
+        double xu = x.upper[i];
+        double yu = y.upper[i];
+        // p = x*y
+        double p = xu*yu;
+        double pe = dd_product_error(xu, yu, p);
+        pe += xu*y.lower[i] + x.lower[i]*yu;
+        double pu = p + pe;
+        double pl = pe - (pu - p);
+        // If pu is not finite, operator* would canonicalize x*y to
+        // (NAN, NAN).  The sum below then gives a nonfinite r, so
+        // dd_store() produces (NAN, NAN) in that case, too.
+        // p + z
+        double zu = z.upper[i];
+        double r = pu + zu;
+        double t = r - pu;
+        double e = (pu - (r - t)) + (zu - t);
+#ifdef DOUBLEDOUBLE_ACCURATE_ADD
+        dd_accurate_tail(r, e, pl, z.lower[i]);
+#else
+        e += pl + z.lower[i];
+#endif
+        dd_store(w.upper, w.lower, i, r, e);
+    }
+}
+
+//
+// dsum_dd() returns the DoubleDouble sum of the elements of x, and dsum()
+// returns the sum rounded to double (see dd_lanes_sum()).
+//
+
+inline DoubleDouble dsum_dd(dd_const_span x)
+{
+    return dd_lanes_sum(x.size, [=](size_t i, double& tu, double& tl) {
+        tu = x.upper[i];
+        tl = x.lower[i];
+    });
+}
+
+inline double dsum(dd_const_span x)
+{
+    return dsum_dd(x).upper;
+}
+
+} // namespace
+
+#endif
@@ -0,0 +1,1270 @@
+//
+// Decimal conversion for DoubleDouble.
+// Copyright © 2022 Warren Weckesser
+//
+// MIT license:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the “Software”), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// dd_parse(first, last, value) converts a decimal number to the
+// DoubleDouble (upper, lower) where upper is the double nearest to the
+// number and lower is the double nearest to the rest, i.e. the same pair
+// as the one computed with mpmath by tools/expm1_coeffs.py.  The
+// conversion uses exact integer arithmetic, and everything is constexpr,
+// so with the literal operator _dd in the namespace
+// doubledouble::literals,
+//
+//     using namespace doubledouble::literals;
+//     constexpr DoubleDouble tenth = 0.1_dd;
+//     constexpr DoubleDouble pi = "3.14159265358979323846264338327950288"_dd;
+//
+// costs nothing at run time.  (Without constexpr, the compiler is not
+// required to evaluate the literal at compile time.)
+//
+// The syntax is that of strtod() for decimal numbers, without leading
+// white space: an optional sign, digits with an optional decimal point
+// and an optional exponent, or "inf", "infinity" or "nan" (in any case).
+// A numeric literal may contain digit separators (').  The result is
+// correctly rounded for numbers with up to dd_parse_max_digits
+// significant digits; further digits only decide the rounding of a
+// number that is (almost) halfway between two results.
+//
+// to_chars() and from_chars() have the interface of the functions in
+// <charconv>.  to_chars(first, last, x) writes the shortest number that
+// is converted back to x, and to_chars(first, last, x, precision) writes
+// x correctly rounded to precision significant digits.  The integers are
+// on the stack, with a smaller type for the usual exponents, so nothing
+// is allocated.
+//
+
+#ifndef DOUBLEDOUBLE_DECIMAL_H
+#define DOUBLEDOUBLE_DECIMAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <charconv>
+#include <system_error>
+#include "doubledouble.h"
+
+namespace doubledouble {
+
+//
+// Unsigned integer with up to 32*Capacity bits, for the exact arithmetic
+// of the decimal conversions.  Only the operations that they need are
+// implemented.
+//
+template <int Capacity>
+struct dd_bigint_n
+{
+    static constexpr int capacity = Capacity;
+
+    std::uint32_t w[capacity] = {};
+    // The number of words in use; w[size - 1] != 0 if size > 0.
+    int size = 0;
+
+    constexpr dd_bigint_n() {}
+
+    constexpr explicit dd_bigint_n(std::uint64_t x)
+    {
+        w[0] = std::uint32_t(x);
+        w[1] = std::uint32_t(x >> 32);
+        size = 2;
+        trim();
+    }
+
+    // Requires x.size <= capacity.
+    template <int M>
+    constexpr explicit dd_bigint_n(const dd_bigint_n<M>& x)
+    {
+        for (int i = 0; i < x.size; ++i) {
+            w[i] = x.w[i];
+        }
+        size = x.size;
+    }
+
+    constexpr void trim()
+    {
+        while (size > 0 && w[size - 1] == 0) {
+            --size;
+        }
+    }
+
+    constexpr bool is_zero() const
+    {
+        return size == 0;
+    }
+
+    constexpr int bit_length() const
+    {
+        if (size == 0) {
+            return 0;
+        }
+        int n = 32*(size - 1) + 1;
+        std::uint32_t t = w[size - 1];
+        for (int b = 16; b > 0; b /= 2) {
+            if (t >> b != 0) {
+                t >>= b;
+                n += b;
+            }
+        }
+        return n;
+    }
+
+    // *this = (*this)*m + a
+    constexpr void mul_add(std::uint32_t m, std::uint32_t a)
+    {
+        std::uint64_t carry = a;
+        for (int i = 0; i < size; ++i) {
+            std::uint64_t t = std::uint64_t(w[i])*m + carry;
+            w[i] = std::uint32_t(t);
+            carry = t >> 32;
+        }
+        if (carry != 0) {
+            w[size++] = std::uint32_t(carry);
+        }
+        trim();
+    }
+
+    // *this = (*this)*10**n
+    constexpr void mul_pow10(int n)
+    {
+        for (; n >= 9; n -= 9) {
+            mul_add(1000000000, 0);
+        }
+        std::uint32_t p = 1;
+        for (; n > 0; --n) {
+            p *= 10;
+        }
+        mul_add(p, 0);
+    }
+
+    constexpr void shift_left(int n)
+    {
+        if (size == 0 || n == 0) {
+            return;
+        }
+        int words = n/32;
+        int bits = n % 32;
+        int new_size = size + words + 1;
+        if (new_size > capacity) {
+            new_size = capacity;
+        }
+        for (int i = new_size - 1; i >= words; --i) {
+            int j = i - words;
+            std::uint32_t hi = j < size ? w[j] : 0;
+            std::uint32_t lo = (j >= 1 && j - 1 < size) ? w[j - 1] : 0;
+            w[i] = bits == 0 ? hi : (hi << bits) | (lo >> (32 - bits));
+        }
+        for (int i = 0; i < words; ++i) {
+            w[i] = 0;
+        }
+        size = new_size;
+        trim();
+    }
+
+    // *this >>= n; returns true if any of the bits shifted out is 1.
+    constexpr bool shift_right(int n)
+    {
+        int words = n/32;
+        int bits = n % 32;
+        bool lost = false;
+        for (int i = 0; i < words && i < size; ++i) {
+            lost = lost || w[i] != 0;
+        }
+        if (words >= size) {
+            size = 0;
+            return lost;
+        }
+        if (bits != 0 && (w[words] & ((std::uint32_t(1) << bits) - 1)) != 0) {
+            lost = true;
+        }
+        for (int i = 0; i + words < size; ++i) {
+            std::uint32_t lo = w[i + words] >> bits;
+            std::uint32_t hi = (bits != 0 && i + words + 1 < size)
+                               ? w[i + words + 1] << (32 - bits) : 0;
+            w[i] = lo | hi;
+        }
+        size -= words;
+        trim();
+        return lost;
+    }
+
+    // *this /= d; returns the remainder.
+    constexpr std::uint32_t div_small(std::uint32_t d)
+    {
+        // A division by a constant is much faster.
+        if (d == 1000000000) {
+            return div_small_by<1000000000>();
+        }
+        std::uint64_t r = 0;
+        for (int i = size - 1; i >= 0; --i) {
+            std::uint64_t t = (r << 32) | w[i];
+            w[i] = std::uint32_t(t/d);
+            r = t % d;
+        }
+        trim();
+        return std::uint32_t(r);
+    }
+
+    template <std::uint32_t d>
+    constexpr std::uint32_t div_small_by()
+    {
+        std::uint64_t r = 0;
+        for (int i = size - 1; i >= 0; --i) {
+            std::uint64_t t = (r << 32) | w[i];
+            w[i] = std::uint32_t(t/d);
+            r = t % d;
+        }
+        trim();
+        return std::uint32_t(r);
+    }
+
+    // *this += x
+    constexpr void add(const dd_bigint_n& x)
+    {
+        int n = size > x.size ? size : x.size;
+        std::uint64_t carry = 0;
+        for (int i = 0; i < n; ++i) {
+            std::uint64_t t = carry + (i < size ? w[i] : 0)
+                              + (i < x.size ? x.w[i] : 0);
+            w[i] = std::uint32_t(t);
+            carry = t >> 32;
+        }
+        size = n;
+        if (carry != 0) {
+            w[size++] = std::uint32_t(carry);
+        }
+    }
+
+    // *this -= x; requires *this >= x.
+    constexpr void subtract(const dd_bigint_n& x)
+    {
+        std::int64_t borrow = 0;
+        for (int i = 0; i < size; ++i) {
+            std::int64_t t = std::int64_t(w[i]) - borrow
+                             - (i < x.size ? x.w[i] : 0);
+            borrow = t < 0;
+            w[i] = std::uint32_t(t + (borrow << 32));
+        }
+        trim();
+    }
+
+    // *this -= 2**n; requires *this >= 2**n.
+    constexpr void subtract_pow2(int n)
+    {
+        int i = n/32;
+        std::uint32_t b = std::uint32_t(1) << (n % 32);
+        for (; w[i] < b; ++i) {
+            w[i] -= b;
+            b = 1;
+        }
+        w[i] -= b;
+        trim();
+    }
+
+    // *this += 2**n
+    constexpr void add_pow2(int n)
+    {
+        int i = n/32;
+        for (; size <= i; ++size) {
+            w[size] = 0;
+        }
+        std::uint32_t b = std::uint32_t(1) << (n % 32);
+        for (; i < size && std::uint32_t(w[i] + b) < b; ++i) {
+            w[i] += b;
+            b = 1;
+        }
+        if (i == size) {
+            w[size++] = 1;
+        }
+        else {
+            w[i] += b;
+        }
+    }
+
+    // *this = (*this)*m
+    constexpr void mul_u64(std::uint64_t m)
+    {
+        std::uint32_t m0 = std::uint32_t(m);
+        std::uint32_t m1 = std::uint32_t(m >> 32);
+        if (m1 == 0) {
+            mul_add(m0, 0);
+            return;
+        }
+        std::uint64_t c0 = 0;
+        std::uint64_t c1 = 0;
+        std::uint32_t prev = 0;
+        int n = size + 2 < capacity ? size + 2 : capacity;
+        for (int i = 0; i < n; ++i) {
+            std::uint32_t wi = i < size ? w[i] : 0;
+            std::uint64_t t0 = std::uint64_t(wi)*m0 + c0;
+            c0 = t0 >> 32;
+            std::uint64_t t1 = std::uint64_t(prev)*m1 + c1 + std::uint32_t(t0);
+            c1 = t1 >> 32;
+            w[i] = std::uint32_t(t1);
+            prev = wi;
+        }
+        size = n;
+        trim();
+    }
+
+    // The leading 64 bits: returns *this >> s, with
+    // s = max(bit_length() - 64, 0).
+    constexpr std::uint64_t leading_bits(int& s) const
+    {
+        int n = bit_length();
+        s = n > 64 ? n - 64 : 0;
+        int words = s/32;
+        int bits = s % 32;
+        std::uint64_t x0 = words < size ? w[words] : 0;
+        std::uint64_t x1 = words + 1 < size ? w[words + 1] : 0;
+        std::uint64_t x2 = words + 2 < size ? w[words + 2] : 0;
+        if (bits == 0) {
+            return x0 | (x1 << 32);
+        }
+        return (x0 >> bits) | (x1 << (32 - bits)) | (x2 << (64 - bits));
+    }
+};
+
+//
+// The integers in the conversion of a number with a moderate exponent fit
+// in a dd_bigint_small; dd_bigint is large enough for all numbers.  The
+// conversions use the smaller type when they can, because it is faster
+// to create and copy.
+//
+using dd_bigint_small = dd_bigint_n<24>;
+using dd_bigint = dd_bigint_n<168>;
+
+// Returns -1, 0 or 1 as x < y, x == y or x > y.
+template <typename Bigint>
+constexpr int dd_bigint_compare(const Bigint& x, const Bigint& y)
+{
+    if (x.size != y.size) {
+        return x.size < y.size ? -1 : 1;
+    }
+    for (int i = x.size - 1; i >= 0; --i) {
+        if (x.w[i] != y.w[i]) {
+            return x.w[i] < y.w[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+// x*2**e, for a result that is a double; exact.
+constexpr double dd_scale2(double x, int e)
+{
+    if (!dd_is_constant_evaluated() && -1022 <= e && e <= 1023) {
+        std::uint64_t bits = std::uint64_t(e + 1023) << 52;
+        double p = 0.0;
+        std::memcpy(&p, &bits, sizeof p);
+        return x*p;
+    }
+    double p = e > 0 ? 2.0 : 0.5;
+    for (int n = e > 0 ? e : -e; n != 0; n >>= 1) {
+        if (n & 1) {
+            x *= p;
+        }
+        if (n > 1) {
+            p *= p;
+        }
+    }
+    return x;
+}
+
+//
+// a/b (a, b > 0) rounded to the nearest double (ties to even):
+// value = m*2**e, or INFINITY (m = 0) if it overflows.
+//
+struct dd_rounded_quotient
+{
+    double value;
+    std::uint64_t m;
+    int e;
+};
+
+template <typename Bigint>
+constexpr dd_rounded_quotient dd_round_quotient(Bigint a, Bigint b)
+{
+    // Scale so that 2**54 < a/b < 2**56; then a/b = q*2**-k with the
+    // 55 or 56 bit integer q = floor(a/b).
+    int k = 55 - a.bit_length() + b.bit_length();
+    if (k > 0) {
+        a.shift_left(k);
+    }
+    else {
+        b.shift_left(-k);
+    }
+    // The quotient of the leading 64 bits of a and b, computed with
+    // DoubleDouble division, is within 1 of q.
+    auto to_dd = [](std::uint64_t n) {
+        return two_sum(double(n >> 32)*4294967296.0,
+                       double(n & 0xffffffff));
+    };
+    int sa = 0;
+    int sb = 0;
+    DoubleDouble qa = to_dd(a.leading_bits(sa))/to_dd(b.leading_bits(sb));
+    const double scale = dd_scale2(1.0, sa - sb);
+    std::uint64_t q = std::uint64_t(qa.upper*scale);
+    double ql = qa.lower*scale;
+    q += ql < 0 ? -std::uint64_t(-ql) : std::uint64_t(ql);
+    Bigint qb = b;
+    qb.mul_u64(q);
+    while (dd_bigint_compare(qb, a) > 0) {
+        qb.subtract(b);
+        --q;
+    }
+    a.subtract(qb);
+    while (dd_bigint_compare(a, b) >= 0) {
+        a.subtract(b);
+        ++q;
+    }
+    bool sticky = !a.is_zero();
+    const int bits = q >> 55 != 0 ? 56 : 55;
+
+    // The unit of the last place of the result is 2**(d - k), where d is
+    // bits - 53 for a normal result, and larger for a subnormal result.
+    int d = -1074 + k > bits - 53 ? -1074 + k : bits - 53;
+    if (d > 56) {
+        // a/b < 2**-1076
+        return {0.0, 0, 0};
+    }
+    std::uint64_t m = q >> d;
+    std::uint64_t rem = q & ((std::uint64_t(1) << d) - 1);
+    std::uint64_t half = std::uint64_t(1) << (d - 1);
+    if (rem > half || (rem == half && (sticky || (m & 1) == 1))) {
+        ++m;
+    }
+    // m <= 2**53, so the exponent of the result is at most e + 53.
+    int e = d - k;
+    if (e + (m >> 53 != 0 ? 53 : 52) > 1023) {
+        return {INFINITY, 0, 0};
+    }
+    return {dd_scale2(double(m), e), m, e};
+}
+
+// Significant digits beyond this number are replaced by a single digit 1
+// if any of them is not 0.
+inline constexpr int dd_parse_max_digits = 800;
+
+constexpr char dd_parse_lower(char c)
+{
+    return ('A' <= c && c <= 'Z') ? char(c - 'A' + 'a') : c;
+}
+
+// If [p, last) starts with word (in any case), returns the end of the
+// match, else p.
+constexpr const char *dd_parse_word(const char *p, const char *last,
+                                    const char *word)
+{
+    const char *q = p;
+    for (; *word != '\0'; ++word, ++q) {
+        if (q == last || dd_parse_lower(*q) != *word) {
+            return p;
+        }
+    }
+    return q;
+}
+
+//
+// m*10**exp10 as a DoubleDouble, computed with the integer type Bigint.
+// m is the integer of the n_digits digits that start at digits (skipping
+// the other characters), followed by a digit 1 if dropped is true.
+//
+template <typename Bigint>
+constexpr DoubleDouble dd_parse_value(const char *digits, int n_digits,
+                                      bool dropped, int exp10)
+{
+    // The digits are collected in chunk, up to 9 at a time, before they
+    // are added to num.
+    Bigint num;
+    std::uint32_t chunk = 0;
+    int chunk_digits = 0;
+    for (const char *p = digits; n_digits > 0; ++p) {
+        if (*p < '0' || *p > '9') {
+            continue;
+        }
+        if (chunk_digits == 9) {
+            num.mul_add(1000000000, chunk);
+            chunk = 0;
+            chunk_digits = 0;
+        }
+        chunk = 10*chunk + std::uint32_t(*p - '0');
+        ++chunk_digits;
+        --n_digits;
+    }
+    num.mul_pow10(chunk_digits);
+    num.mul_add(1, chunk);
+    if (dropped) {
+        num.mul_add(10, 1);
+    }
+
+    // The number is num/den.
+    Bigint den(1);
+    if (exp10 >= 0) {
+        num.mul_pow10(exp10);
+    }
+    else {
+        den.mul_pow10(-exp10);
+    }
+    dd_rounded_quotient hi = dd_round_quotient(num, den);
+    if (hi.m == 0) {
+        return DoubleDouble(hi.value, 0.0, dd_unchecked);
+    }
+
+    // The rest num/den - hi.m*2**hi.e is rounded to give the lower part.
+    Bigint h = den;
+    if (hi.e >= 0) {
+        h.mul_u64(hi.m);
+        h.shift_left(hi.e);
+    }
+    else {
+        num.shift_left(-hi.e);
+        den.shift_left(-hi.e);
+        h.mul_u64(hi.m);
+    }
+    double lo = 0.0;
+    int c = dd_bigint_compare(num, h);
+    if (c > 0) {
+        num.subtract(h);
+        lo = dd_round_quotient(num, den).value;
+    }
+    else if (c < 0) {
+        h.subtract(num);
+        lo = -dd_round_quotient(h, den).value;
+    }
+    return DoubleDouble(hi.value, lo, dd_unchecked);
+}
+
+//
+// Converts the number at the beginning of [first, last) and returns a
+// pointer to the first character after it.  If there is no number there,
+// first is returned and value is not changed.
+//
+constexpr const char *dd_parse(const char *first, const char *last,
+                               DoubleDouble& value)
+{
+    const char *p = first;
+    bool negative = false;
+    if (p != last && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        ++p;
+    }
+    const double sign = negative ? -1.0 : 1.0;
+
+    const char *q = dd_parse_word(p, last, "inf");
+    if (q != p) {
+        const char *r = dd_parse_word(q, last, "inity");
+        value = DoubleDouble(sign*INFINITY, 0.0, dd_unchecked);
+        return r;
+    }
+    q = dd_parse_word(p, last, "nan");
+    if (q != p) {
+        value = DoubleDouble(NAN);
+        return q;
+    }
+
+    // The number is m*10**exp10, where m is the integer of the n_digits
+    // significant digits that start at digits.  Trailing zeros of the
+    // significand are counted in zeros and become part of m only if
+    // another digit follows.
+    const char *digits = p;
+    int n_digits = 0;
+    int zeros = 0;
+    bool dropped = false;
+    long exp10 = 0;
+    bool any_digits = false;
+    bool point = false;
+    for (; p != last; ++p) {
+        char c = *p;
+        if (c == '.' && !point) {
+            point = true;
+            continue;
+        }
+        if (c == '\'' && any_digits) {
+            continue;
+        }
+        if (c < '0' || c > '9') {
+            break;
+        }
+        any_digits = true;
+        if (point) {
+            --exp10;
+        }
+        if (c == '0') {
+            ++zeros;
+            continue;
+        }
+        if (n_digits == 0) {
+            digits = p;
+            zeros = 0;
+        }
+        if (n_digits + zeros + 1 > dd_parse_max_digits) {
+            exp10 += zeros + 1;
+            zeros = 0;
+            dropped = true;
+            continue;
+        }
+        n_digits += zeros + 1;
+        zeros = 0;
+    }
+    if (!any_digits) {
+        return first;
+    }
+    exp10 += zeros;
+    // The dropped digits count as a 1 in the place after the last stored
+    // digit.
+    const int n_total = dropped ? n_digits + 1 : n_digits;
+    if (dropped) {
+        --exp10;
+    }
+
+    if (p != last && (*p == 'e' || *p == 'E')) {
+        const char *r = p + 1;
+        bool exp_negative = false;
+        if (r != last && (*r == '+' || *r == '-')) {
+            exp_negative = *r == '-';
+            ++r;
+        }
+        if (r != last && '0' <= *r && *r <= '9') {
+            long e = 0;
+            for (; r != last && '0' <= *r && *r <= '9'; ++r) {
+                if (e < 100000) {
+                    e = 10*e + (*r - '0');
+                }
+            }
+            exp10 += exp_negative ? -e : e;
+            p = r;
+        }
+    }
+
+    if (n_digits == 0) {
+        value = DoubleDouble(sign*0.0, 0.0, dd_unchecked);
+        return p;
+    }
+    if (exp10 + n_total - 1 > 308) {
+        value = DoubleDouble(sign*INFINITY, 0.0, dd_unchecked);
+        return p;
+    }
+    if (exp10 + n_total < -343) {
+        value = DoubleDouble(sign*0.0, 0.0, dd_unchecked);
+        return p;
+    }
+
+    // The integers in dd_parse_value() have at most about b_m + 2*b_p + 200
+    // bits, where b_m and b_p are the bit lengths of m and 10**|exp10|.
+    long b_m = 10*n_total/3 + 1;
+    long b_p = 10*(exp10 < 0 ? -exp10 : exp10)/3 + 1;
+    if (b_m + 2*b_p + 256 <= 32*dd_bigint_small::capacity) {
+        value = dd_parse_value<dd_bigint_small>(digits, n_digits, dropped,
+                                                int(exp10));
+    }
+    else {
+        value = dd_parse_value<dd_bigint>(digits, n_digits, dropped,
+                                          int(exp10));
+    }
+    if (negative) {
+        value = DoubleDouble(-value.upper, -value.lower, dd_unchecked);
+    }
+    return p;
+}
+
+//
+// Conversion to decimal.
+//
+// The exact value of a DoubleDouble is a multiple of a power of 2, so it
+// is converted with the same integer arithmetic as in dd_parse():
+// the digits of floor(|x|*10**t) for a suitable t, with a flag for a
+// nonzero rest, and then rounding to nearest, ties to even.  The
+// integers are of the size of the exponent range that is used, so there
+// is no allocation.
+//
+
+//
+// x = m*2**e for x > 0, with 2**52 <= m < 2**53 unless x is subnormal.
+//
+inline void dd_decompose(double x, std::uint64_t& m, int& e)
+{
+    int ex = 0;
+    double f = std::frexp(x, &ex);
+    m = std::uint64_t(std::ldexp(f, 53));
+    e = ex - 53;
+    if (e < -1074) {
+        m >>= -1074 - e;
+        e = -1074;
+    }
+}
+
+//
+// a = floor(a*2**e*10**t); inexact is set to true if that is not
+// a*2**e*10**t.
+//
+template <typename Bigint>
+void dd_scale_floor(Bigint& a, int e, int t, bool& inexact)
+{
+    inexact = false;
+    if (t > 0) {
+        a.mul_pow10(t);
+    }
+    if (e > 0) {
+        a.shift_left(e);
+    }
+    else if (e < 0) {
+        inexact = a.shift_right(-e);
+    }
+    for (; t <= -9; t += 9) {
+        inexact = (a.div_small(1000000000) != 0) || inexact;
+    }
+    if (t < 0) {
+        std::uint32_t p = 1;
+        for (; t < 0; ++t) {
+            p *= 10;
+        }
+        inexact = (a.div_small(p) != 0) || inexact;
+    }
+}
+
+//
+// a = a*2**e*10**t rounded to the nearest integer, ties to even.
+//
+template <typename Bigint>
+void dd_scale_round(Bigint& a, int e, int t)
+{
+    bool inexact = false;
+    dd_scale_floor(a, e + 1, t, inexact);
+    bool half = (a.size > 0) && (a.w[0] & 1) == 1;
+    a.shift_right(1);
+    if (half && (inexact || (a.size > 0 && (a.w[0] & 1) == 1))) {
+        a.add_pow2(0);
+    }
+}
+
+// The maximum number of decimal digits of a dd_bigint.
+inline constexpr int dd_bigint_max_digits = dd_bigint::capacity*32*31/100 + 1;
+
+//
+// Writes the decimal digits of n > 0 to digits and returns their number.
+// n is destroyed.
+//
+template <typename Bigint>
+int dd_bigint_digits(Bigint& n, char *digits)
+{
+    std::uint32_t chunk[dd_bigint_max_digits/9 + 1];
+    int nchunks = 0;
+    while (!n.is_zero()) {
+        chunk[nchunks++] = n.div_small(1000000000);
+    }
+    int len = 0;
+    for (std::uint32_t c = chunk[nchunks - 1]; c != 0; c /= 10) {
+        ++len;
+    }
+    for (int i = len - 1, c = int(chunk[nchunks - 1]); i >= 0; --i, c /= 10) {
+        digits[i] = char('0' + c % 10);
+    }
+    for (int k = nchunks - 2; k >= 0; --k) {
+        std::uint32_t c = chunk[k];
+        for (int i = 8; i >= 0; --i, c /= 10) {
+            digits[len + i] = char('0' + c % 10);
+        }
+        len += 9;
+    }
+    return len;
+}
+
+//
+// Writes "inf", "nan" or the number digits[0]...digits[n-1] * 10**(exp10
+// - n + 1), in scientific format, or in fixed format if that is not
+// longer and scientific_only is false.
+//
+inline std::to_chars_result dd_write_decimal(char *first, char *last,
+                                             bool negative,
+                                             const char *digits, int n,
+                                             int exp10, bool scientific_only)
+{
+    int sign_len = negative ? 1 : 0;
+    int abs_exp = exp10 < 0 ? -exp10 : exp10;
+    int exp_digits = abs_exp >= 100 ? 3 : 2;
+    int sci_len = n + (n > 1 ? 1 : 0) + 2 + exp_digits;
+    int fixed_len = 0;
+    if (exp10 >= n - 1) {
+        fixed_len = exp10 + 1;
+    }
+    else if (exp10 >= 0) {
+        fixed_len = n + 1;
+    }
+    else {
+        fixed_len = n + 1 - exp10;
+    }
+    bool fixed = !scientific_only && fixed_len <= sci_len;
+    int len = sign_len + (fixed ? fixed_len : sci_len);
+    if (last - first < len) {
+        return {last, std::errc::value_too_large};
+    }
+    char *p = first;
+    if (negative) {
+        *p++ = '-';
+    }
+    if (fixed) {
+        if (exp10 < 0) {
+            *p++ = '0';
+            *p++ = '.';
+            for (int i = 0; i < -exp10 - 1; ++i) {
+                *p++ = '0';
+            }
+            for (int i = 0; i < n; ++i) {
+                *p++ = digits[i];
+            }
+        }
+        else {
+            for (int i = 0; i <= exp10; ++i) {
+                *p++ = i < n ? digits[i] : '0';
+            }
+            if (n > exp10 + 1) {
+                *p++ = '.';
+                for (int i = exp10 + 1; i < n; ++i) {
+                    *p++ = digits[i];
+                }
+            }
+        }
+    }
+    else {
+        *p++ = digits[0];
+        if (n > 1) {
+            *p++ = '.';
+            for (int i = 1; i < n; ++i) {
+                *p++ = digits[i];
+            }
+        }
+        *p++ = 'e';
+        *p++ = exp10 < 0 ? '-' : '+';
+        for (int i = exp_digits - 1, e = abs_exp; i >= 0; --i, e /= 10) {
+            p[i] = char('0' + e % 10);
+        }
+        p += exp_digits;
+    }
+    return {p, std::errc{}};
+}
+
+inline std::to_chars_result dd_write_special(char *first, char *last,
+                                             double x)
+{
+    const char *s = std::isnan(x) ? "nan" : (x < 0 ? "-inf" : (x > 0 ? "inf"
+                                              : (std::signbit(x) ? "-0" : "0")));
+    std::size_t len = std::strlen(s);
+    if (std::size_t(last - first) < len) {
+        return {last, std::errc::value_too_large};
+    }
+    std::memcpy(first, s, len);
+    return {first + len, std::errc{}};
+}
+
+//
+// |x| = X*2**e, with e = min(eh - 2, el - 2, e_max), where eh and el
+// are the exponents of the upper and lower parts.  dd_exact() computes
+// everything except X, so that the size of the integers can be chosen
+// before X is computed with dd_exact_int().
+//
+struct dd_exact_value
+{
+    int e;
+    std::uint64_t mh, ml;
+    int eh, el;
+    // The sign of lower relative to upper: 1, -1 or 0 (lower == 0).
+    int lsign;
+};
+
+inline void dd_exact(const DoubleDouble& x, int e_max, dd_exact_value& v)
+{
+    dd_decompose(std::fabs(x.upper), v.mh, v.eh);
+    v.lsign = 0;
+    v.ml = 0;
+    v.el = v.eh;
+    if (x.lower != 0) {
+        dd_decompose(std::fabs(x.lower), v.ml, v.el);
+        v.lsign = (x.lower < 0) == (x.upper < 0) ? 1 : -1;
+    }
+    v.e = (v.el < v.eh ? v.el : v.eh) - 2;
+    if (v.e > e_max) {
+        v.e = e_max;
+    }
+}
+
+template <typename Bigint>
+Bigint dd_exact_int(const dd_exact_value& v)
+{
+    Bigint X(v.mh);
+    X.shift_left(v.eh - v.e);
+    if (v.lsign != 0) {
+        Bigint l(v.ml);
+        l.shift_left(v.el - v.e);
+        if (v.lsign > 0) {
+            X.add(l);
+        }
+        else {
+            X.subtract(l);
+        }
+    }
+    return X;
+}
+
+// An upper bound of the bit length of the integers in the computation of
+// X*2**e*10**t.
+inline int dd_exact_bits(const dd_exact_value& v, int t)
+{
+    int bits = v.eh - v.e + 55 + 64;
+    if (v.e > 0) {
+        bits += v.e;
+    }
+    if (t > 0) {
+        bits += 10*t/3 + 1;
+    }
+    return bits;
+}
+
+// floor(log10(|x|)), possibly off by one.
+inline int dd_decimal_exponent(double x)
+{
+    return int(std::floor(std::log10(std::fabs(x))));
+}
+
+template <typename Bigint>
+std::to_chars_result dd_to_chars_precision(char *first, char *last,
+                                           const DoubleDouble& x,
+                                           const dd_exact_value& v,
+                                           int precision, int t)
+{
+    const Bigint X = dd_exact_int<Bigint>(v);
+    char digits[dd_bigint_max_digits];
+    int n = 0;
+    while (true) {
+        Bigint r = X;
+        dd_scale_round(r, v.e, t);
+        n = dd_bigint_digits(r, digits);
+        if (n == precision) {
+            break;
+        }
+        t += n > precision ? -1 : 1;
+    }
+    return dd_write_decimal(first, last, x.upper < 0, digits, n,
+                            n - 1 - t, true);
+}
+
+//
+// to_chars(first, last, x, precision) writes x rounded to precision
+// significant digits (1 <= precision <= dd_parse_max_digits) in
+// scientific format, e.g. "3.1415926535897932384626433832795e+00" with
+// precision 32.  Like std::to_chars, the result is not terminated with
+// a NUL, and errc::value_too_large is returned if it does not fit in
+// [first, last).
+//
+inline std::to_chars_result to_chars(char *first, char *last,
+                                     const DoubleDouble& x, int precision)
+{
+    if (!std::isfinite(x.upper) || x.upper == 0) {
+        return dd_write_special(first, last, x.upper);
+    }
+    if (precision < 1) {
+        precision = 1;
+    }
+    if (precision > dd_parse_max_digits) {
+        precision = dd_parse_max_digits;
+    }
+    dd_exact_value v;
+    dd_exact(x, 1024, v);
+    int t = precision - 1 - dd_decimal_exponent(x.upper);
+    if (dd_exact_bits(v, t + 1) <= 32*dd_bigint_small::capacity) {
+        return dd_to_chars_precision<dd_bigint_small>(first, last, x, v,
+                                                      precision, t);
+    }
+    return dd_to_chars_precision<dd_bigint>(first, last, x, v, precision, t);
+}
+
+// The exact value of x, for t such that x*10**t is an integer.
+template <typename Bigint>
+std::to_chars_result dd_to_chars_exact(char *first, char *last,
+                                       const DoubleDouble& x,
+                                       const dd_exact_value& v, int t)
+{
+    Bigint r = dd_exact_int<Bigint>(v);
+    bool inexact = false;
+    dd_scale_floor(r, v.e, t, inexact);
+    char digits[dd_bigint_max_digits];
+    int n = dd_bigint_digits(r, digits);
+    const int exp10 = n - 1 - t;
+    while (n > 1 && digits[n - 1] == '0') {
+        --n;
+    }
+    return dd_write_decimal(first, last, x.upper < 0, digits, n, exp10,
+                            false);
+}
+
+template <typename Bigint>
+std::to_chars_result dd_to_chars_shortest(char *first, char *last,
+                                          const DoubleDouble& x,
+                                          const dd_exact_value& v)
+{
+    const Bigint X = dd_exact_int<Bigint>(v);
+
+    // The numbers that are converted to x are those in [lo, hi] (or
+    // without an end point if it is not included): upper must be the
+    // nearest double, and lower the nearest double to the rest.  The
+    // gap below a double m*2**e is 2**e, or 2**(e - 1) at a power of 2.
+    auto gap_below = [](std::uint64_t m, int e) {
+        return (m == (std::uint64_t(1) << 52) && e > -1074) ? e - 1 : e;
+    };
+    Bigint lo(v.mh);
+    lo.shift_left(v.eh - v.e);
+    Bigint hi = lo;
+    lo.subtract_pow2(gap_below(v.mh, v.eh) - 1 - v.e);
+    hi.add_pow2(v.eh - 1 - v.e);
+    bool lo_incl = (v.mh & 1) == 0;
+    bool hi_incl = lo_incl;
+
+    Bigint lo2 = X;
+    Bigint hi2 = X;
+    bool incl2 = true;
+    if (v.lsign == 0) {
+        lo2.subtract_pow2(-1075 - v.e);
+        hi2.add_pow2(-1075 - v.e);
+    }
+    else {
+        int below = gap_below(v.ml, v.el);
+        lo2.subtract_pow2((v.lsign > 0 ? below : v.el) - 1 - v.e);
+        hi2.add_pow2((v.lsign > 0 ? v.el : below) - 1 - v.e);
+        incl2 = (v.ml & 1) == 0;
+    }
+    int c_lo = dd_bigint_compare(lo2, lo);
+    if (c_lo > 0 || (c_lo == 0 && !incl2)) {
+        lo = lo2;
+        lo_incl = incl2;
+    }
+    int c_hi = dd_bigint_compare(hi2, hi);
+    if (c_hi < 0 || (c_hi == 0 && !incl2)) {
+        hi = hi2;
+        hi_incl = incl2;
+    }
+
+    // At the scale 10**-t, the interval is 2 to 400 units wide, so the
+    // multiples of 10**-t in it, [low, high]*10**-t, are not empty, and
+    // high - low is small.  The half gaps are at least 2**e, so
+    // t <= ceil(-0.302*e) + 1.
+    Bigint width = hi;
+    width.subtract(lo);
+    const int t = int(std::ceil((2 - width.bit_length() - v.e)
+                                *0.30102999566398120)) + 1;
+    Bigint& low = lo;
+    bool inexact = false;
+    dd_scale_floor(low, v.e, t, inexact);
+    if (inexact || !lo_incl) {
+        low.add_pow2(0);
+    }
+    Bigint& high = hi;
+    dd_scale_floor(high, v.e, t, inexact);
+    if (!inexact && !hi_incl) {
+        high.subtract_pow2(0);
+    }
+    // x*10**t = (2*high - ax + f)/2, with 0 <= f < 1, and f > 0 if
+    // inexact.  ax and span = high - low are less than 1000.
+    Bigint a = X;
+    dd_scale_floor(a, v.e + 1, t, inexact);
+    const std::int64_t f = inexact ? 1 : 0;
+    auto small_difference = [](Bigint y, Bigint z) {
+        int c = dd_bigint_compare(y, z);
+        Bigint& d = c >= 0 ? y : z;
+        d.subtract(c >= 0 ? z : y);
+        std::int64_t diff = d.size == 0 ? 0 : d.w[0];
+        return c >= 0 ? diff : -diff;
+    };
+    const std::int64_t span = small_difference(high, low);
+    Bigint high2 = high;
+    high2.shift_left(1);
+    const std::int64_t ax = small_difference(high2, a);
+
+    char digits[dd_bigint_max_digits];
+    const int n = dd_bigint_digits(high, digits);
+
+    // The shortest numbers in the interval are the multiples of 10**m in
+    // [low, high] with the largest m; there is one if high % 10**m <= span.
+    // Once 10**m > span, the only one is high_m below, and its trailing
+    // zeros are removed at the end.
+    int m = 0;
+    std::int64_t rest = 0;
+    std::int64_t p10 = 1;
+    while (m < n && p10 <= span) {
+        std::int64_t r = rest + p10*(digits[n - 1 - m] - '0');
+        if (r > span) {
+            break;
+        }
+        rest = r;
+        p10 *= 10;
+        ++m;
+    }
+    // They are high_m - j*10**m, 0 <= j <= j_max, where high_m is high
+    // with the last m digits replaced by zeros.  x is at
+    // high_m + (2*rest - ax + f)/2 units, so the nearest one is at
+    // j = round((ax - f - 2*rest)/(2*10**m)), ties to even.
+    const std::int64_t j_max = (span - rest)/p10;
+    const std::int64_t z = ax - 2*rest;
+    const std::int64_t unit = 2*p10;
+    std::int64_t j = z >= 0 ? z/unit : -((-z + unit - 1)/unit);
+    const std::int64_t r = z - j*unit;
+    const bool odd = ((digits[n - m - 1] - '0') + j) % 2 != 0;
+    if (2*r - f > unit || (2*r == unit && f == 0 && odd)) {
+        ++j;
+    }
+    if (j < 0) {
+        j = 0;
+    }
+    if (j > j_max) {
+        j = j_max;
+    }
+
+    int len = n - m;
+    for (int i = len - 1; j != 0; --i) {
+        std::int64_t dig = (digits[i] - '0') - j % 10;
+        j /= 10;
+        if (dig < 0) {
+            dig += 10;
+            ++j;
+        }
+        digits[i] = char('0' + dig);
+    }
+    int exp10 = n - 1 - t;
+    const char *d = digits;
+    while (*d == '0') {
+        ++d;
+        --len;
+        --exp10;
+    }
+    while (len > 1 && d[len - 1] == '0') {
+        --len;
+    }
+    return dd_write_decimal(first, last, x.upper < 0, d, len, exp10,
+                            false);
+}
+
+//
+// to_chars(first, last, x) writes the shortest decimal number that
+// dd_parse() (or from_chars()) converts back to x, in fixed or
+// scientific format, whichever is shorter, like std::to_chars(first,
+// last, double).  Most values need 31 to 34 digits, fewer if they were
+// parsed from a shorter number.  A value whose lower part is 0 (or very
+// small compared to the upper part) can need many more digits, because
+// then the nearest double to the rest must be 0, too; e.g.
+// DoubleDouble(0.1) is "0.1000000000000000055511151231257827021181583404541015625".
+//
+inline std::to_chars_result to_chars(char *first, char *last,
+                                     const DoubleDouble& x)
+{
+    if (!std::isfinite(x.upper) || x.upper == 0) {
+        return dd_write_special(first, last, x.upper);
+    }
+    dd_exact_value v;
+    if (x.lower == 0) {
+        dd_exact(x, 1024, v);
+        if (v.eh >= -324) {
+            // Then the result is the exact value of upper: with fewer
+            // digits, the rest would be more than 2**-1075 in magnitude.
+            int t = v.eh < 0 ? -v.eh : 0;
+            if (dd_exact_bits(v, t) <= 32*dd_bigint_small::capacity) {
+                return dd_to_chars_exact<dd_bigint_small>(first, last, x, v, t);
+            }
+            return dd_to_chars_exact<dd_bigint>(first, last, x, v, t);
+        }
+    }
+    // If lower is 0, the rest must be at most 2**-1075 in magnitude.
+    dd_exact(x, x.lower == 0 ? -1077 : 1024, v);
+    int t_max = v.e < 0 ? (-31*v.e + 99)/100 + 1 : 1;
+    if (dd_exact_bits(v, t_max) <= 32*dd_bigint_small::capacity) {
+        return dd_to_chars_shortest<dd_bigint_small>(first, last, x, v);
+    }
+    return dd_to_chars_shortest<dd_bigint>(first, last, x, v);
+}
+
+//
+// from_chars(first, last, value) is dd_parse() with the interface of
+// std::from_chars: it returns errc::invalid_argument if there is no
+// number at first, and errc::result_out_of_range (and does not change
+// value) if the number is too large for a double.  Unlike
+// std::from_chars, it accepts a leading '+'.
+//
+inline std::from_chars_result from_chars(const char *first, const char *last,
+                                         DoubleDouble& value)
+{
+    DoubleDouble y;
+    const char *end = dd_parse(first, last, y);
+    if (end == first) {
+        return {first, std::errc::invalid_argument};
+    }
+    if (std::isinf(y.upper)) {
+        const char *p = first;
+        if (*p == '+' || *p == '-') {
+            ++p;
+        }
+        if (*p != 'i' && *p != 'I') {
+            return {end, std::errc::result_out_of_range};
+        }
+    }
+    value = y;
+    return {end, std::errc{}};
+}
+
+//
+// Called (in place of a compile time error) for a _dd literal that is
+// not a number; not constexpr, so a constant evaluation of such a
+// literal fails to compile.
+//
+inline DoubleDouble dd_invalid_literal()
+{
+    return DoubleDouble(NAN);
+}
+
+constexpr DoubleDouble dd_parse_literal(const char *s, std::size_t n)
+{
+    DoubleDouble value;
+    const char *end = dd_parse(s, s + n, value);
+    if (n == 0 || end != s + n) {
+        return dd_invalid_literal();
+    }
+    return value;
+}
+
+inline namespace literals {
+
+constexpr DoubleDouble operator""_dd(const char *s)
+{
+    std::size_t n = 0;
+    while (s[n] != '\0') {
+        ++n;
+    }
+    return dd_parse_literal(s, n);
+}
+
+constexpr DoubleDouble operator""_dd(const char *s, std::size_t n)
+{
+    return dd_parse_literal(s, n);
+}
+
+} // namespace literals
+
+} // namespace
+
+#endif
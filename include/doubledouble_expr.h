@@ -0,0 +1,598 @@
+//
+// Expression templates for DoubleDouble.
+// Copyright © 2022 Warren Weckesser
+//
+// MIT license:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the “Software”), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// dd_lazy(x) wraps x in an expression.  The operators +, -, * and / with
+// an expression operand (and an expression, DoubleDouble or arithmetic
+// value as the other operand) build an expression tree instead of
+// computing a DoubleDouble.  The tree is evaluated when it is converted to
+// DoubleDouble, e.g. when it is assigned, or by eval():
+//
+//     DoubleDouble v = dd_lazy(dd_pi)*r.powi(2)*h/3;
+//
+// Only operations with an expression operand are deferred.  In
+// dd_lazy(a)*b + c*d, the product c*d is computed by the operator before
+// it becomes part of the expression; write dd_lazy(a)*b + dd_lazy(c)*d
+// to defer it, too.
+//
+// The evaluation does the same error-free transformations as the
+// operators in doubledouble.h, but skips most of the renormalizations:
+//
+// * The result of a product or quotient is passed on as it is.  (So a
+//   product followed by a sum is computed the same way as dd_fma().)
+// * The result of a sum or difference is renormalized only when it is an
+//   operand of a product or quotient, where its lower part could
+//   otherwise be large compared to its upper part after cancellation.
+// * The result of the expression is renormalized once, with the same
+//   handling of nonfinite values as the operators.
+//
+// When the same DoubleDouble variable is the divisor of more than one
+// division in an expression, its reciprocal is computed once with
+// recip(), and those divisions become multiplications.  If the reciprocal
+// is not finite (e.g. the divisor is subnormal) or is so small that its
+// lower part would be subnormal, the divisions are done as divisions.
+//
+// The error bounds are of the same order as those of the same expression
+// evaluated with the operators: a few units of 2**-106 relative to the
+// operands of each operation.  A division by a shared reciprocal adds
+// about one more unit.
+//
+// Operands that are DoubleDouble lvalues are stored by address; all other
+// operands (temporaries, arithmetic values and subexpressions) are stored
+// by value.  An expression must not outlive the variables it refers to.
+// Expressions that do not involve dd_lazy() are not affected by this
+// header.
+//
+
+#ifndef DOUBLEDOUBLE_EXPR_H
+#define DOUBLEDOUBLE_EXPR_H
+
+#include <cstddef>
+#include <cfloat>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+#include "doubledouble.h"
+
+namespace doubledouble {
+
+//
+// The divisors of the divisions in an expression whose divisor is a
+// DoubleDouble variable, and the reciprocals of those that occur more
+// than once.
+//
+template <std::size_t N>
+struct dd_expr_divisors
+{
+    const DoubleDouble *divisor[N];
+    DoubleDouble recip[N];
+    bool shared[N];
+    std::size_t count = 0;
+
+    void add(const DoubleDouble *d)
+    {
+        divisor[count++] = d;
+    }
+
+    //
+    // A reciprocal is used only if it is finite and its lower part can be
+    // normal (|r| >= 2**-969); otherwise x*r would lose accuracy or give
+    // INF or NAN where x/d does not.
+    //
+    static bool usable(const DoubleDouble& r)
+    {
+        double a = std::fabs(r.upper);
+        return a >= 0x1p-969 && a <= DBL_MAX && std::isfinite(r.lower);
+    }
+
+    void prepare()
+    {
+        for (std::size_t i = 0; i < count; ++i) {
+            shared[i] = false;
+            for (std::size_t j = 0; j < i; ++j) {
+                if (divisor[j] == divisor[i]) {
+                    if (!shared[j]) {
+                        recip[j] = divisor[j]->recip();
+                        shared[j] = usable(recip[j]);
+                    }
+                    shared[i] = shared[j];
+                    recip[i] = recip[j];
+                    break;
+                }
+            }
+        }
+    }
+
+    const DoubleDouble *find(const DoubleDouble *d) const
+    {
+        for (std::size_t i = 0; i < count; ++i) {
+            if (shared[i] && divisor[i] == d) {
+                return &recip[i];
+            }
+        }
+        return nullptr;
+    }
+};
+
+// With fewer than two such divisions, nothing can be shared.
+template <>
+struct dd_expr_divisors<0>
+{
+    void add(const DoubleDouble *) {}
+    void prepare() {}
+    const DoubleDouble *find(const DoubleDouble *) const { return nullptr; }
+};
+
+template <>
+struct dd_expr_divisors<1> : dd_expr_divisors<0> {};
+
+struct dd_expr_tag {};
+
+template <typename E>
+struct dd_expr : dd_expr_tag
+{
+    const E& self() const
+    {
+        return static_cast<const E&>(*this);
+    }
+
+    DoubleDouble eval() const
+    {
+        dd_expr_divisors<E::n_divisors> divisors;
+        if constexpr (E::n_divisors > 1) {
+            self().collect(divisors);
+            divisors.prepare();
+        }
+        DoubleDouble r = self().eval_raw(divisors);
+        return two_sum_quick(r.upper, r.lower);
+    }
+
+    operator DoubleDouble() const
+    {
+        return eval();
+    }
+};
+
+//
+// Leaves.  eval_raw() of every node returns an unnormalized DoubleDouble.
+//
+
+struct dd_expr_ref : dd_expr<dd_expr_ref>
+{
+    static constexpr bool is_sum = false;
+    static constexpr bool is_scalar = false;
+    static constexpr bool is_ref = true;
+    static constexpr std::size_t n_divisors = 0;
+
+    const DoubleDouble *p;
+
+    explicit dd_expr_ref(const DoubleDouble& x) : p(&x) {}
+
+    template <typename D>
+    void collect(D&) const {}
+
+    template <typename D>
+    DoubleDouble eval_raw(const D&) const
+    {
+        return *p;
+    }
+};
+
+struct dd_expr_value : dd_expr<dd_expr_value>
+{
+    static constexpr bool is_sum = false;
+    static constexpr bool is_scalar = false;
+    static constexpr bool is_ref = false;
+    static constexpr std::size_t n_divisors = 0;
+
+    DoubleDouble v;
+
+    explicit dd_expr_value(const DoubleDouble& x) : v(x) {}
+
+    template <typename D>
+    void collect(D&) const {}
+
+    template <typename D>
+    DoubleDouble eval_raw(const D&) const
+    {
+        return v;
+    }
+};
+
+struct dd_expr_scalar : dd_expr<dd_expr_scalar>
+{
+    static constexpr bool is_sum = false;
+    static constexpr bool is_scalar = true;
+    static constexpr bool is_ref = false;
+    static constexpr std::size_t n_divisors = 0;
+
+    double s;
+
+    explicit dd_expr_scalar(double x) : s(x) {}
+
+    template <typename D>
+    void collect(D&) const {}
+
+    template <typename D>
+    DoubleDouble eval_raw(const D&) const
+    {
+        return DoubleDouble(s, 0.0, dd_unchecked);
+    }
+};
+
+//
+// An operand of a product or quotient: a sum is renormalized first.
+//
+template <typename E, typename D>
+inline DoubleDouble dd_expr_factor(const E& x, const D& divisors)
+{
+    DoubleDouble a = x.eval_raw(divisors);
+    if constexpr (E::is_sum) {
+        double r = a.upper + a.lower;
+        double e = a.lower - (r - a.upper);
+        return DoubleDouble(r, e, dd_unchecked);
+    }
+    else {
+        return a;
+    }
+}
+
+inline DoubleDouble dd_expr_product(const DoubleDouble& a, const DoubleDouble& b)
+{
+    DoubleDouble p = two_product(a.upper, b.upper);
+    p.lower += a.upper*b.lower + a.lower*b.upper;
+    return p;
+}
+
+inline DoubleDouble dd_expr_product(const DoubleDouble& a, double s)
+{
+    DoubleDouble p = two_product(a.upper, s);
+    p.lower += a.lower*s;
+    return p;
+}
+
+//
+// Interior nodes.
+//
+
+#ifdef DOUBLEDOUBLE_ACCURATE_ADD
+//
+// With DOUBLEDOUBLE_ACCURATE_ADD, the sum of two DoubleDouble operands is
+// computed as by DoubleDouble::add(y, dd_accurate), up to its last
+// two_sum_quick().  s and t are the two_sum() of the upper and of the
+// lower parts.
+//
+inline DoubleDouble dd_expr_accurate_tail(DoubleDouble s, const DoubleDouble& t)
+{
+    s.lower += t.upper;
+    double r = s.upper + s.lower;
+    double e = s.lower - (r - s.upper);
+    return DoubleDouble(r, e + t.lower, dd_unchecked);
+}
+#endif
+
+template <typename L, typename R>
+struct dd_expr_add : dd_expr<dd_expr_add<L, R>>
+{
+    static constexpr bool is_sum = true;
+    static constexpr bool is_scalar = false;
+    static constexpr bool is_ref = false;
+    static constexpr std::size_t n_divisors = L::n_divisors + R::n_divisors;
+
+    L x;
+    R y;
+
+    dd_expr_add(const L& x, const R& y) : x(x), y(y) {}
+
+    template <typename D>
+    void collect(D& divisors) const
+    {
+        x.collect(divisors);
+        y.collect(divisors);
+    }
+
+    template <typename D>
+    DoubleDouble eval_raw(const D& divisors) const
+    {
+        if constexpr (R::is_scalar) {
+            DoubleDouble a = x.eval_raw(divisors);
+            DoubleDouble s = two_sum(a.upper, y.s);
+            s.lower += a.lower;
+            return s;
+        }
+        else if constexpr (L::is_scalar) {
+            DoubleDouble b = y.eval_raw(divisors);
+            DoubleDouble s = two_sum(x.s, b.upper);
+            s.lower += b.lower;
+            return s;
+        }
+        else {
+            DoubleDouble a = x.eval_raw(divisors);
+            DoubleDouble b = y.eval_raw(divisors);
+            DoubleDouble s = two_sum(a.upper, b.upper);
+#ifdef DOUBLEDOUBLE_ACCURATE_ADD
+            return dd_expr_accurate_tail(s, two_sum(a.lower, b.lower));
+#else
+            s.lower += a.lower + b.lower;
+            return s;
+#endif
+        }
+    }
+};
+
+template <typename L, typename R>
+struct dd_expr_sub : dd_expr<dd_expr_sub<L, R>>
+{
+    static constexpr bool is_sum = true;
+    static constexpr bool is_scalar = false;
+    static constexpr bool is_ref = false;
+    static constexpr std::size_t n_divisors = L::n_divisors + R::n_divisors;
+
+    L x;
+    R y;
+
+    dd_expr_sub(const L& x, const R& y) : x(x), y(y) {}
+
+    template <typename D>
+    void collect(D& divisors) const
+    {
+        x.collect(divisors);
+        y.collect(divisors);
+    }
+
+    template <typename D>
+    DoubleDouble eval_raw(const D& divisors) const
+    {
+        if constexpr (R::is_scalar) {
+            DoubleDouble a = x.eval_raw(divisors);
+            DoubleDouble s = two_difference(a.upper, y.s);
+            s.lower += a.lower;
+            return s;
+        }
+        else if constexpr (L::is_scalar) {
+            DoubleDouble b = y.eval_raw(divisors);
+            DoubleDouble s = two_difference(x.s, b.upper);
+            s.lower -= b.lower;
+            return s;
+        }
+        else {
+            DoubleDouble a = x.eval_raw(divisors);
+            DoubleDouble b = y.eval_raw(divisors);
+            DoubleDouble s = two_difference(a.upper, b.upper);
+#ifdef DOUBLEDOUBLE_ACCURATE_ADD
+            return dd_expr_accurate_tail(s, two_difference(a.lower, b.lower));
+#else
+            s.lower += a.lower - b.lower;
+            return s;
+#endif
+        }
+    }
+};
+
+template <typename L, typename R>
+struct dd_expr_mul : dd_expr<dd_expr_mul<L, R>>
+{
+    static constexpr bool is_sum = false;
+    static constexpr bool is_scalar = false;
+    static constexpr bool is_ref = false;
+    static constexpr std::size_t n_divisors = L::n_divisors + R::n_divisors;
+
+    L x;
+    R y;
+
+    dd_expr_mul(const L& x, const R& y) : x(x), y(y) {}
+
+    template <typename D>
+    void collect(D& divisors) const
+    {
+        x.collect(divisors);
+        y.collect(divisors);
+    }
+
+    template <typename D>
+    DoubleDouble eval_raw(const D& divisors) const
+    {
+        if constexpr (R::is_scalar) {
+            return dd_expr_product(dd_expr_factor(x, divisors), y.s);
+        }
+        else if constexpr (L::is_scalar) {
+            return dd_expr_product(dd_expr_factor(y, divisors), x.s);
+        }
+        else {
+            return dd_expr_product(dd_expr_factor(x, divisors),
+                               dd_expr_factor(y, divisors));
+        }
+    }
+};
+
+template <typename L, typename R>
+struct dd_expr_div : dd_expr<dd_expr_div<L, R>>
+{
+    static constexpr bool is_sum = false;
+    static constexpr bool is_scalar = false;
+    static constexpr bool is_ref = false;
+    static constexpr std::size_t n_divisors = L::n_divisors + R::n_divisors
+                                              + (R::is_ref ? 1 : 0);
+
+    L x;
+    R y;
+
+    dd_expr_div(const L& x, const R& y) : x(x), y(y) {}
+
+    template <typename D>
+    void collect(D& divisors) const
+    {
+        x.collect(divisors);
+        y.collect(divisors);
+        if constexpr (R::is_ref) {
+            divisors.add(y.p);
+        }
+    }
+
+    template <typename D>
+    DoubleDouble eval_raw(const D& divisors) const
+    {
+        DoubleDouble a = dd_expr_factor(x, divisors);
+        if constexpr (R::is_scalar) {
+            double r = a.upper/y.s;
+            DoubleDouble sf = two_product(r, y.s);
+            double e = (a.upper - sf.upper - sf.lower + a.lower)/y.s;
+            return DoubleDouble(r, e, dd_unchecked);
+        }
+        else {
+            if constexpr (R::is_ref) {
+                const DoubleDouble *rd = divisors.find(y.p);
+                if (rd != nullptr) {
+                    return dd_expr_product(a, *rd);
+                }
+            }
+            DoubleDouble b = dd_expr_factor(y, divisors);
+            double r = a.upper/b.upper;
+            DoubleDouble sf = two_product(r, b.upper);
+            double e = (a.upper - sf.upper - sf.lower + a.lower
+                        - r*b.lower)/b.upper;
+            return DoubleDouble(r, e, dd_unchecked);
+        }
+    }
+};
+
+template <typename E>
+struct dd_expr_neg : dd_expr<dd_expr_neg<E>>
+{
+    static constexpr bool is_sum = E::is_sum;
+    static constexpr bool is_scalar = false;
+    static constexpr bool is_ref = false;
+    static constexpr std::size_t n_divisors = E::n_divisors;
+
+    E x;
+
+    explicit dd_expr_neg(const E& x) : x(x) {}
+
+    template <typename D>
+    void collect(D& divisors) const
+    {
+        x.collect(divisors);
+    }
+
+    template <typename D>
+    DoubleDouble eval_raw(const D& divisors) const
+    {
+        DoubleDouble a = x.eval_raw(divisors);
+        return DoubleDouble(-a.upper, -a.lower, dd_unchecked);
+    }
+};
+
+//
+// Construction of expressions.
+//
+
+template <typename T>
+inline constexpr bool dd_is_expr_v =
+    std::is_base_of_v<dd_expr_tag, std::decay_t<T>>;
+
+template <typename T>
+inline constexpr bool dd_is_expr_operand_v =
+    dd_is_expr_v<T> || std::is_same_v<std::decay_t<T>, DoubleDouble>
+    || std::is_arithmetic_v<std::decay_t<T>>;
+
+template <typename T>
+inline auto dd_expr_operand(T&& x)
+{
+    using U = std::decay_t<T>;
+    if constexpr (dd_is_expr_v<T>) {
+        return U(x);
+    }
+    else if constexpr (std::is_same_v<U, DoubleDouble>) {
+        if constexpr (std::is_lvalue_reference_v<T>) {
+            return dd_expr_ref(x);
+        }
+        else {
+            return dd_expr_value(x);
+        }
+    }
+    else {
+        return dd_expr_scalar(double(x));
+    }
+}
+
+template <typename T>
+using dd_expr_operand_t = decltype(dd_expr_operand(std::declval<T>()));
+
+//
+// dd_lazy(x) starts an expression.  If x is a DoubleDouble variable, the
+// expression refers to it; otherwise x is copied.
+//
+template <typename T,
+          typename = std::enable_if_t<std::is_same_v<std::decay_t<T>, DoubleDouble>>>
+inline auto dd_lazy(T&& x)
+{
+    return dd_expr_operand(std::forward<T>(x));
+}
+
+template <typename L, typename R>
+inline constexpr bool dd_expr_binary_v =
+    (dd_is_expr_v<L> || dd_is_expr_v<R>)
+    && dd_is_expr_operand_v<L> && dd_is_expr_operand_v<R>;
+
+template <typename L, typename R,
+          typename = std::enable_if_t<dd_expr_binary_v<L, R>>>
+inline auto operator+(L&& x, R&& y)
+{
+    return dd_expr_add<dd_expr_operand_t<L>, dd_expr_operand_t<R>>(
+        dd_expr_operand(std::forward<L>(x)), dd_expr_operand(std::forward<R>(y)));
+}
+
+template <typename L, typename R,
+          typename = std::enable_if_t<dd_expr_binary_v<L, R>>>
+inline auto operator-(L&& x, R&& y)
+{
+    return dd_expr_sub<dd_expr_operand_t<L>, dd_expr_operand_t<R>>(
+        dd_expr_operand(std::forward<L>(x)), dd_expr_operand(std::forward<R>(y)));
+}
+
+template <typename L, typename R,
+          typename = std::enable_if_t<dd_expr_binary_v<L, R>>>
+inline auto operator*(L&& x, R&& y)
+{
+    return dd_expr_mul<dd_expr_operand_t<L>, dd_expr_operand_t<R>>(
+        dd_expr_operand(std::forward<L>(x)), dd_expr_operand(std::forward<R>(y)));
+}
+
+template <typename L, typename R,
+          typename = std::enable_if_t<dd_expr_binary_v<L, R>>>
+inline auto operator/(L&& x, R&& y)
+{
+    return dd_expr_div<dd_expr_operand_t<L>, dd_expr_operand_t<R>>(
+        dd_expr_operand(std::forward<L>(x)), dd_expr_operand(std::forward<R>(y)));
+}
+
+template <typename E, typename = std::enable_if_t<dd_is_expr_v<E>>>
+inline auto operator-(const E& x)
+{
+    return dd_expr_neg<E>(x);
+}
+
+} // namespace
+
+#endif
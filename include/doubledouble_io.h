@@ -0,0 +1,588 @@
+//
+// Binary files of DoubleDouble arrays.
+// Copyright © 2022 Warren Weckesser
+//
+// MIT license:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the “Software”), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// dd_write_file() writes an array of DoubleDouble to a binary file, and
+// DoubleDoubleFile reads such a file.  On POSIX systems the file is
+// memory-mapped, and the elements are used where they are in the mapping,
+// without being parsed or copied: DoubleDoubleFile::span() can be passed
+// to the kernels of doubledouble_array.h and to dsum(), and
+// DoubleDoubleFile::data() to dsum() and ddot().
+//
+// The file starts with a 64 byte header (struct dd_file_header):
+//
+//     offset  size
+//          0     8  magic, "DDARRAY" followed by a zero byte
+//          8     4  DD_FILE_BYTE_ORDER (0x01020304) in the byte order
+//                   of the file
+//         12     4  version (DD_FILE_VERSION)
+//         16     4  layout (dd_file_layout)
+//         20     4  reserved, 0
+//         24     8  number of elements
+//         32     8  offset of the data from the start of the file
+//         40    24  reserved, 0
+//
+// All the numbers in the file, including the header fields, have the
+// byte order of the machine that wrote it.  The data starts at a
+// multiple of DD_ARRAY_ALIGNMENT bytes.  With dd_file_layout::pairs the
+// data is the array of elements, each stored as upper then lower.  With
+// dd_file_layout::planes the data is the array of upper parts, followed
+// by the array of lower parts, which starts at the next multiple of
+// DD_ARRAY_ALIGNMENT bytes.
+//
+// A file written with the other byte order is read into memory and its
+// bytes are swapped, so it is still read correctly, but not in place.
+// Without mmap (or when DOUBLEDOUBLE_NO_MMAP is defined), every file is
+// read into memory.
+//
+// The functions do not throw exceptions; failures are reported with
+// dd_file_status.
+//
+
+#ifndef DOUBLEDOUBLE_IO_H
+#define DOUBLEDOUBLE_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <algorithm>
+#include <vector>
+#include "doubledouble.h"
+#include "doubledouble_array.h"
+
+#if !defined(DOUBLEDOUBLE_NO_MMAP) && (defined(__unix__) || defined(__APPLE__))
+#define DD_FILE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define DD_FILE_MMAP 0
+#endif
+
+namespace doubledouble {
+
+#define DD_FILE_VERSION 1
+#define DD_FILE_BYTE_ORDER 0x01020304u
+
+static_assert(sizeof(DoubleDouble) == 2*sizeof(double),
+              "DoubleDouble must be two doubles without padding");
+
+enum class dd_file_layout : std::uint32_t {
+    pairs = 0,      // upper and lower of each element together
+    planes = 1,     // all the upper parts, then all the lower parts
+};
+
+enum class dd_file_status {
+    ok = 0,
+    open_failed,    // the file could not be opened or created
+    io_error,       // reading, writing or mapping the file failed
+    bad_magic,      // not a DoubleDouble array file
+    bad_version,    // written by a later version of this header
+    bad_header,     // unknown layout or inconsistent header fields
+    truncated,      // the file is shorter than the header says
+};
+
+struct dd_file_header
+{
+    char magic[8];
+    std::uint32_t byte_order;
+    std::uint32_t version;
+    std::uint32_t layout;
+    std::uint32_t reserved0;
+    std::uint64_t count;
+    std::uint64_t data_offset;
+    unsigned char reserved1[24];
+};
+
+static_assert(sizeof(dd_file_header) == 64, "dd_file_header must be 64 bytes");
+
+constexpr char dd_file_magic[8] = {'D', 'D', 'A', 'R', 'R', 'A', 'Y', '\0'};
+
+//
+// The number of bytes of one plane of n doubles, padded to a multiple of
+// DD_ARRAY_ALIGNMENT.
+//
+inline std::uint64_t dd_file_plane_bytes(std::uint64_t n)
+{
+    std::uint64_t bytes = n*sizeof(double);
+    return (bytes + DD_ARRAY_ALIGNMENT - 1)/DD_ARRAY_ALIGNMENT*DD_ARRAY_ALIGNMENT;
+}
+
+inline dd_file_header dd_file_make_header(std::uint64_t count,
+                                          dd_file_layout layout)
+{
+    dd_file_header h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, dd_file_magic, sizeof(h.magic));
+    h.byte_order = DD_FILE_BYTE_ORDER;
+    h.version = DD_FILE_VERSION;
+    h.layout = static_cast<std::uint32_t>(layout);
+    h.count = count;
+    h.data_offset = (sizeof(dd_file_header) + DD_ARRAY_ALIGNMENT - 1)
+                    / DD_ARRAY_ALIGNMENT*DD_ARRAY_ALIGNMENT;
+    return h;
+}
+
+//
+// Write the upper parts get(i, 0) or the lower parts get(i, 1) of the
+// elements i = 0, ..., n-1 (planes), or the pairs (pairs), through a
+// buffer, followed by zeros up to the end of the data.
+//
+template <typename Get>
+inline dd_file_status dd_file_write_data(std::FILE *f, std::size_t n,
+                                         dd_file_layout layout, Get get)
+{
+    static const std::size_t buffer_size = 4096;
+    double buffer[buffer_size];
+    int nparts = (layout == dd_file_layout::planes) ? 2 : 1;
+    for (int part = 0; part < nparts; ++part) {
+        std::size_t total = (layout == dd_file_layout::planes) ? n : 2*n;
+        for (std::size_t k = 0; k < total; k += buffer_size) {
+            std::size_t m = std::min(buffer_size, total - k);
+            for (std::size_t j = 0; j < m; ++j) {
+                if (layout == dd_file_layout::planes) {
+                    buffer[j] = get(k + j, part);
+                }
+                else {
+                    buffer[j] = get((k + j)/2, int((k + j) % 2));
+                }
+            }
+            if (std::fwrite(buffer, sizeof(double), m, f) != m) {
+                return dd_file_status::io_error;
+            }
+        }
+        if (layout == dd_file_layout::planes) {
+            std::size_t pad = std::size_t(dd_file_plane_bytes(n) - n*sizeof(double));
+            static const char zeros[DD_ARRAY_ALIGNMENT] = {0};
+            if (pad > 0 && std::fwrite(zeros, 1, pad, f) != pad) {
+                return dd_file_status::io_error;
+            }
+        }
+    }
+    return dd_file_status::ok;
+}
+
+template <typename Get>
+inline dd_file_status dd_file_write(const char *path, std::size_t n,
+                                    dd_file_layout layout, Get get)
+{
+    std::FILE *f = std::fopen(path, "wb");
+    if (f == nullptr) {
+        return dd_file_status::open_failed;
+    }
+    dd_file_header h = dd_file_make_header(n, layout);
+    dd_file_status status = dd_file_status::ok;
+    if (std::fwrite(&h, sizeof(h), 1, f) != 1) {
+        status = dd_file_status::io_error;
+    }
+    if (status == dd_file_status::ok) {
+        std::size_t pad = std::size_t(h.data_offset - sizeof(h));
+        static const char zeros[DD_ARRAY_ALIGNMENT] = {0};
+        if (pad > 0 && std::fwrite(zeros, 1, pad, f) != pad) {
+            status = dd_file_status::io_error;
+        }
+    }
+    if (status == dd_file_status::ok) {
+        status = dd_file_write_data(f, n, layout, get);
+    }
+    if (std::fclose(f) != 0 && status == dd_file_status::ok) {
+        status = dd_file_status::io_error;
+    }
+    return status;
+}
+
+//
+// Write the elements of x to the file `path`, replacing the file if it
+// exists.  The default layout is the one that stores x as it is in memory.
+//
+
+inline dd_file_status dd_write_file(const char *path, dd_const_span x,
+                                    dd_file_layout layout = dd_file_layout::planes)
+{
+    return dd_file_write(path, x.size, layout, [=](std::size_t i, int part) {
+        return part == 0 ? x.upper[i] : x.lower[i];
+    });
+}
+
+inline dd_file_status dd_write_file(const char *path, std::size_t n,
+                                    const DoubleDouble *x,
+                                    dd_file_layout layout = dd_file_layout::pairs)
+{
+    return dd_file_write(path, n, layout, [=](std::size_t i, int part) {
+        return part == 0 ? x[i].upper : x[i].lower;
+    });
+}
+
+inline dd_file_status dd_write_file(const char *path,
+                                    const std::vector<DoubleDouble>& x,
+                                    dd_file_layout layout = dd_file_layout::pairs)
+{
+    return dd_write_file(path, x.size(), x.data(), layout);
+}
+
+//
+// DoubleDoubleFile gives read-only access to the elements of a file
+// written by dd_write_file().  The elements remain valid until the
+// DoubleDoubleFile is closed or destroyed.
+//
+// span() is the view of the elements of a file with the planes layout,
+// and data() is the array of elements of a file with the pairs layout.
+// The other one is empty (null, with size 0); operator[] works with
+// both layouts.
+//
+class DoubleDoubleFile
+{
+    const unsigned char *base{nullptr};     // the whole file
+    std::size_t nbytes{0};
+    bool mapped{false};
+    std::size_t n{0};
+    dd_file_layout lay{dd_file_layout::pairs};
+    const double *hi{nullptr};
+    const double *lo{nullptr};
+
+    static std::uint32_t swap32(std::uint32_t x)
+    {
+        return (x >> 24) | ((x >> 8) & 0xff00u) | ((x << 8) & 0xff0000u) | (x << 24);
+    }
+
+    static std::uint64_t swap64(std::uint64_t x)
+    {
+        return (std::uint64_t(swap32(std::uint32_t(x))) << 32)
+               | swap32(std::uint32_t(x >> 32));
+    }
+
+    static unsigned char *allocate(std::size_t nbytes)
+    {
+        void *p = ::operator new(nbytes, std::align_val_t(DD_ARRAY_ALIGNMENT),
+                                 std::nothrow);
+        return static_cast<unsigned char *>(p);
+    }
+
+    void release()
+    {
+        if (base != nullptr) {
+#if DD_FILE_MMAP
+            if (mapped) {
+                ::munmap(const_cast<unsigned char *>(base), nbytes);
+            }
+            else
+#endif
+            {
+                ::operator delete(const_cast<unsigned char *>(base),
+                                  std::align_val_t(DD_ARRAY_ALIGNMENT));
+            }
+        }
+        base = nullptr;
+        nbytes = 0;
+        mapped = false;
+        n = 0;
+        lay = dd_file_layout::pairs;
+        hi = nullptr;
+        lo = nullptr;
+    }
+
+    //
+    // Return the size of the file f and leave it positioned at the start,
+    // or return -1.  ftell() returns a long, which has only 32 bits on
+    // 64-bit Windows, so the 64-bit versions are used where they exist.
+    //
+    static std::int64_t file_size(std::FILE *f)
+    {
+        std::int64_t size = -1;
+#if defined(_WIN32)
+        if (::_fseeki64(f, 0, SEEK_END) == 0) {
+            size = ::_ftelli64(f);
+        }
+        if (::_fseeki64(f, 0, SEEK_SET) != 0) {
+            size = -1;
+        }
+#elif defined(__unix__) || defined(__APPLE__)
+        if (::fseeko(f, 0, SEEK_END) == 0) {
+            size = ::ftello(f);
+        }
+        if (::fseeko(f, 0, SEEK_SET) != 0) {
+            size = -1;
+        }
+#else
+        if (std::fseek(f, 0, SEEK_END) == 0) {
+            size = std::ftell(f);
+        }
+        if (std::fseek(f, 0, SEEK_SET) != 0) {
+            size = -1;
+        }
+#endif
+        return size;
+    }
+
+    dd_file_status read_into_memory(const char *path)
+    {
+        std::FILE *f = std::fopen(path, "rb");
+        if (f == nullptr) {
+            return dd_file_status::open_failed;
+        }
+        dd_file_status status = dd_file_status::ok;
+        std::int64_t size = file_size(f);
+        if (size < 0 || std::uint64_t(size) > SIZE_MAX) {
+            status = dd_file_status::io_error;
+        }
+        else if (size > 0) {
+            unsigned char *p = allocate(std::size_t(size));
+            if (p == nullptr) {
+                status = dd_file_status::io_error;
+            }
+            else {
+                base = p;
+                nbytes = std::size_t(size);
+                if (std::fread(p, 1, nbytes, f) != nbytes) {
+                    status = dd_file_status::io_error;
+                }
+            }
+        }
+        std::fclose(f);
+        return status;
+    }
+
+#if DD_FILE_MMAP
+    dd_file_status map(const char *path)
+    {
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            return dd_file_status::open_failed;
+        }
+        dd_file_status status = dd_file_status::ok;
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            status = dd_file_status::io_error;
+        }
+        else if (st.st_size > 0) {
+            void *p = ::mmap(nullptr, std::size_t(st.st_size), PROT_READ,
+                             MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                status = dd_file_status::io_error;
+            }
+            else {
+                base = static_cast<const unsigned char *>(p);
+                nbytes = std::size_t(st.st_size);
+                mapped = true;
+            }
+        }
+        ::close(fd);
+        return status;
+    }
+#endif
+
+    static void swap_header(dd_file_header& h)
+    {
+        h.byte_order = swap32(h.byte_order);
+        h.version = swap32(h.version);
+        h.layout = swap32(h.layout);
+        h.count = swap64(h.count);
+        h.data_offset = swap64(h.data_offset);
+    }
+
+    //
+    // Replace a mapping of a file with the other byte order by a copy of
+    // the file, and store in it the header h (already swapped) and the
+    // data [h.data_offset, h.data_offset + data) with its bytes swapped.
+    // h must have been checked: the data must be in the file.
+    //
+    dd_file_status swap_bytes(const dd_file_header& h, std::uint64_t data)
+    {
+        unsigned char *p = const_cast<unsigned char *>(base);
+        if (mapped) {
+            p = allocate(nbytes);
+            if (p == nullptr) {
+                return dd_file_status::io_error;
+            }
+            std::memcpy(p, base, nbytes);
+#if DD_FILE_MMAP
+            ::munmap(const_cast<unsigned char *>(base), nbytes);
+#endif
+            base = p;
+            mapped = false;
+        }
+        std::memcpy(p, &h, sizeof(h));
+        // end >= h.data_offset >= sizeof(h), so end - 8 does not wrap.
+        std::size_t end = std::size_t(h.data_offset + data);
+        for (std::size_t k = std::size_t(h.data_offset);
+                k <= end - sizeof(std::uint64_t); k += sizeof(std::uint64_t)) {
+            std::uint64_t w;
+            std::memcpy(&w, p + k, sizeof(w));
+            w = swap64(w);
+            std::memcpy(p + k, &w, sizeof(w));
+        }
+        return dd_file_status::ok;
+    }
+
+    dd_file_status check_header()
+    {
+        if (nbytes < sizeof(dd_file_header)) {
+            return (nbytes >= sizeof(dd_file_magic)
+                    && std::memcmp(base, dd_file_magic, sizeof(dd_file_magic)) == 0)
+                   ? dd_file_status::truncated : dd_file_status::bad_magic;
+        }
+        if (std::memcmp(base, dd_file_magic, sizeof(dd_file_magic)) != 0) {
+            return dd_file_status::bad_magic;
+        }
+        dd_file_header h;
+        std::memcpy(&h, base, sizeof(h));
+        bool swapped = false;
+        if (h.byte_order != DD_FILE_BYTE_ORDER) {
+            if (h.byte_order != swap32(DD_FILE_BYTE_ORDER)) {
+                return dd_file_status::bad_header;
+            }
+            swap_header(h);
+            swapped = true;
+        }
+        if (h.version == 0 || h.version > DD_FILE_VERSION) {
+            return dd_file_status::bad_version;
+        }
+        if (h.layout != std::uint32_t(dd_file_layout::pairs)
+                && h.layout != std::uint32_t(dd_file_layout::planes)) {
+            return dd_file_status::bad_header;
+        }
+        if (h.data_offset < sizeof(h) || h.data_offset % DD_ARRAY_ALIGNMENT != 0
+                || h.count > (std::uint64_t(-1) - DD_ARRAY_ALIGNMENT)/(2*sizeof(double))) {
+            return dd_file_status::bad_header;
+        }
+        std::uint64_t plane = dd_file_plane_bytes(h.count);
+        std::uint64_t data = (h.layout == std::uint32_t(dd_file_layout::planes))
+                             ? 2*plane : 2*sizeof(double)*h.count;
+        if (h.data_offset > nbytes || data > nbytes - h.data_offset) {
+            return dd_file_status::truncated;
+        }
+        if (swapped) {
+            dd_file_status status = swap_bytes(h, data);
+            if (status != dd_file_status::ok) {
+                return status;
+            }
+        }
+        n = std::size_t(h.count);
+        lay = static_cast<dd_file_layout>(h.layout);
+        hi = reinterpret_cast<const double *>(base + h.data_offset);
+        lo = (lay == dd_file_layout::planes)
+             ? reinterpret_cast<const double *>(base + h.data_offset + plane)
+             : hi + 1;
+        return dd_file_status::ok;
+    }
+
+public:
+
+    DoubleDoubleFile() {}
+
+    DoubleDoubleFile(const DoubleDoubleFile&) = delete;
+    DoubleDoubleFile& operator=(const DoubleDoubleFile&) = delete;
+
+    DoubleDoubleFile(DoubleDoubleFile&& other) noexcept
+        : base(other.base), nbytes(other.nbytes), mapped(other.mapped),
+          n(other.n), lay(other.lay), hi(other.hi), lo(other.lo)
+    {
+        other.base = nullptr;
+        other.release();
+    }
+
+    DoubleDoubleFile& operator=(DoubleDoubleFile&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            std::swap(base, other.base);
+            std::swap(nbytes, other.nbytes);
+            std::swap(mapped, other.mapped);
+            std::swap(n, other.n);
+            std::swap(lay, other.lay);
+            std::swap(hi, other.hi);
+            std::swap(lo, other.lo);
+        }
+        return *this;
+    }
+
+    ~DoubleDoubleFile()
+    {
+        release();
+    }
+
+    //
+    // Open the file `path`, closing the file that was open before.  If
+    // the status is not ok, no file is open.
+    //
+    dd_file_status open(const char *path)
+    {
+        release();
+#if DD_FILE_MMAP
+        dd_file_status status = map(path);
+#else
+        dd_file_status status = read_into_memory(path);
+#endif
+        if (status == dd_file_status::ok) {
+            status = check_header();
+        }
+        if (status != dd_file_status::ok) {
+            release();
+        }
+        return status;
+    }
+
+    void close()
+    {
+        release();
+    }
+
+    bool is_open() const { return base != nullptr; }
+
+    // True if the elements are read in place from a memory mapping.
+    bool is_mapped() const { return mapped; }
+
+    std::size_t size() const { return n; }
+
+    dd_file_layout layout() const { return lay; }
+
+    DoubleDouble operator[](std::size_t i) const
+    {
+        std::size_t k = (lay == dd_file_layout::planes) ? i : 2*i;
+        return DoubleDouble(hi[k], lo[k], dd_unchecked);
+    }
+
+    dd_const_span span() const
+    {
+        if (lay != dd_file_layout::planes) {
+            return dd_const_span(nullptr, nullptr, 0);
+        }
+        return dd_const_span(hi, lo, n);
+    }
+
+    const DoubleDouble *data() const
+    {
+        if (lay != dd_file_layout::pairs) {
+            return nullptr;
+        }
+        return reinterpret_cast<const DoubleDouble *>(hi);
+    }
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,617 @@
+//
+// Dense linear algebra kernels with DoubleDouble.
+// Copyright © 2022 Warren Weckesser
+//
+// MIT license:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the “Software”), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// Matrices are stored in row-major order with a leading dimension (the
+// distance between the starts of consecutive rows), either as split
+// upper/lower planes (dd_span, dd_const_span, e.g. from a
+// DoubleDoubleArray) or as arrays of DoubleDouble.  Element (i, j) of a
+// matrix A with leading dimension lda is A[i*lda + j].  The size fields
+// of the spans are not used.
+//
+// The functions that take an nthreads argument split the rows of the
+// result over that many threads (0 means one per hardware thread), so
+// programs that use them may need to be linked with -pthread.
+//
+
+#ifndef DOUBLEDOUBLE_LINALG_H
+#define DOUBLEDOUBLE_LINALG_H
+
+#include <cstddef>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include <vector>
+#include "doubledouble.h"
+#include "doubledouble_array.h"
+#include "doubledouble_parallel.h"
+
+namespace doubledouble {
+
+//
+// dd_gemv() computes y = A*x, where A is m x n.  Each element of y is
+// computed like ddot_dd(), with DSUM_LANES independent accumulators.
+//
+
+inline void dd_gemv(size_t m, size_t n, dd_const_span A, size_t lda,
+                    dd_const_span x, dd_span y, unsigned nthreads = 1)
+{
+    auto rows = [&](unsigned, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const double *au = A.upper + i*lda;
+            const double *al = A.lower + i*lda;
+            auto term = [=](size_t j, double& tu, double& tl) {
+                tu = au[j]*x.upper[j];
+                tl = dd_product_error(au[j], x.upper[j], tu)
+                     + (au[j]*x.lower[j] + al[j]*x.upper[j]);
+            };
+            DoubleDouble s = dd_lanes_sum(n, term);
+            y.upper[i] = s.upper;
+            y.lower[i] = s.lower;
+        }
+    };
+    // Give each thread at least 64K matrix elements.
+    size_t rows_per_chunk = std::max(size_t(1),
+                                     size_t(65536) / std::max(n, size_t(1)));
+    nthreads = dd_parallel_nthreads(m, nthreads, rows_per_chunk);
+    dd_parallel_ranges(m, nthreads, rows, rows_per_chunk);
+}
+
+inline void dd_gemv(size_t m, size_t n, const DoubleDouble *A, size_t lda,
+                    const DoubleDouble *x, DoubleDouble *y,
+                    unsigned nthreads = 1)
+{
+    auto rows = [&](unsigned, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            y[i] = ddot_dd(n, A + i*lda, x);
+        }
+    };
+    size_t rows_per_chunk = std::max(size_t(1),
+                                     size_t(65536) / std::max(n, size_t(1)));
+    nthreads = dd_parallel_nthreads(m, nthreads, rows_per_chunk);
+    dd_parallel_ranges(m, nthreads, rows, rows_per_chunk);
+}
+
+//
+// dd_gemm() computes C = A*B, where A is m x k, B is k x n and C is m x n.
+//
+// This follows the usual structure of a high-performance GEMM: B is
+// copied ("packed") in blocks of DD_GEMM_KC x DD_GEMM_NC and A in blocks
+// of DD_GEMM_MC x DD_GEMM_KC, in the order in which the micro-kernel
+// reads them, so that the blocks stay in cache while they are used.
+// The micro-kernel computes a DD_GEMM_MR x DD_GEMM_NR block of C, with
+// the accumulators held in registers; its loop over the columns of the
+// block is vectorized by the compiler.
+//
+// In the micro-kernel, each product a*b is computed exactly to
+// DoubleDouble precision as (q, qe), with q = au*bu and
+// qe = dd_product_error(au, bu, q) + (au*bl + al*bu).  q is added to the
+// upper accumulator with two_sum(), and its rounding error and qe are
+// added to the lower accumulator.  The accumulators are renormalized once
+// per block of DD_GEMM_KC terms.
+// Each element of C has an error bounded by a small multiple of
+// k * 2**-104 * sum(|A[i, p]*B[p, j]|).
+//
+
+#define DD_GEMM_MR 4
+#define DD_GEMM_NR 16
+#define DD_GEMM_KC 256
+#define DD_GEMM_MC 64
+#define DD_GEMM_NC 1024
+
+//
+// c (MR x NR, row-major, split planes) += a*b, where a is a packed
+// MR x kc panel (a[p*MR + i]) and b is a packed kc x NR panel
+// (b[p*NR + j]).
+//
+inline void dd_gemm_micro_kernel(size_t kc,
+                                 const double *aup, const double *alp,
+                                 const double *bup, const double *blp,
+                                 double *cu, double *cl)
+{
+    double su[DD_GEMM_MR][DD_GEMM_NR];
+    double sl[DD_GEMM_MR][DD_GEMM_NR];
+    for (size_t i = 0; i < DD_GEMM_MR; ++i) {
+        for (size_t j = 0; j < DD_GEMM_NR; ++j) {
+            su[i][j] = cu[i*DD_GEMM_NR + j];
+            sl[i][j] = cl[i*DD_GEMM_NR + j];
+        }
+    }
+    for (size_t p = 0; p < kc; ++p) {
+        const double *bu = bup + p*DD_GEMM_NR;
+        const double *bl = blp + p*DD_GEMM_NR;
+        for (size_t i = 0; i < DD_GEMM_MR; ++i) {
+            double au = aup[p*DD_GEMM_MR + i];
+            double al = alp[p*DD_GEMM_MR + i];
+            for (size_t j = 0; j < DD_GEMM_NR; ++j) {
+                double q = au*bu[j];
+                double qe = dd_product_error(au, bu[j], q)
+                            + (au*bl[j] + al*bu[j]);
+                double r = su[i][j] + q;
+                double t = r - su[i][j];
+                double e = (su[i][j] - (r - t)) + (q - t);
+                su[i][j] = r;
+                sl[i][j] += e + qe;
+            }
+        }
+    }
+    for (size_t i = 0; i < DD_GEMM_MR; ++i) {
+        for (size_t j = 0; j < DD_GEMM_NR; ++j) {
+            double r = su[i][j] + sl[i][j];
+            cl[i*DD_GEMM_NR + j] = sl[i][j] - (r - su[i][j]);
+            cu[i*DD_GEMM_NR + j] = r;
+        }
+    }
+}
+
+//
+// Single-threaded C = A*B.
+//
+inline void dd_gemm_serial(size_t m, size_t n, size_t k,
+                           dd_const_span A, size_t lda,
+                           dd_const_span B, size_t ldb,
+                           dd_span C, size_t ldc)
+{
+    const size_t MR = DD_GEMM_MR;
+    const size_t NR = DD_GEMM_NR;
+
+    for (size_t i = 0; i < m; ++i) {
+        std::fill(C.upper + i*ldc, C.upper + i*ldc + n, 0.0);
+        std::fill(C.lower + i*ldc, C.lower + i*ldc + n, 0.0);
+    }
+    if (k == 0) {
+        return;
+    }
+
+    // The packed blocks are no larger than the matrices, rounded up to
+    // whole panels.
+    size_t kc_max = std::min(size_t(DD_GEMM_KC), k);
+    size_t mc_max = (std::min(size_t(DD_GEMM_MC), m) + MR - 1) / MR * MR;
+    size_t nc_max = (std::min(size_t(DD_GEMM_NC), n) + NR - 1) / NR * NR;
+    std::vector<double> apack_u(mc_max*kc_max);
+    std::vector<double> apack_l(mc_max*kc_max);
+    std::vector<double> bpack_u(kc_max*nc_max);
+    std::vector<double> bpack_l(kc_max*nc_max);
+    double tile_u[DD_GEMM_MR*DD_GEMM_NR];
+    double tile_l[DD_GEMM_MR*DD_GEMM_NR];
+
+    for (size_t jc = 0; jc < n; jc += DD_GEMM_NC) {
+        size_t nc = std::min(size_t(DD_GEMM_NC), n - jc);
+        for (size_t pc = 0; pc < k; pc += DD_GEMM_KC) {
+            size_t kc = std::min(size_t(DD_GEMM_KC), k - pc);
+
+            // Pack B[pc:pc+kc, jc:jc+nc] into panels of NR columns,
+            // padded with zeros.
+            for (size_t jr = 0; jr < nc; jr += NR) {
+                double *pu = &bpack_u[jr*kc];
+                double *pl = &bpack_l[jr*kc];
+                for (size_t p = 0; p < kc; ++p) {
+                    const double *bu = B.upper + (pc + p)*ldb + jc + jr;
+                    const double *bl = B.lower + (pc + p)*ldb + jc + jr;
+                    for (size_t j = 0; j < NR; ++j) {
+                        bool inside = jr + j < nc;
+                        pu[p*NR + j] = inside ? bu[j] : 0.0;
+                        pl[p*NR + j] = inside ? bl[j] : 0.0;
+                    }
+                }
+            }
+
+            for (size_t ic = 0; ic < m; ic += DD_GEMM_MC) {
+                size_t mc = std::min(size_t(DD_GEMM_MC), m - ic);
+
+                // Pack A[ic:ic+mc, pc:pc+kc] into panels of MR rows,
+                // padded with zeros.
+                for (size_t ir = 0; ir < mc; ir += MR) {
+                    double *pu = &apack_u[ir*kc];
+                    double *pl = &apack_l[ir*kc];
+                    for (size_t i = 0; i < MR; ++i) {
+                        bool inside = ir + i < mc;
+                        const double *au = A.upper + (ic + ir + i)*lda + pc;
+                        const double *al = A.lower + (ic + ir + i)*lda + pc;
+                        for (size_t p = 0; p < kc; ++p) {
+                            pu[p*MR + i] = inside ? au[p] : 0.0;
+                            pl[p*MR + i] = inside ? al[p] : 0.0;
+                        }
+                    }
+                }
+
+                for (size_t jr = 0; jr < nc; jr += NR) {
+                    size_t nr = std::min(NR, nc - jr);
+                    for (size_t ir = 0; ir < mc; ir += MR) {
+                        size_t mr = std::min(MR, mc - ir);
+                        double *cu = C.upper + (ic + ir)*ldc + jc + jr;
+                        double *cl = C.lower + (ic + ir)*ldc + jc + jr;
+                        std::fill(tile_u, tile_u + MR*NR, 0.0);
+                        std::fill(tile_l, tile_l + MR*NR, 0.0);
+                        for (size_t i = 0; i < mr; ++i) {
+                            for (size_t j = 0; j < nr; ++j) {
+                                tile_u[i*NR + j] = cu[i*ldc + j];
+                                tile_l[i*NR + j] = cl[i*ldc + j];
+                            }
+                        }
+                        dd_gemm_micro_kernel(kc,
+                                             &apack_u[ir*kc], &apack_l[ir*kc],
+                                             &bpack_u[jr*kc], &bpack_l[jr*kc],
+                                             tile_u, tile_l);
+                        for (size_t i = 0; i < mr; ++i) {
+                            for (size_t j = 0; j < nr; ++j) {
+                                cu[i*ldc + j] = tile_u[i*NR + j];
+                                cl[i*ldc + j] = tile_l[i*NR + j];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+inline void dd_gemm(size_t m, size_t n, size_t k,
+                    dd_const_span A, size_t lda,
+                    dd_const_span B, size_t ldb,
+                    dd_span C, size_t ldc, unsigned nthreads = 1)
+{
+    // Give each thread at least one block of DD_GEMM_MC rows.
+    nthreads = dd_parallel_nthreads(m, nthreads, DD_GEMM_MC);
+    dd_parallel_ranges(m, nthreads, [&](unsigned, size_t begin, size_t end) {
+        dd_const_span Ak(A.upper + begin*lda, A.lower + begin*lda, 0);
+        dd_span Ck{C.upper + begin*ldc, C.lower + begin*ldc, 0};
+        dd_gemm_serial(end - begin, n, k, Ak, lda, B, ldb, Ck, ldc);
+    }, DD_GEMM_MC);
+}
+
+//
+// C = A*B for matrices stored as arrays of DoubleDouble.  A and B are
+// copied to split planes, and C is copied back from them.
+//
+inline void dd_gemm(size_t m, size_t n, size_t k,
+                    const DoubleDouble *A, size_t lda,
+                    const DoubleDouble *B, size_t ldb,
+                    DoubleDouble *C, size_t ldc, unsigned nthreads = 1)
+{
+    DoubleDoubleArray As(m*k), Bs(k*n), Cs(m*n);
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t p = 0; p < k; ++p) {
+            As.set(i*k + p, A[i*lda + p]);
+        }
+    }
+    for (size_t p = 0; p < k; ++p) {
+        for (size_t j = 0; j < n; ++j) {
+            Bs.set(p*n + j, B[p*ldb + j]);
+        }
+    }
+    dd_gemm(m, n, k, As, k, Bs, n, Cs, n, nthreads);
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            C[i*ldc + j] = Cs[i*n + j];
+        }
+    }
+}
+
+//
+// Sparse matrix-vector product.
+//
+// dd_csr_spmv() computes y = A*x, where A is an m x n sparse matrix in
+// compressed sparse row (CSR) format with double values, and x is a
+// double vector.  The nonzero values of row i are values[row_ptr[i]],
+// ..., values[row_ptr[i+1] - 1], in the columns given by the same
+// elements of col_idx.  Index may be any integer type.
+//
+// Each row is accumulated in DD_SPMV_LANES independent lanes: the
+// products values[p]*x[col_idx[p]] are made exact with two_product(),
+// their upper parts are added to the upper accumulator with two_sum(),
+// and all the error terms are added to the lower accumulator.  The
+// lanes are combined the same way at the end of the row, so the error of
+// y[i] is bounded by a small multiple of
+// len(row) * 2**-104 * sum(|A[i, j]*x[j]|).  The loop over the lanes is
+// vectorized when the compiler can gather x[col_idx[p]] (e.g. AVX2).
+//
+// With nthreads > 1, the rows are split into ranges with about the same
+// number of nonzeros.  The version with a double y stores each result
+// rounded to double.
+//
+
+#define DD_SPMV_LANES 4
+
+template <typename Index>
+inline DoubleDouble dd_csr_row_dot(size_t begin, size_t end,
+                                   const Index *col_idx, const double *values,
+                                   const double *x)
+{
+    double su[DD_SPMV_LANES] = {0.0};
+    double sl[DD_SPMV_LANES] = {0.0};
+    size_t p = begin;
+    for (; p + DD_SPMV_LANES <= end; p += DD_SPMV_LANES) {
+        for (size_t j = 0; j < DD_SPMV_LANES; ++j) {
+            double a = values[p + j];
+            double b = x[col_idx[p + j]];
+            double q = a*b;
+            double qe = dd_product_error(a, b, q);
+            double r = su[j] + q;
+            double t = r - su[j];
+            double e = (su[j] - (r - t)) + (q - t);
+            su[j] = r;
+            sl[j] += e + qe;
+        }
+    }
+    for (size_t j = 0; p < end; ++p, ++j) {
+        double a = values[p];
+        double b = x[col_idx[p]];
+        double q = a*b;
+        double qe = dd_product_error(a, b, q);
+        double r = su[j] + q;
+        double t = r - su[j];
+        double e = (su[j] - (r - t)) + (q - t);
+        su[j] = r;
+        sl[j] += e + qe;
+    }
+    // Merge the lanes the same way, with one renormalization at the end.
+    double s = su[0];
+    double l = sl[0];
+    for (size_t j = 1; j < DD_SPMV_LANES; ++j) {
+        double r = s + su[j];
+        double t = r - s;
+        l += ((s - (r - t)) + (su[j] - t)) + sl[j];
+        s = r;
+    }
+    return two_sum_quick(s, l);
+}
+
+template <typename Index, typename Store>
+inline void dd_csr_spmv_rows(size_t m, const Index *row_ptr,
+                             unsigned nthreads, Store store)
+{
+    size_t nnz = m > 0 ? size_t(row_ptr[m]) : 0;
+    // Give each thread at least 64K nonzeros.
+    nthreads = dd_parallel_nthreads(nnz, nthreads, 65536);
+    if (nthreads == 1) {
+        for (size_t i = 0; i < m; ++i) {
+            store(i);
+        }
+        return;
+    }
+    // Row range k starts at the first row with row_ptr >= k*nnz/nthreads.
+    std::vector<size_t> start(nthreads + 1);
+    for (unsigned k = 0; k <= nthreads; ++k) {
+        Index target = Index(nnz * k / nthreads);
+        start[k] = std::lower_bound(row_ptr, row_ptr + m, target) - row_ptr;
+    }
+    start[nthreads] = m;
+    dd_parallel_run(nthreads, [&](unsigned k) {
+        for (size_t i = start[k]; i < start[k + 1]; ++i) {
+            store(i);
+        }
+    });
+}
+
+template <typename Index>
+inline void dd_csr_spmv(size_t m, const Index *row_ptr, const Index *col_idx,
+                        const double *values, const double *x,
+                        DoubleDouble *y, unsigned nthreads = 1)
+{
+    dd_csr_spmv_rows(m, row_ptr, nthreads, [&](size_t i) {
+        y[i] = dd_csr_row_dot(size_t(row_ptr[i]), size_t(row_ptr[i + 1]),
+                              col_idx, values, x);
+    });
+}
+
+template <typename Index>
+inline void dd_csr_spmv(size_t m, const Index *row_ptr, const Index *col_idx,
+                        const double *values, const double *x,
+                        double *y, unsigned nthreads = 1)
+{
+    dd_csr_spmv_rows(m, row_ptr, nthreads, [&](size_t i) {
+        y[i] = dd_csr_row_dot(size_t(row_ptr[i]), size_t(row_ptr[i + 1]),
+                              col_idx, values, x).upper;
+    });
+}
+
+//
+// Mixed precision linear solver.
+//
+// dd_lu_factor() computes the LU factorization with partial pivoting of
+// the n x n double matrix A, in double precision, overwriting A with L
+// (unit lower triangular, not stored on the diagonal) and U.  piv[i] is
+// the row that was swapped with row i at step i.  It returns 0 on
+// success, or i + 1 if U[i, i] is exactly zero (A is singular).
+//
+// dd_lu_solve() solves A*x = b in double precision using the factors
+// computed by dd_lu_factor(); b is overwritten with x.
+//
+
+inline size_t dd_lu_factor(size_t n, double *A, size_t lda, size_t *piv)
+{
+    for (size_t k = 0; k < n; ++k) {
+        size_t p = k;
+        double pmax = std::fabs(A[k*lda + k]);
+        for (size_t i = k + 1; i < n; ++i) {
+            double v = std::fabs(A[i*lda + k]);
+            if (v > pmax) {
+                pmax = v;
+                p = i;
+            }
+        }
+        piv[k] = p;
+        if (pmax == 0.0) {
+            return k + 1;
+        }
+        if (p != k) {
+            std::swap_ranges(A + k*lda, A + k*lda + n, A + p*lda);
+        }
+        const double *rowk = A + k*lda;
+        for (size_t i = k + 1; i < n; ++i) {
+            double *rowi = A + i*lda;
+            double l = rowi[k] / rowk[k];
+            rowi[k] = l;
+            for (size_t j = k + 1; j < n; ++j) {
+                rowi[j] -= l*rowk[j];
+            }
+        }
+    }
+    return 0;
+}
+
+inline void dd_lu_solve(size_t n, const double *LU, size_t lda,
+                        const size_t *piv, double *b)
+{
+    for (size_t k = 0; k < n; ++k) {
+        std::swap(b[k], b[piv[k]]);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        double s = b[i];
+        for (size_t j = 0; j < i; ++j) {
+            s -= LU[i*lda + j]*b[j];
+        }
+        b[i] = s;
+    }
+    for (size_t i = n; i-- > 0; ) {
+        double s = b[i];
+        for (size_t j = i + 1; j < n; ++j) {
+            s -= LU[i*lda + j]*b[j];
+        }
+        b[i] = s / LU[i*lda + i];
+    }
+}
+
+//
+// dd_residual() computes r = b - A*x, where A is an m x n double matrix,
+// b is a double vector and x is a DoubleDouble vector.  Each element is
+// computed with ddot_dd() (two_product() and DoubleDouble accumulation),
+// so the residual is accurate even though it is the difference of
+// nearly equal quantities.
+//
+
+inline void dd_residual(size_t m, size_t n, const double *A, size_t lda,
+                        const double *b, const DoubleDouble *x,
+                        DoubleDouble *r, unsigned nthreads = 1)
+{
+    auto rows = [&](unsigned, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            r[i] = b[i] - ddot_dd(n, x, A + i*lda);
+        }
+    };
+    size_t rows_per_chunk = std::max(size_t(1),
+                                     size_t(65536) / std::max(n, size_t(1)));
+    nthreads = dd_parallel_nthreads(m, nthreads, rows_per_chunk);
+    dd_parallel_ranges(m, nthreads, rows, rows_per_chunk);
+}
+
+//
+// dd_solve_refine() solves the n x n system A*x = b, where A and b are
+// double, and returns x as DoubleDouble.  A is factored once, in double
+// precision, with dd_lu_factor().  Then the solution is improved by
+// iterative refinement:
+//
+//     r = b - A*x      (in DoubleDouble, with dd_residual())
+//     solve A*d = r    (in double, with the LU factors)
+//     x = x + d        (in DoubleDouble)
+//
+// The iteration stops when the correction is negligible at DoubleDouble
+// precision (||d|| <= 2**-104 * ||x||, max norm), when the correction
+// no longer decreases by at least half per iteration, when the
+// correction or x is not finite, or after max_iter iterations.  The
+// correction stops decreasing when it reaches the level of the rounding
+// errors in the residual, about cond(A) * 2**-104 * ||x||; x is then as
+// accurate as the condition of A allows, and that is reported as
+// convergence if ||d|| is below DBL_EPSILON * ||x||.  If cond(A) is well
+// below 1/DBL_EPSILON, x converges in a few iterations, at the cost of
+// one double precision factorization plus O(n**2) work per iteration.
+//
+
+enum class dd_refine_status {
+    converged,      // x is as accurate as the condition of A allows.
+    stalled,        // The correction stopped decreasing before x was
+                    // more accurate than double precision (A is too
+                    // ill-conditioned); x is the last iterate.
+    max_iter,       // max_iter iterations were done without converging.
+    singular,       // An exactly zero pivot was found; x is not set.
+    nonfinite       // A correction or x is not finite (A or b has a NaN
+                    // or an infinity, or the iteration overflowed); x is
+                    // the last iterate.
+};
+
+struct dd_refine_result {
+    dd_refine_status status;
+    int iterations;
+};
+
+inline dd_refine_result dd_solve_refine(size_t n, const double *A, size_t lda,
+                                        const double *b, DoubleDouble *x,
+                                        int max_iter = 10,
+                                        unsigned nthreads = 1)
+{
+    std::vector<double> lu(n*n);
+    for (size_t i = 0; i < n; ++i) {
+        std::copy(A + i*lda, A + i*lda + n, &lu[i*n]);
+    }
+    std::vector<size_t> piv(n);
+    if (dd_lu_factor(n, lu.data(), n, piv.data()) != 0) {
+        return dd_refine_result{dd_refine_status::singular, 0};
+    }
+
+    std::vector<double> d(b, b + n);
+    dd_lu_solve(n, lu.data(), n, piv.data(), d.data());
+    for (size_t i = 0; i < n; ++i) {
+        x[i] = DoubleDouble(d[i]);
+    }
+
+    std::vector<DoubleDouble> r(n);
+    double prev_dnorm = INFINITY;
+    for (int iter = 1; iter <= max_iter; ++iter) {
+        dd_residual(n, n, A, lda, b, x, r.data(), nthreads);
+        for (size_t i = 0; i < n; ++i) {
+            d[i] = r[i].upper;
+        }
+        dd_lu_solve(n, lu.data(), n, piv.data(), d.data());
+        double dnorm = 0.0;
+        double xnorm = 0.0;
+        bool finite = true;
+        for (size_t i = 0; i < n; ++i) {
+            x[i] += d[i];
+            // std::max() would drop a NaN, so it is checked separately.
+            finite = finite && std::isfinite(d[i])
+                     && std::isfinite(x[i].upper);
+            dnorm = std::max(dnorm, std::fabs(d[i]));
+            xnorm = std::max(xnorm, std::fabs(x[i].upper));
+        }
+        if (!finite) {
+            return dd_refine_result{dd_refine_status::nonfinite, iter};
+        }
+        if (dnorm <= std::ldexp(xnorm, -104)) {
+            return dd_refine_result{dd_refine_status::converged, iter};
+        }
+        if (dnorm > 0.5*prev_dnorm) {
+            if (dnorm <= DBL_EPSILON*xnorm) {
+                return dd_refine_result{dd_refine_status::converged, iter};
+            }
+            return dd_refine_result{dd_refine_status::stalled, iter};
+        }
+        prev_dnorm = dnorm;
+    }
+    return dd_refine_result{dd_refine_status::max_iter, max_iter};
+}
+
+} // namespace
+
+#endif
@@ -0,0 +1,195 @@
+//
+// Multithreaded reductions with DoubleDouble.
+// Copyright © 2022 Warren Weckesser
+//
+// MIT license:
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the “Software”), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED “AS IS”, WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+// DEALINGS IN THE SOFTWARE.
+//
+//
+// The functions in this header use std::thread, so on some platforms
+// programs that use them must be linked with -pthread.
+//
+// The work is split into contiguous ranges, one per thread, with range
+// boundaries at multiples of DD_PARALLEL_CHUNK elements.  The calling
+// thread computes the first range.  The partial results are combined in
+// the order of the ranges, so for a given number of threads the result
+// does not depend on how the threads are scheduled.
+//
+
+#ifndef DOUBLEDOUBLE_PARALLEL_H
+#define DOUBLEDOUBLE_PARALLEL_H
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+#include "doubledouble.h"
+
+namespace doubledouble {
+
+// 32768 doubles (256 KiB): a range is never smaller than this, so small
+// inputs do not pay for starting threads that have little to do.
+#define DD_PARALLEL_CHUNK 32768
+
+//
+// Return the number of threads to use for n elements when nthreads
+// threads are requested.  nthreads == 0 means one per hardware thread.
+// Each thread gets at least chunk elements.
+//
+inline unsigned dd_parallel_nthreads(size_t n, unsigned nthreads,
+                                     size_t chunk = DD_PARALLEL_CHUNK)
+{
+    if (nthreads == 0) {
+        nthreads = std::thread::hardware_concurrency();
+        if (nthreads == 0) {
+            nthreads = 1;
+        }
+    }
+    size_t nchunks = (n + chunk - 1) / chunk;
+    if (nchunks < nthreads) {
+        nthreads = nchunks > 0 ? unsigned(nchunks) : 1;
+    }
+    return nthreads;
+}
+
+//
+// Call f(k) for k = 0, ..., nthreads-1, each on its own thread.  (f(0)
+// is run on the calling thread.)  If starting a thread or f(0) throws,
+// the threads already started are joined before the exception is
+// rethrown (destroying a joinable std::thread would call
+// std::terminate()).
+//
+template <typename F>
+inline void dd_parallel_run(unsigned nthreads, F f)
+{
+    std::vector<std::thread> workers;
+    try {
+        workers.reserve(nthreads - 1);
+        for (unsigned k = 1; k < nthreads; ++k) {
+            workers.emplace_back(f, k);
+        }
+        f(0);
+    }
+    catch (...) {
+        for (auto& w : workers) {
+            w.join();
+        }
+        throw;
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+}
+
+//
+// Split [0, n) into nthreads ranges and call f(k, begin, end) for range k
+// on its own thread.  (Range 0 is run on the calling thread.)  The range
+// boundaries are multiples of chunk.
+//
+template <typename F>
+inline void dd_parallel_ranges(size_t n, unsigned nthreads, F f,
+                               size_t chunk = DD_PARALLEL_CHUNK)
+{
+    size_t nchunks = (n + chunk - 1) / chunk;
+    auto boundary = [&](unsigned k) {
+        size_t b = (nchunks * k / nthreads) * chunk;
+        return b < n ? b : n;
+    };
+    dd_parallel_run(nthreads, [&](unsigned k) {
+        f(k, boundary(k), boundary(k + 1));
+    });
+}
+
+//
+// dsum_parallel_dd() sums an array of doubles using nthreads threads and
+// returns the DoubleDouble sum.  Each thread computes dsum_dd() of its
+// range, and the partial sums are added with DoubleDouble addition.
+// dsum_parallel() returns the sum rounded to double.
+//
+// nthreads == 0 means one thread per hardware thread.
+//
+
+inline DoubleDouble dsum_parallel_dd(size_t n, const double *x,
+                                     unsigned nthreads = 0)
+{
+    nthreads = dd_parallel_nthreads(n, nthreads);
+    if (nthreads == 1) {
+        return dsum_dd(n, x);
+    }
+    std::vector<DoubleDouble> partial(nthreads);
+    dd_parallel_ranges(n, nthreads, [&](unsigned k, size_t begin, size_t end) {
+        partial[k] = dsum_dd(end - begin, x + begin);
+    });
+    DoubleDouble sum = partial[0];
+    for (unsigned k = 1; k < nthreads; ++k) {
+        sum += partial[k];
+    }
+    return sum;
+}
+
+inline double dsum_parallel(size_t n, const double *x, unsigned nthreads = 0)
+{
+    return dsum_parallel_dd(n, x, nthreads).upper;
+}
+
+inline double dsum_parallel(const std::vector<double>& x, unsigned nthreads = 0)
+{
+    return dsum_parallel(x.size(), x.data(), nthreads);
+}
+
+//
+// ddot_parallel_dd() computes the dot product of x and y using nthreads
+// threads and returns the DoubleDouble result; each thread computes
+// ddot_dd() of its range.  ddot_parallel() returns the result rounded
+// to double.
+//
+
+inline DoubleDouble ddot_parallel_dd(size_t n, const double *x,
+                                     const double *y, unsigned nthreads = 0)
+{
+    nthreads = dd_parallel_nthreads(n, nthreads);
+    if (nthreads == 1) {
+        return ddot_dd(n, x, y);
+    }
+    std::vector<DoubleDouble> partial(nthreads);
+    dd_parallel_ranges(n, nthreads, [&](unsigned k, size_t begin, size_t end) {
+        partial[k] = ddot_dd(end - begin, x + begin, y + begin);
+    });
+    DoubleDouble sum = partial[0];
+    for (unsigned k = 1; k < nthreads; ++k) {
+        sum += partial[k];
+    }
+    return sum;
+}
+
+inline double ddot_parallel(size_t n, const double *x, const double *y,
+                            unsigned nthreads = 0)
+{
+    return ddot_parallel_dd(n, x, y, nthreads).upper;
+}
+
+inline double ddot_parallel(const std::vector<double>& x,
+                            const std::vector<double>& y, unsigned nthreads = 0)
+{
+    return ddot_parallel(x.size(), x.data(), y.data(), nthreads);
+}
+
+} // namespace
+
+#endif
@@ -3,6 +3,7 @@
 #include <cstdio>
 #include <vector>
 #include <cmath>
+#include <random>
 #include "checkit.h"
 #include "doubledouble.h"
 
@@ -20,6 +21,18 @@ using namespace doubledouble;
 // compilers, and compiler options.
 //
 
+//
+// Check that y is within 4 units of 2**-106 of hi + lo, relative to hi.
+// (Requiring the lower parts to agree to 5e-16 would be much stricter
+// than that when |lo| is much less than ulp(hi).)
+//
+void assert_dd_close(CheckIt& test, const DoubleDouble& y, double hi, double lo,
+                     const std::string& name)
+{
+    DoubleDouble err = (y - DoubleDouble(hi, lo)).abs();
+    assert_true(test, err <= std::fabs(hi)*4.930380657631324e-32, name);
+}
+
 void test_constructor(CheckIt& test)
 {
     DoubleDouble d;
@@ -218,6 +231,120 @@ void test_inplace_divide(CheckIt& test)
     assert_isnan(test, z);
 }
 
+void test_fused(CheckIt& test)
+{
+    // Reference values were computed with 100 digit decimal arithmetic.
+    // The error of dd_fma(a, b, c) is bounded relative to |a*b| + |c|.
+    DoubleDouble ref{0.03973422267356706, 2.6300735326659838e-18};
+    double bound = 17.04*4.930380657631324e-32;
+    DoubleDouble y = dd_fma(dd_pi, dd_e, DoubleDouble(-8.5));
+    assert_equal_fp(test, y.upper, ref.upper, "dd_fma(pi, e, -8.5) (upper)");
+    assert_true(test, (y - ref).abs() < bound, "dd_fma(pi, e, -8.5)");
+    y = dd_fma(dd_pi, dd_e, -8.5);
+    assert_equal_fp(test, y.upper, ref.upper, "dd_fma(pi, e, -8.5) (double c) (upper)");
+    assert_true(test, (y - ref).abs() < bound, "dd_fma(pi, e, -8.5) (double c)");
+    y = dd_fma(dd_pi, dd_e, DoubleDouble(-8.5));
+    assert_true(test, (y - (dd_pi*dd_e - 8.5)).abs() < bound,
+                "dd_fma(pi, e, -8.5) == pi*e - 8.5");
+
+    y = DoubleDouble(1.5, 1e-17).sqr();
+    assert_dd_close(test, y, 2.25, 3e-17, "(1.5, 1e-17).sqr()");
+    y = DoubleDouble(-1.5, -1e-17).sqr();
+    assert_dd_close(test, y, 2.25, 3e-17, "(-1.5, -1e-17).sqr()");
+
+    y = DoubleDouble(3.0).recip();
+    assert_equal_fp(test, y.upper, 0.3333333333333333, "3.recip() (upper)");
+    assert_close_fp(test, y.lower, 1.850371707708594e-17, 5e-16, "3.recip() (lower)");
+    y = DoubleDouble(7.0, 1e-17).recip();
+    assert_dd_close(test, y, 0.14285714285714285, 7.7260828289552e-18, "(7, 1e-17).recip()");
+
+    assert_isnan(test, dd_fma(DoubleDouble(NAN), dd_one, dd_one));
+    assert_isnan(test, dd_fma(dd_one, dd_one, NAN));
+    assert_isnan(test, DoubleDouble(NAN).sqr());
+    assert_isnan(test, DoubleDouble(NAN).recip());
+}
+
+//
+// dd_product_error() is exact whether it uses fma() or Dekker's product
+// (see dd_has_fma), so it must agree with std::fma(), which is always
+// exact, also for huge operands and products close to overflow.
+//
+void test_product_error(CheckIt& test)
+{
+    std::mt19937_64 gen(42);
+    std::uniform_real_distribution<double> m(1.0, 2.0);
+    std::uniform_int_distribution<int> ex(-500, 500);
+    int mismatches = 0;
+    for (int i = 0; i < 100000; ++i) {
+        double x = std::ldexp(m(gen), ex(gen));
+        double y = std::ldexp(m(gen), ex(gen));
+        if (i % 2) {
+            x = -x;
+        }
+        double r = x*y;
+        if (dd_product_error(x, y, r) != std::fma(x, y, -r)) {
+            ++mismatches;
+        }
+    }
+    assert_equal_integer(test, mismatches, 0, "dd_product_error() == fma()");
+
+    for (auto xy : {std::make_pair(1.7976931348623157e308, 0.75),
+                    std::make_pair(-1.1444540005769547e+308, 1.5707963267948966),
+                    std::make_pair(1e305, 3.1e-10),
+                    std::make_pair(0.1, 1.7976931348623157e308)}) {
+        double r = xy.first*xy.second;
+        std::stringstream name;
+        name << "dd_product_error(" << xy.first << ", " << xy.second << ")";
+        assert_equal_fp(test, dd_product_error(xy.first, xy.second, r),
+                        std::fma(xy.first, xy.second, -r), name.str());
+    }
+}
+
+//
+// The arithmetic can be evaluated at compile time.  two_product() uses
+// Dekker's algorithm there instead of fma(); both are exact, so the
+// results must be the same as at run time.
+//
+static DoubleDouble at_run_time(const DoubleDouble& x)
+{
+    volatile double hi = x.upper;
+    volatile double lo = x.lower;
+    return DoubleDouble(hi, lo, dd_unchecked);
+}
+
+void test_constexpr(CheckIt& test)
+{
+    static_assert(dd_one + dd_one == 2.0, "1 + 1 == 2");
+    static_assert(DoubleDouble(0.1)*10 > 1.0, "0.1*10 > 1");
+    static_assert(dd_pi.abs() == dd_pi && (-dd_pi).abs() == dd_pi, "|-pi| == pi");
+
+    constexpr DoubleDouble third = DoubleDouble(1.0)/3;
+    constexpr DoubleDouble pi2 = dd_pi.sqr();
+    constexpr DoubleDouble pi_e = dd_pi*dd_e;
+    constexpr DoubleDouble r = dd_fma(dd_pi, dd_e, -8.5);
+    constexpr DoubleDouble inv = DoubleDouble(7.0, 1e-17).recip();
+    constexpr DoubleDouble p = dd_ln2.powi(-5);
+    constexpr DoubleDouble q = dd_sqrt2.powi<15>();
+    constexpr std::array<double, 4> c{1.0, -0.5, 0.25, -0.125};
+    constexpr DoubleDouble v = dd_polyval(c, dd_sqrt1_2);
+
+    DoubleDouble one = at_run_time(dd_one);
+    assert_true(test, third == one/3, "constexpr 1/3");
+    assert_true(test, pi2 == at_run_time(dd_pi).sqr(), "constexpr pi.sqr()");
+    assert_true(test, pi_e == at_run_time(dd_pi)*dd_e, "constexpr pi*e");
+    assert_true(test, r == dd_fma(at_run_time(dd_pi), dd_e, -8.5),
+                "constexpr dd_fma(pi, e, -8.5)");
+    assert_true(test, inv == at_run_time(DoubleDouble(7.0, 1e-17)).recip(),
+                "constexpr (7, 1e-17).recip()");
+    assert_true(test, p == at_run_time(dd_ln2).powi(-5), "constexpr ln2**-5");
+    assert_true(test, q == at_run_time(dd_sqrt2).powi<15>(), "constexpr sqrt2**15");
+    assert_true(test, v == dd_polyval(c, at_run_time(dd_sqrt1_2)),
+                "constexpr polyval");
+
+    constexpr DoubleDouble n = DoubleDouble(NAN)*2.0;
+    assert_isnan(test, n);
+}
+
 void test_expressions(CheckIt& test)
 {
     DoubleDouble y;
@@ -317,6 +444,104 @@ void test_powi(CheckIt& test)
     assert_isnan(test, y);
 }
 
+template <int N>
+void check_powi_chain(CheckIt& test, const DoubleDouble& x)
+{
+    DoubleDouble y = x.powi<N>();
+    DoubleDouble ref = x.powi(N);
+    std::stringstream s;
+    s << "x.powi<" << N << ">() vs x.powi(" << N << ")";
+    // 8 units of 2**-106.
+    assert_true(test, ((y - ref)/ref).abs() < 9.860761315262648e-32, s.str());
+}
+
+void test_powi_chain(CheckIt& test)
+{
+    static_assert(dd_powi_chain<15>::chain.length == 5, "x**15 takes 5 steps");
+    static_assert(dd_powi_chain<127>::chain.length == 10, "x**127 takes 10 steps");
+
+    auto x = DoubleDouble(10.0, 3e-18);
+    auto y = x.powi<4>();
+    assert_equal_fp(test, y.upper, 10000.0, "Check x.powi<4>() (upper)");
+    assert_close_fp(test, y.lower, 1.2e-14, 5e-16, "Check x.powi<4>() (lower)");
+
+    auto z = DoubleDouble(1.1, 1e-17);
+    check_powi_chain<2>(test, z);
+    check_powi_chain<3>(test, z);
+    check_powi_chain<5>(test, z);
+    check_powi_chain<15>(test, z);
+    check_powi_chain<31>(test, z);
+    check_powi_chain<127>(test, z);
+    check_powi_chain<200>(test, z);
+    check_powi_chain<-2>(test, z);
+    check_powi_chain<-7>(test, z);
+
+    y = DoubleDouble(NAN).powi<0>();
+    assert_true(test, y == 1.0, "NAN.powi<0>() is 1");
+    y = DoubleDouble(NAN).powi<3>();
+    assert_isnan(test, y);
+    y = DoubleDouble(NAN).powi<-2>();
+    assert_isnan(test, y);
+}
+
+void test_powers_table(CheckIt& test)
+{
+    DoubleDoublePowers e(dd_e, 16);
+    for (int n : {0, 1, 2, 7, 16, 17, 40, -1, -5, -16, -40}) {
+        DoubleDouble y = e(n);
+        DoubleDouble ref = dd_e.powi(n);
+        std::stringstream s;
+        s << "DoubleDoublePowers(dd_e)(" << n << ")";
+        assert_true(test, ((y - ref)/ref).abs() < 9.860761315262648e-32, s.str());
+    }
+    assert_true(test, e(0) == 1.0, "DoubleDoublePowers(dd_e)(0) is 1");
+    assert_true(test, e(1) == dd_e, "DoubleDoublePowers(dd_e)(1) is dd_e");
+}
+
+template <dd_poly_scheme Scheme>
+void check_polyval(CheckIt& test, const char *name)
+{
+    // With integer coefficients and an integer x, every scheme is exact.
+    const std::array<double, 7> c{3, -2, 5, 1, -4, 7, 2};
+    const std::array<DoubleDouble, 7> cdd{3, -2, 5, 1, -4, 7, 2};
+    double expected = 3 - 2*3.0 + 5*9.0 + 27.0 - 4*81.0 + 7*243.0 + 2*729.0;
+    std::stringstream s1, s2;
+    s1 << name << ": polyval with double coefficients";
+    s2 << name << ": polyval with DoubleDouble coefficients";
+    assert_true(test, dd_polyval<Scheme>(c, DoubleDouble(3.0)) == expected, s1.str());
+    assert_true(test, dd_polyval<Scheme>(cdd, DoubleDouble(3.0)) == expected, s2.str());
+
+    const std::array<double, 1> c1{2.5};
+    assert_true(test, dd_polyval<Scheme>(c1, DoubleDouble(7.0)) == 2.5, "polyval of a constant");
+    const std::array<double, 2> c2{1.0, -0.5};
+    assert_true(test, dd_polyval<Scheme>(c2, DoubleDouble(3.0)) == -0.5, "polyval of a line");
+
+    // Taylor polynomial of exp(x) with degree 26 at x = 1/3.
+    std::array<DoubleDouble, 27> e;
+    e[0] = 1.0;
+    for (int k = 1; k < 27; ++k) {
+        e[k] = e[k - 1]/double(k);
+    }
+    DoubleDouble x = 1.0/DoubleDouble(3.0);
+    DoubleDouble y = dd_polyval<Scheme>(e, x);
+    DoubleDouble ref = dd_polyval<dd_poly_scheme::horner>(e, x);
+    std::stringstream s3;
+    s3 << name << ": polyval of the Taylor polynomial of exp(x)";
+    assert_true(test, ((y - ref)/ref).abs() < 1e-31, s3.str());
+    assert_equal_fp(test, y.upper, 1.3956124250860895, s3.str());
+
+    const std::array<double, 2> p{1.0, 1.0};
+    const std::array<double, 2> q{1.0, -1.0};
+    assert_true(test, dd_ratval<Scheme>(p, q, DoubleDouble(0.5)) == 3.0, "ratval (1 + x)/(1 - x)");
+}
+
+void test_polyval(CheckIt& test)
+{
+    check_polyval<dd_poly_scheme::horner>(test, "horner");
+    check_polyval<dd_poly_scheme::horner2>(test, "horner2");
+    check_polyval<dd_poly_scheme::estrin>(test, "estrin");
+}
+
 void test_sqrt(CheckIt& test)
 {
     DoubleDouble y;
@@ -351,11 +576,9 @@ void test_log(CheckIt& test)
     assert_equal_fp(test, y.upper, 1.0, "log(e) (upper)");
     assert_equal_fp(test, y.lower, 0.0, "log(e) (lower)");
 
-    // The actual relative error for log(1.000000099005) is approx. 8.7e-10.
-    // Can we do better?
     y = DoubleDouble(1.000000099005, 0.0).log();
     assert_equal_fp(test, y.upper, 9.900499507506536e-08, "log(1.000000099005) (upper)");
-    assert_close_fp(test, y.lower, 4.563816054961034e-24, 2e-9, "log(1.000000099005) (lower)");
+    assert_close_fp(test, y.lower, 4.563816054961034e-24, 5e-16, "log(1.000000099005) (lower)");
 
     y = DoubleDouble(1.1, 0.0).log();
     assert_equal_fp(test, y.upper, 0.09531017980432493, "log(1.1) (upper)");
@@ -365,6 +588,25 @@ void test_log(CheckIt& test)
     assert_equal_fp(test, y.upper, -48.35428695287496, "log((1e-21, 3.5e-43)) (upper)");
     assert_close_fp(test, y.lower, -1.7511230665702564e-15, 5e-16, "log((1e-21, 3.5e-43)) (lower)");
 
+    y = DoubleDouble(0.9990234375).log();
+    assert_equal_fp(test, y.upper, -0.0009770396478266127, "log(1 - 2**-10) (upper)");
+    assert_close_fp(test, y.lower, -4.348919509358116e-20, 5e-16, "log(1 - 2**-10) (lower)");
+
+    y = DoubleDouble(1e-310).log();
+    assert_equal_fp(test, y.upper, -713.8013788281542, "log(1e-310) (upper)");
+    assert_close_fp(test, y.lower, -8.592254740270771e-15, 5e-16, "log(1e-310) (lower)");
+
+    y = DoubleDouble(1.7e308).log();
+    assert_equal_fp(test, y.upper, 709.7268368932282, "log(1.7e308) (upper)");
+    assert_close_fp(test, y.lower, 3.0936421257994655e-14, 5e-16, "log(1.7e308) (lower)");
+
+    y = DoubleDouble(0.0).log();
+    assert_true(test, y.upper == -INFINITY, "log(0) is -inf");
+    y = DoubleDouble(INFINITY).log();
+    assert_true(test, y.upper == INFINITY, "log(inf) is inf");
+    y = DoubleDouble(-1.0).log();
+    assert_isnan(test, y);
+
     y = DoubleDouble(NAN).log();
     assert_isnan(test, y);
 }
@@ -382,17 +624,18 @@ void test_log1p(CheckIt& test)
         {5e-16, 3.1e-50, 7e-68, 3.1e-50, 7e-68},
         {5e-16, 1.4e-30, 5e-48, 1.4e-30, 4.9999999999990196e-48},
 
-        {2e-15, 7.7e-16, 8.6e-34, 7.699999999999997e-16, 2.328394578795871e-34},
+        {5e-16, 7.7e-16, 8.6e-34, 7.699999999999997e-16, 2.328394578795871e-34},
         {5e-16, 3e-8, 0.0, 2.9999999550000006e-08, 4.44602137450418e-26},
         {5e-16, 5e-7, 0.0, 4.999998750000417e-07, -1.9801357223218586e-23},
         {5e-16, 2e-6, 0.0, 1.9999980000026667e-06, -1.6536017667488005e-22},
-        {4e-12, 2e-5, 0.0, 1.9999800002666627e-05, 1.3694019941860543e-21},
-        {5e-12, 7e-4, 0.0, 0.0006997551142733419, 8.045441159182502e-21},
-        {8e-14, 2.6e-3, 2e-20, 0.002596625847265978, 1.1029570690454358e-19},
-        {8e-14, -2.6e-3, -3e-21, -0.002603385870114881, 1.2070558387143255e-20},
+        {5e-16, 2e-5, 0.0, 1.9999800002666627e-05, 1.3694019941860543e-21},
+        {5e-16, 7e-4, 0.0, 0.0006997551142733419, 8.045441159182502e-21},
+        {5e-16, 2.6e-3, 2e-20, 0.002596625847265978, 1.1029570690454358e-19},
+        {5e-16, -2.6e-3, -3e-21, -0.002603385870114881, 1.2070558387143255e-20},
 
         {5e-16, -1.0, 2e-20, -45.35855467932097, -1.1302366343060957e-15},
         {5e-16, -0.5, -4.7e-18, -0.6931471805599453, -3.2590468138462995e-17},
+        {5e-16, -0.75, 1e-20, -1.3862943611198906, -4.6340936276925994e-17},
         {5e-16, 1.5, 5e-19, 0.9162907318741551, -4.121195369011963e-17},
         {5e-16, 3.0, 0.0, 1.3862943611198906, 4.638093627692599e-17}
     };
@@ -408,7 +651,14 @@ void test_log1p(CheckIt& test)
         assert_close_fp(test, y.lower, sample.ylo, sample.reltol, s2.str());
     }
 
-    auto y = DoubleDouble(NAN).log1p();
+    auto y = DoubleDouble(-1.0).log1p();
+    assert_true(test, y.upper == -INFINITY, "log1p(-1) is -inf");
+    y = DoubleDouble(-1.5).log1p();
+    assert_isnan(test, y);
+    y = DoubleDouble(INFINITY).log1p();
+    assert_true(test, y.upper == INFINITY, "log1p(inf) is inf");
+
+    y = DoubleDouble(NAN).log1p();
     assert_isnan(test, y);
 }
 
@@ -442,11 +692,34 @@ void test_exp(CheckIt& test)
     assert_equal_fp(test, y.upper, 1.0000000000000038, "exp(t) (upper)");
     assert_close_fp(test, y.lower, -2.4663276224724858e-17, 5e-16, "exp(t) (lower)");
 
-    // The actual relative error for exp(709).lower is approx. 2e-14.
-    // Can we do better?
     y = DoubleDouble(709.0).exp();
     assert_equal_fp(test, y.upper, 8.218407461554972e+307, "exp(709) upper");
-    assert_close_fp(test, y.lower, -1.955965507696277e+291, 1e-13, "exp(709) lower");
+    assert_close_fp(test, y.lower, -1.955965507696277e+291, 5e-16, "exp(709) lower");
+
+    y = DoubleDouble(-1.0).exp();
+    assert_equal_fp(test, y.upper, 0.36787944117144233, "exp(-1) upper");
+    assert_close_fp(test, y.lower, -1.2428753672788363e-17, 5e-16, "exp(-1) lower");
+
+    y = DoubleDouble(0.5).exp();
+    assert_equal_fp(test, y.upper, 1.6487212707001282, "exp(0.5) upper");
+    assert_close_fp(test, y.lower, -4.731568479435833e-17, 5e-16, "exp(0.5) lower");
+
+    y = DoubleDouble(-0.0078125).exp();
+    assert_equal_fp(test, y.upper, 0.9922179382602435, "exp(-2**-7) upper");
+    assert_close_fp(test, y.lower, -2.8192701381719798e-18, 5e-16, "exp(-2**-7) lower");
+
+    y = DoubleDouble(700.0).exp();
+    assert_equal_fp(test, y.upper, 1.0142320547350045e+304, "exp(700) upper");
+    assert_close_fp(test, y.lower, 1.6666571920734673e+287, 5e-16, "exp(700) lower");
+
+    y = DoubleDouble(-650.25).exp();
+    assert_equal_fp(test, y.upper, 3.9811921806329143e-283, "exp(-650.25) upper");
+    assert_close_fp(test, y.lower, 2.320354214140808e-299, 5e-16, "exp(-650.25) lower");
+
+    y = DoubleDouble(-746.0).exp();
+    assert_true(test, y == 0.0, "exp(-746) is 0");
+    y = DoubleDouble(-INFINITY).exp();
+    assert_true(test, y == 0.0, "exp(-inf) is 0");
 
     y = DoubleDouble(710.0).exp();
     assert_true(test, std::isinf(y.upper), "isinf(exp(710).upper)");
@@ -471,7 +744,7 @@ void test_expm1(CheckIt& test)
 
     y = DoubleDouble(0.46875).expm1();
     assert_equal_fp(test, y.upper, 0.5979954499506333, "expm1(0.46875) upper");
-    assert_equal_fp(test, y.lower, 1.6864630310268093e-17, "expm1(0.46875) lower");
+    assert_close_fp(test, y.lower, 1.6864630310268093e-17, 5e-16, "expm1(0.46875) lower");
 
     y = t.expm1();
     assert_equal_fp(test, y.upper, 3.7500950075008074e-15, "expm1(t) upper");
@@ -483,7 +756,7 @@ void test_expm1(CheckIt& test)
 
     y = DoubleDouble(-0.46875).expm1();
     assert_equal_fp(test, y.upper, -0.37421599039540887, "expm1(-0.46875) upper");
-    assert_equal_fp(test, y.lower, -7.658883125910196e-18, "expm1(-0.46875) lower");
+    assert_close_fp(test, y.lower, -7.658883125910196e-18, 5e-16, "expm1(-0.46875) lower");
 
     y = DoubleDouble(-17.5).expm1();
     assert_equal_fp(test, y.upper, -0.9999999748900085, "expm1(-17.5) upper");
@@ -493,6 +766,286 @@ void test_expm1(CheckIt& test)
     assert_isnan(test, y);
 }
 
+//
+// The dd_accurate tier of add() and sub() keeps the lower parts when the
+// upper parts cancel; the dd_fast tier of exp(), expm1() and log() is
+// within 2**-86 (relative) of the accurate tier.
+//
+void test_tiers(CheckIt& test)
+{
+    DoubleDouble x{1.0, 1e-17};
+    DoubleDouble y{-1.0, 1e-34};
+    DoubleDouble z = x.add(y, dd_accurate);
+    DoubleDouble expected = two_sum(1e-17, 1e-34);
+    assert_true(test, z.upper == expected.upper && z.lower == expected.lower,
+                "add(dd_accurate) with cancellation");
+    z = x.sub(-y, dd_accurate);
+    assert_true(test, z.upper == expected.upper && z.lower == expected.lower,
+                "sub(dd_accurate) with cancellation");
+#ifdef DOUBLEDOUBLE_ACCURATE_ADD
+    assert_true(test, x.add(y, dd_accurate) == x + y, "add(dd_accurate) is operator+");
+    assert_true(test, x.sub(y, dd_accurate) == x - y, "sub(dd_accurate) is operator-");
+#else
+    assert_true(test, x.add(y, dd_fast) == x + y, "add(dd_fast) is operator+");
+    assert_true(test, x.sub(y, dd_fast) == x - y, "sub(dd_fast) is operator-");
+#endif
+
+    DoubleDouble v{0.6875, 1e-17};
+    assert_true(test, v.exp(dd_accurate) == v.exp(), "exp(dd_accurate)");
+    assert_true(test, v.expm1(dd_accurate) == v.expm1(), "expm1(dd_accurate)");
+    assert_true(test, v.log(dd_accurate) == v.log(), "log(dd_accurate)");
+
+    const double tol = 1.3e-26;
+    for (double t : {-700.5, -20.25, -1.0, -0.0054, -1e-5, 1e-20, 0.0054,
+                     0.3, 0.5, 3.75, 100.0, 709.5}) {
+        DoubleDouble u = DoubleDouble(t) + t*1.5e-17;
+        DoubleDouble e = u.exp();
+        assert_true(test, ((u.exp(dd_fast) - e)/e).abs() < tol,
+                    "exp(dd_fast) at " + std::to_string(t));
+        e = u.expm1();
+        assert_true(test, ((u.expm1(dd_fast) - e)/e).abs() < tol,
+                    "expm1(dd_fast) at " + std::to_string(t));
+        u = u.abs();
+        e = u.log();
+        assert_true(test, ((u.log(dd_fast) - e)/e).abs() < tol,
+                    "log(dd_fast) at " + std::to_string(t));
+    }
+
+    assert_true(test, DoubleDouble(710.0).exp(dd_fast) == dd_inf, "exp(710, dd_fast)");
+    assert_true(test, DoubleDouble(-746.0).exp(dd_fast) == 0.0, "exp(-746, dd_fast)");
+    assert_true(test, DoubleDouble(-800.0).expm1(dd_fast) == -1.0, "expm1(-800, dd_fast)");
+    assert_true(test, DoubleDouble(0.0).expm1(dd_fast) == 0.0, "expm1(0, dd_fast)");
+    assert_true(test, DoubleDouble(1.0).log(dd_fast) == 0.0, "log(1, dd_fast)");
+    assert_true(test, DoubleDouble(0.0).log(dd_fast) == -dd_inf, "log(0, dd_fast)");
+    z = DoubleDouble(NAN).exp(dd_fast);
+    assert_isnan(test, z);
+    z = DoubleDouble(NAN).expm1(dd_fast);
+    assert_isnan(test, z);
+    z = DoubleDouble(-1.0).log(dd_fast);
+    assert_isnan(test, z);
+}
+
+struct trig_case {
+    double xhi, xlo;
+    double sin_hi, sin_lo, cos_hi, cos_lo, tan_hi, tan_lo;
+};
+
+void test_trig(CheckIt& test)
+{
+    // Reference values were computed with 120 digit decimal arithmetic.
+    struct trig_case samples[] = {
+        {0.5, 0.0, 0.479425538604203, -5.103969860556013e-18,
+         0.8775825618903728, -4.2623149864279997e-17,
+         0.5463024898437905, 2.9096576216837176e-17},
+        {10.0, 0.0, -0.5440211108893698, -3.8949898668223557e-17,
+         -0.8390715290764524, -1.4147119988953418e-17,
+         0.6483608274590866, 4.076151603893501e-17},
+        {-3.0, 0.0, -0.1411200080598672, -8.577269787017502e-18,
+         -0.9899924966004454, -4.2060261566099734e-17,
+         0.1425465430742778, 1.3870349067877843e-18},
+        {1e-20, 0.0, 1e-20, -1.6666666666666664e-61,
+         1.0, -5e-41,
+         1e-20, 3.333333333333333e-61},
+        {123456.75, 0.0, -0.9999194125227623, 2.956548565783939e-17,
+         0.01269521406412672, 8.062567115404594e-19,
+         -78.76349366555914, -3.1523150267067534e-15},
+    };
+    for (size_t i = 0; i < sizeof(samples)/sizeof(struct trig_case); ++i) {
+        struct trig_case sample = samples[i];
+        DoubleDouble x{sample.xhi, sample.xlo};
+        DoubleDouble s = x.sin();
+        DoubleDouble c = x.cos();
+        DoubleDouble t = x.tan();
+        std::stringstream name;
+        name << "trig case " << i;
+        assert_equal_fp(test, s.upper, sample.sin_hi, name.str() + " sin (upper)");
+        assert_close_fp(test, s.lower, sample.sin_lo, 5e-16, name.str() + " sin (lower)");
+        assert_equal_fp(test, c.upper, sample.cos_hi, name.str() + " cos (upper)");
+        assert_close_fp(test, c.lower, sample.cos_lo, 5e-16, name.str() + " cos (lower)");
+        assert_equal_fp(test, t.upper, sample.tan_hi, name.str() + " tan (upper)");
+        assert_close_fp(test, t.lower, sample.tan_lo, 1e-15, name.str() + " tan (lower)");
+        DoubleDouble s2, c2;
+        x.sincos(s2, c2);
+        assert_true(test, s2 == s && c2 == c, name.str() + " sincos");
+    }
+
+    // sin(dd_pi) is pi - dd_pi.
+    DoubleDouble y = dd_pi.sin();
+    assert_close_fp(test, y.upper, -2.9947698097183397e-33, 1e-14, "sin(dd_pi)");
+    y = dd_pi.cos();
+    assert_equal_fp(test, y.upper, -1.0, "cos(dd_pi) (upper)");
+    assert_true(test, std::fabs(y.lower) < 1e-32, "cos(dd_pi) (lower)");
+
+    // cos(x) for x = fl(pi/2) is pi/2 - x.
+    y = DoubleDouble(1.5707963267948966).cos();
+    assert_equal_fp(test, y.upper, 6.123233995736766e-17, "cos(fl(pi/2)) (upper)");
+    assert_close_fp(test, y.lower, -1.4973849048591698e-33, 1e-14, "cos(fl(pi/2)) (lower)");
+    y = DoubleDouble(1.5707963267948966).tan();
+    assert_equal_fp(test, y.upper, 1.633123935319537e+16, "tan(fl(pi/2)) (upper)");
+    assert_close_fp(test, y.lower, -0.24403226295847108, 1e-14, "tan(fl(pi/2)) (lower)");
+
+    // sin(x)**2 + cos(x)**2 = 1
+    for (double x : {0.1, 0.7853981633974483, 2.0, -5.5, 1000.25}) {
+        DoubleDouble s, c;
+        DoubleDouble(x, x*1e-17).sincos(s, c);
+        std::stringstream name;
+        name << "sin(x)**2 + cos(x)**2 for x = " << x;
+        assert_true(test, (s*s + c*c - 1.0).abs() < 1e-31, name.str());
+    }
+
+    // The accuracy of huge arguments decreases with |x| (see
+    // trig_reduce()), but the results are still sines and cosines of
+    // something.
+    for (double x : {0x1p60, -1e22, 1e300, -1.7976931348623157e308}) {
+        DoubleDouble s, c;
+        DoubleDouble(x).sincos(s, c);
+        std::stringstream name;
+        name << "sin, cos and tan for x = " << x;
+        assert_true(test, (s*s + c*c - 1.0).abs() < 1e-30
+                          && DoubleDouble(x).sin() == s && DoubleDouble(x).cos() == c
+                          && std::isfinite(DoubleDouble(x).tan().upper), name.str());
+    }
+
+    assert_isnan(test, DoubleDouble(NAN).sin());
+    assert_isnan(test, DoubleDouble(INFINITY).cos());
+    assert_isnan(test, DoubleDouble(-INFINITY).tan());
+}
+
+struct func_case {
+    double x, hi, lo;
+};
+
+void check_func_cases(CheckIt& test, const char *fname,
+                      DoubleDouble (DoubleDouble::*f)() const,
+                      const std::vector<func_case>& samples)
+{
+    for (const auto& sample : samples) {
+        DoubleDouble y = (DoubleDouble(sample.x).*f)();
+        std::stringstream name;
+        name << fname << "(" << sample.x << ")";
+        assert_equal_fp(test, y.upper, sample.hi, name.str() + " (upper)");
+        assert_dd_close(test, y, sample.hi, sample.lo, name.str());
+    }
+}
+
+void test_inverse_trig(CheckIt& test)
+{
+    // Reference values were computed with 120 digit decimal arithmetic.
+    check_func_cases(test, "atan", &DoubleDouble::atan, {
+        {0.5, 0.4636476090008061, 2.2698777452961687e-17},
+        {-0.75, -0.6435011087932844, -1.5834785051444286e-17},
+        {1e-20, 1e-20, -3.333333333333333e-61},
+        {3.0, 1.2490457723982544, -2.196203799612311e-18},
+        {1e300, 1.5707963267948966, 6.123233995736766e-17},
+        {0.0078125, 0.007812341060101111, 1.5247608492487475e-19},
+    });
+    check_func_cases(test, "asin", &DoubleDouble::asin, {
+        {0.5, 0.5235987755982989, -5.360408832255455e-17},
+        {-0.999, -1.526071239626163, -7.84631528833658e-17},
+        {1e-20, 1e-20, 1.6666666666666664e-61},
+        {0.25, 0.25268025514207865, 6.584019697419058e-18},
+    });
+    check_func_cases(test, "acos", &DoubleDouble::acos, {
+        {0.5, 1.0471975511965979, -1.072081766451091e-16},
+        {-0.999, 3.09686756642106, -8.234911208429785e-17},
+        {1e-20, 1.5707963267948966, 6.122233995736766e-17},
+        {0.25, 1.318116071652818, -8.628309713092261e-19},
+    });
+
+    struct {
+        double y, x, hi, lo;
+    } atan2_samples[] = {
+        {1.0, 3.0, 0.3217505543966422, 7.917392525722143e-18},
+        {-2.0, -0.5, -1.8157749899217608, 1.133563127078463e-17},
+        {1e-300, -1.0, 3.141592653589793, 1.2246467991473532e-16},
+        {5.0, 1e-10, 1.5707963267748966, 6.288714737662083e-17},
+        {1e308, 1.5e308, 0.5880026035475675, 4.732902892613666e-17},
+    };
+    for (const auto& sample : atan2_samples) {
+        DoubleDouble y = atan2(DoubleDouble(sample.y), DoubleDouble(sample.x));
+        std::stringstream name;
+        name << "atan2(" << sample.y << ", " << sample.x << ")";
+        assert_equal_fp(test, y.upper, sample.hi, name.str() + " (upper)");
+        assert_dd_close(test, y, sample.hi, sample.lo, name.str());
+    }
+
+    // atan2() agrees with atan() in the right half plane.
+    for (double x : {0.1, 0.9, 1.0, 1.1, 40.0}) {
+        DoubleDouble t = DoubleDouble(x) / 7.0;
+        std::stringstream name;
+        name << "atan2(" << x << "/7, 1) == atan(" << x << "/7)";
+        assert_true(test, (atan2(t, dd_one) - t.atan()).abs() < 1e-32, name.str());
+    }
+
+    DoubleDouble y = atan2(DoubleDouble(0.0), DoubleDouble(-1.0));
+    assert_true(test, y == dd_pi, "atan2(0, -1)");
+    y = atan2(DoubleDouble(-0.0), DoubleDouble(2.0));
+    assert_true(test, y.upper == 0 && std::signbit(y.upper), "atan2(-0, 2)");
+    y = atan2(DoubleDouble(-1.0), DoubleDouble(0.0));
+    assert_true(test, y == -dd_pi_2, "atan2(-1, 0)");
+    y = atan2(DoubleDouble(INFINITY), DoubleDouble(-INFINITY));
+    assert_true(test, y == dd_pi - dd_pi_2*0.5, "atan2(inf, -inf)");
+    y = DoubleDouble(-INFINITY).atan();
+    assert_true(test, y == -dd_pi_2, "atan(-inf)");
+    y = DoubleDouble(1.0).asin();
+    assert_true(test, y == dd_pi_2, "asin(1)");
+    y = DoubleDouble(-1.0).acos();
+    assert_true(test, y == dd_pi, "acos(-1)");
+    assert_isnan(test, atan2(DoubleDouble(NAN), DoubleDouble(1.0)));
+    assert_isnan(test, DoubleDouble(NAN).atan());
+    assert_isnan(test, DoubleDouble(1.5).asin());
+    assert_isnan(test, DoubleDouble(1.0, 1e-20).acos());
+}
+
+void test_hyperbolic(CheckIt& test)
+{
+    // Reference values were computed with 120 digit decimal arithmetic.
+    check_func_cases(test, "sinh", &DoubleDouble::sinh, {
+        {0.125, 0.12532577524111546, -4.318309886229614e-18},
+        {-0.4, -0.4107523258028155, -2.2564035584726803e-17},
+        {2.5, 6.0502044810397875, -1.5266669624477375e-16},
+        {-20.0, -242582597.70489514, 7.865629467297586e-10},
+        {1e-20, 1e-20, 1.6666666666666664e-61},
+        {710.0, 1.1169973830808555e+308, 5.772538034401481e+291},
+    });
+    check_func_cases(test, "cosh", &DoubleDouble::cosh, {
+        {0.125, 1.0078226778257109, -2.880800343795733e-17},
+        {-0.4, 1.0810723718384547, 9.190483192482217e-17},
+        {2.5, 6.132289479663686, 3.560067179782552e-16},
+        {-20.0, 242582597.70489514, 1.2745906757087991e-09},
+        {1e-20, 1.0, 5e-41},
+        {710.0, 1.1169973830808555e+308, 5.772538034401481e+291},
+    });
+    check_func_cases(test, "tanh", &DoubleDouble::tanh, {
+        {0.125, 0.12435300177159621, -2.1451880813141441e-19},
+        {-0.4, -0.3799489622552249, -6.3008573143723185e-18},
+        {2.5, 0.9866142981514303, -2.4529238788172874e-17},
+        {-20.0, -1.0, 8.496708510583178e-18},
+        {1e-20, 1e-20, -3.333333333333333e-61},
+    });
+    check_func_cases(test, "atanh", &DoubleDouble::atanh, {
+        {0.5, 0.5493061443340549, -4.535648617500765e-17},
+        {-0.9, -1.4722194895832204, 6.2981627878629994e-18},
+        {1e-20, 1e-20, 3.333333333333333e-61},
+        {0.999999, 7.254328619247669, 1.153045648593053e-16},
+    });
+
+    DoubleDouble y = DoubleDouble(710.0).tanh();
+    assert_true(test, y == 1.0, "tanh(710)");
+    y = DoubleDouble(-711.0).sinh();
+    assert_true(test, y.upper == -INFINITY, "sinh(-711)");
+    y = DoubleDouble(INFINITY).cosh();
+    assert_true(test, y.upper == INFINITY, "cosh(inf)");
+    y = DoubleDouble(-1.0).atanh();
+    assert_true(test, y.upper == -INFINITY, "atanh(-1)");
+    y = DoubleDouble(1.0, -1e-20).atanh();
+    assert_true(test, y.upper > 20 && y.upper < INFINITY, "atanh(1 - 1e-20)");
+    assert_isnan(test, DoubleDouble(NAN).sinh());
+    assert_isnan(test, DoubleDouble(NAN).cosh());
+    assert_isnan(test, DoubleDouble(NAN).tanh());
+    assert_isnan(test, DoubleDouble(1.5).atanh());
+}
+
 void test_hypot(CheckIt& test)
 {
     DoubleDouble x, y, h;
@@ -570,6 +1123,91 @@ void test_dsum(CheckIt& test)
     std::array<double, 7> data4{1.0, 2.0, 2e-17, -2.0, 10.0, -1.0, -10.0};
     double s4 = dsum(data4);
     assert_equal_fp(test, s4, 2e-17, "Test of dsum(vector)");
+
+    // Long enough to use all the lanes, with a remainder.  The large
+    // terms cancel exactly, and the sum of the rest is 1003*(1 + 2**-60).
+    std::vector<double> data5;
+    for (int i = 0; i < 1003; ++i) {
+        data5.push_back(std::ldexp(1.0, 40)*(i % 7 - 3));
+        data5.push_back(1.0);
+        data5.push_back(-std::ldexp(1.0, 40)*(i % 7 - 3));
+        data5.push_back(std::ldexp(1.0, -60));
+    }
+    DoubleDouble s5 = dsum_dd(data5.size(), &data5[0]);
+    assert_equal_fp(test, s5.upper, 1003.0, "Test of dsum_dd() (upper)");
+    assert_equal_fp(test, s5.lower, 1003*std::ldexp(1.0, -60), "Test of dsum_dd() (lower)");
+
+    std::vector<double> data6(100, 1.0);
+    data6[37] = NAN;
+    assert_true(test, std::isnan(dsum(data6)), "dsum() with a NAN is NAN");
+
+    // DoubleDouble elements: the lower parts are summed, too.
+    std::vector<DoubleDouble> data7;
+    for (int i = 0; i < 1003; ++i) {
+        data7.push_back(DoubleDouble(std::ldexp(1.0, 40)*(i % 7 - 3), 1.0));
+        data7.push_back(DoubleDouble(-std::ldexp(1.0, 40)*(i % 7 - 3),
+                                     std::ldexp(1.0, -60)));
+    }
+    DoubleDouble s7 = dsum_dd(data7.size(), &data7[0]);
+    assert_equal_fp(test, s7.upper, 1003.0, "Test of dsum_dd(DoubleDouble) (upper)");
+    assert_equal_fp(test, s7.lower, 1003*std::ldexp(1.0, -60),
+                    "Test of dsum_dd(DoubleDouble) (lower)");
+}
+
+void test_ddot(CheckIt& test)
+{
+    // (1e10 + 1)*(1e10 - 1) - 1e10*(1e10 + 1) + 1e-5*1 = -1e10 - 1 + 1e-5
+    // The products need more than 53 bits, and the sum cancels.
+    double x1[]{1e10 + 1, -1e10, 1e-5};
+    double y1[]{1e10 - 1, 1e10 + 1, 1.0};
+    DoubleDouble expected = two_sum(-1e10 - 1, 1e-5);
+    DoubleDouble d1 = ddot_dd(3, x1, y1);
+    assert_equal_fp(test, d1.upper, expected.upper, "ddot_dd() (upper)");
+    assert_equal_fp(test, d1.lower, expected.lower, "ddot_dd() (lower)");
+    assert_equal_fp(test, ddot(3, x1, y1), expected.upper, "ddot()");
+
+    // The same terms repeated 67 times, so all the lanes are used.  The
+    // partial sums are now as large as 1e20, so the error of the result
+    // is bounded by a small multiple of DoubleDouble epsilon (about
+    // 2.5e-32) times sum(|x[i]*y[i]|), not by the size of the result.
+    std::vector<double> x2, y2;
+    for (int k = 0; k < 67; ++k) {
+        x2.insert(x2.end(), x1, x1 + 3);
+        y2.insert(y2.end(), y1, y1 + 3);
+    }
+    DoubleDouble d2 = ddot_dd(x2.size(), x2.data(), y2.data());
+    double abs_sum = 67*(2e20 + 1e10);
+    assert_equal_fp(test, d2.upper, (67*expected).upper, "ddot_dd(), long arrays (upper)");
+    assert_true(test, (d2 - 67*expected).abs() < 1e-30*abs_sum, "ddot_dd(), long arrays (error)");
+    assert_equal_fp(test, ddot(x2, y2), (67*expected).upper, "ddot(vector, vector)");
+
+    // Strided: use every third element of x2 (1e10 + 1) and y2 (1e10 - 1).
+    DoubleDouble d3 = ddot_dd(67, x2.data(), 3, y2.data(), 3);
+    DoubleDouble p3 = 67*two_product(1e10 + 1, 1e10 - 1);
+    assert_equal_fp(test, d3.upper, p3.upper, "ddot_dd(), strided (upper)");
+    assert_equal_fp(test, d3.lower, p3.lower, "ddot_dd(), strided (lower)");
+    assert_equal_fp(test, ddot(67, x2.data(), 3, y2.data(), 3), p3.upper, "ddot(), strided");
+
+    // Mixed DoubleDouble and double operands.
+    DoubleDouble x4[]{DoubleDouble(1.0)/3, dd_pi, -dd_pi};
+    double y4[]{3.0, 2.0, 2.0};
+    DoubleDouble d4 = ddot_dd(3, x4, y4);
+    DoubleDouble e4 = x4[0]*3.0;
+    // The partial sums include 2*pi, so the result is only accurate to
+    // about 2**-106 * 2*pi.
+    assert_equal_fp(test, d4.upper, e4.upper, "ddot_dd(DoubleDouble, double) (upper)");
+    assert_true(test, (d4 - e4).abs() < 1e-31, "ddot_dd(DoubleDouble, double) (lower)");
+    DoubleDouble d5 = ddot_dd(3, y4, x4);
+    assert_true(test, d5 == d4, "ddot_dd(double, DoubleDouble)");
+
+    DoubleDouble y6[]{DoubleDouble(3.0), dd_e, dd_e};
+    DoubleDouble d6 = ddot_dd(3, x4, y6);
+    DoubleDouble e6 = x4[0]*y6[0];
+    assert_equal_fp(test, d6.upper, e6.upper, "ddot_dd(DoubleDouble, DoubleDouble) (upper)");
+    assert_close_fp(test, d6.lower, e6.lower, 5e-16, "ddot_dd(DoubleDouble, DoubleDouble) (lower)");
+
+    double x7[]{1.0, NAN};
+    assert_true(test, std::isnan(ddot(2, x7, x7)), "ddot() with a NAN is NAN");
 }
 
 
@@ -586,17 +1224,28 @@ int main(int argc, char *argv[])
     test_inplace_multiply(test);
     test_divide(test);
     test_inplace_divide(test);
+    test_fused(test);
+    test_product_error(test);
+    test_constexpr(test);
     test_expressions(test);
     test_comparisons(test);
     test_abs(test);
     test_powi(test);
+    test_powi_chain(test);
+    test_powers_table(test);
+    test_polyval(test);
     test_sqrt(test);
     test_log(test);
     test_log1p(test);
     test_exp(test);
     test_expm1(test);
+    test_tiers(test);
+    test_trig(test);
+    test_inverse_trig(test);
+    test_hyperbolic(test);
     test_hypot(test);
     test_dsum(test);
+    test_ddot(test);
 
     return test.print_summary("Summary: ");
 }
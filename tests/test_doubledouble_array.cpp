@@ -0,0 +1,140 @@
+
+#include <sstream>
+#include <cstdio>
+#include <vector>
+#include <cmath>
+#include <random>
+#include "checkit.h"
+#include "doubledouble_array.h"
+
+using namespace doubledouble;
+
+
+static bool same(const DoubleDouble& x, const DoubleDouble& y)
+{
+    if (std::isnan(x.upper) && std::isnan(y.upper)) {
+        return std::isnan(x.lower) && std::isnan(y.lower);
+    }
+    return x.upper == y.upper && x.lower == y.lower;
+}
+
+//
+// Random DoubleDouble values over a range of magnitudes, with a few
+// special values mixed in.
+//
+static DoubleDoubleArray sample_array(std::size_t n, unsigned seed)
+{
+    std::mt19937_64 gen(seed);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::uniform_int_distribution<int> e(-40, 40);
+    DoubleDoubleArray a(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        double hi = std::ldexp(u(gen), e(gen));
+        a.set(i, DoubleDouble(hi, hi*1e-17*u(gen)));
+    }
+    a.set(0, DoubleDouble(NAN));
+    a.set(1, dd_inf);
+    a.set(2, dd_zero);
+    a.set(3, DoubleDouble(1e300));
+    return a;
+}
+
+void test_array_container(CheckIt& test)
+{
+    DoubleDoubleArray a(5);
+    assert_equal_integer(test, a.size(), std::size_t(5), "size()");
+    assert_true(test, a[3] == 0.0, "elements are initialized to 0");
+    assert_equal_integer(test, reinterpret_cast<std::uintptr_t>(a.upper()) % DD_ARRAY_ALIGNMENT,
+                         std::uintptr_t(0), "upper() is aligned");
+    assert_equal_integer(test, reinterpret_cast<std::uintptr_t>(a.lower()) % DD_ARRAY_ALIGNMENT,
+                         std::uintptr_t(0), "lower() is aligned");
+
+    a.set(2, DoubleDouble(10.0, 3e-18));
+    DoubleDoubleArray b = a;
+    a.set(2, dd_one);
+    assert_equal_fp(test, b[2].upper, 10.0, "copy (upper)");
+    assert_equal_fp(test, b[2].lower, 3e-18, "copy (lower)");
+
+    DoubleDoubleArray c = std::move(b);
+    assert_equal_integer(test, c.size(), std::size_t(5), "move (size)");
+    assert_equal_integer(test, b.size(), std::size_t(0), "moved-from array is empty");
+    assert_equal_fp(test, c[2].upper, 10.0, "move (upper)");
+
+    std::vector<DoubleDouble> v{dd_pi, dd_e};
+    DoubleDoubleArray d(v);
+    assert_true(test, d[0] == dd_pi && d[1] == dd_e, "construct from vector");
+}
+
+template <typename Kernel, typename Op>
+void check_binary_kernel(CheckIt& test, const char *name, Kernel kernel, Op op)
+{
+    const std::size_t n = 1003;
+    DoubleDoubleArray x = sample_array(n, 1);
+    DoubleDoubleArray y = sample_array(n, 2);
+    DoubleDoubleArray z(n);
+    kernel(z, x, y);
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        mismatches += !same(z[i], op(x[i], y[i]));
+    }
+    std::stringstream s;
+    s << name << " matches the scalar operator";
+    assert_equal_integer(test, mismatches, std::size_t(0), s.str());
+}
+
+void test_array_kernels(CheckIt& test)
+{
+    check_binary_kernel(test, "dd_add", dd_add,
+                        [](auto x, auto y) { return x + y; });
+    check_binary_kernel(test, "dd_sub", dd_sub,
+                        [](auto x, auto y) { return x - y; });
+    check_binary_kernel(test, "dd_mul", dd_mul,
+                        [](auto x, auto y) { return x * y; });
+    check_binary_kernel(test, "dd_div", dd_div,
+                        [](auto x, auto y) { return x / y; });
+    check_binary_kernel(test, "dd_sqrt",
+                        [](dd_span z, dd_const_span x, dd_const_span) { dd_sqrt(z, x); },
+                        [](auto x, auto) { return x.sqrt(); });
+    check_binary_kernel(test, "dd_muladd",
+                        [](dd_span w, dd_const_span x, dd_const_span y) { dd_muladd(w, x, y, x); },
+                        [](auto x, auto y) { return x*y + x; });
+}
+
+void test_array_kernels_inplace(CheckIt& test)
+{
+    DoubleDoubleArray x(2);
+    x.set(0, DoubleDouble(1.0, 1e-18));
+    x.set(1, DoubleDouble(3.0));
+    dd_div(x, x, DoubleDoubleArray(std::vector<DoubleDouble>{dd_one, DoubleDouble(9.0)}));
+    assert_equal_fp(test, x[0].upper, 1.0, "inplace dd_div (upper)");
+    assert_equal_fp(test, x[0].lower, 1e-18, "inplace dd_div (lower)");
+    assert_equal_fp(test, x[1].upper, 0.3333333333333333, "inplace dd_div 3/9 (upper)");
+    assert_equal_fp(test, x[1].lower, 1.850371707708594e-17, "inplace dd_div 3/9 (lower)");
+}
+
+void test_array_dsum(CheckIt& test)
+{
+    DoubleDoubleArray x = sample_array(1000, 7);
+    x.set(0, DoubleDouble(0.25));
+    x.set(1, DoubleDouble(-1e300));
+    std::vector<DoubleDouble> v(x.size());
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        v[i] = x[i];
+    }
+    DoubleDouble s = dsum_dd(x);
+    DoubleDouble expected = dsum_dd(v.size(), &v[0]);
+    assert_true(test, same(s, expected), "dsum_dd(span) matches dsum_dd(DoubleDouble *)");
+    assert_equal_fp(test, dsum(x), expected.upper, "dsum(span)");
+}
+
+int main(int argc, char *argv[])
+{
+    auto test = CheckIt(std::cerr);
+
+    test_array_container(test);
+    test_array_kernels(test);
+    test_array_kernels_inplace(test);
+    test_array_dsum(test);
+
+    return test.print_summary("Summary: ");
+}
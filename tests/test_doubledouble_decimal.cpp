@@ -0,0 +1,269 @@
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <random>
+#include "checkit.h"
+#include "doubledouble_decimal.h"
+
+using namespace doubledouble;
+using namespace doubledouble::literals;
+
+
+static DoubleDouble parse(const char *s)
+{
+    DoubleDouble value{NAN};
+    const char *end = dd_parse(s, s + std::strlen(s), value);
+    if (end != s + std::strlen(s)) {
+        return DoubleDouble(NAN);
+    }
+    return value;
+}
+
+struct parse_case {
+    const char *s;
+    double upper;
+    double lower;
+};
+
+//
+// The expected values were computed with Python's decimal module:
+// upper = float(v), lower = float(v - Decimal(upper)).
+//
+void test_parse(CheckIt& test)
+{
+    const parse_case cases[] = {
+        {"0.1", 0.1, -5.551115123125783e-18},
+        {"0.2", 0.2, -1.1102230246251566e-17},
+        {"-0.2", -0.2, 1.1102230246251566e-17},
+        {"1e-300", 1e-300, -2.5059094e-317},
+        {"12345.678901234567890123456789", 12345.678901234567, 7.975082770714593e-13},
+        {"6.02214076e23", 6.02214076e+23, 12976128.0},
+        {"6.02214076E+23", 6.02214076e+23, 12976128.0},
+        {"+.5", 0.5, 0.0},
+        {"5.", 5.0, 0.0},
+        {"000123.4500", 123.45, -2.842170943040401e-15},
+        {"-1.5e-310", -1.5e-310, 0.0},
+        {"2.5e-320", 2.5e-320, 0.0},
+        {"1.7976931348623157e308", 1.7976931348623157e308, -8.145274237317043e+290},
+        {"2e-400", 0.0, 0.0},
+        // Halfway between 1 and the next double; rounds to even.
+        {"1.00000000000000011102230246251565404236316680908203125", 1.0, 1.1102230246251565e-16},
+        {"3.14159265358979323846264338327950288419716939937510",
+         dd_pi.upper, dd_pi.lower},
+        {"2.71828182845904523536028747135266249775724709369995",
+         dd_e.upper, dd_e.lower},
+        {"0.69314718055994530941723212145817656807550013436026",
+         dd_ln2.upper, dd_ln2.lower},
+        {"1.41421356237309504880168872420969807856967187537694",
+         dd_sqrt2.upper, dd_sqrt2.lower},
+    };
+    for (const auto& c : cases) {
+        DoubleDouble y = parse(c.s);
+        std::string name = std::string("dd_parse(\"") + c.s + "\")";
+        assert_equal_fp(test, y.upper, c.upper, name + " (upper)");
+        assert_equal_fp(test, y.lower, c.lower, name + " (lower)");
+    }
+
+    // More digits than dd_parse_max_digits.
+    std::string s = "0." + std::string(1000, '3');
+    DoubleDouble y = parse(s.c_str());
+    assert_true(test, y == DoubleDouble(1.0)/3, "0.333... (1000 digits)");
+    s = "1" + std::string(900, '0') + "e-900";
+    y = parse(s.c_str());
+    assert_true(test, y == 1.0, "1000...0e-900 (901 digits)");
+
+    y = parse("-0");
+    assert_true(test, y == 0.0 && std::signbit(y.upper), "-0");
+    y = parse("1e400");
+    assert_true(test, y.upper == INFINITY && y.lower == 0.0, "1e400");
+    y = parse("-Infinity");
+    assert_true(test, y.upper == -INFINITY && y.lower == 0.0, "-Infinity");
+    y = parse("inf");
+    assert_true(test, y.upper == INFINITY && y.lower == 0.0, "inf");
+    y = parse("NaN");
+    assert_true(test, std::isnan(y.upper) && std::isnan(y.lower), "NaN");
+}
+
+void test_parse_end(CheckIt& test)
+{
+    const char *s = "1.25e+2x";
+    DoubleDouble y;
+    const char *end = dd_parse(s, s + std::strlen(s), y);
+    assert_true(test, end == s + 7 && y == 125.0, "\"1.25e+2x\" stops at x");
+
+    // An exponent without digits is not part of the number.
+    s = "2e+";
+    end = dd_parse(s, s + std::strlen(s), y);
+    assert_true(test, end == s + 1 && y == 2.0, "\"2e+\" stops at e");
+
+    // Only the given range is read.
+    s = "3.75";
+    end = dd_parse(s, s + 3, y);
+    assert_true(test, end == s + 3 && y.upper == 3.7, "\"3.7\" in \"3.75\"");
+
+    const char *invalid[] = {"", "-", ".", "e5", "x1", "+-1", "in"};
+    for (const char *t : invalid) {
+        y = DoubleDouble(7.0);
+        end = dd_parse(t, t + std::strlen(t), y);
+        std::string name = std::string("dd_parse(\"") + t + "\") fails";
+        assert_true(test, end == t && y == 7.0, name);
+    }
+}
+
+void test_literals(CheckIt& test)
+{
+    constexpr DoubleDouble tenth = 0.1_dd;
+    static_assert(tenth.upper == 0.1 && tenth.lower == -5.551115123125783e-18,
+                  "0.1_dd");
+    constexpr DoubleDouble pi = "3.14159265358979323846264338327950288"_dd;
+    static_assert(pi == dd_pi, "pi");
+    constexpr DoubleDouble million = 1'000'000_dd;
+    static_assert(million == 1e6, "1'000'000_dd");
+    constexpr DoubleDouble x = 12345.678901234567890123456789e-3_dd;
+    static_assert(x.upper == 12.345678901234567 && x.lower == 5.417128921978232e-16,
+                  "12345.678901234567890123456789e-3_dd");
+
+    assert_true(test, tenth == parse("0.1"), "0.1_dd");
+    assert_true(test, "-2.5e-3"_dd == parse("-2.5e-3"), "\"-2.5e-3\"_dd");
+    DoubleDouble y = dd_parse_literal("1.5x", 4);
+    assert_true(test, std::isnan(y.upper), "invalid literal at run time");
+}
+
+static std::string shortest(const DoubleDouble& x)
+{
+    char buf[1000];
+    auto r = to_chars(buf, buf + sizeof(buf), x);
+    return std::string(buf, r.ptr);
+}
+
+static std::string with_precision(const DoubleDouble& x, int precision)
+{
+    char buf[1000];
+    auto r = to_chars(buf, buf + sizeof(buf), x, precision);
+    return std::string(buf, r.ptr);
+}
+
+//
+// The expected values were checked with Python's decimal module.
+//
+void test_to_chars(CheckIt& test)
+{
+    const struct {
+        DoubleDouble x;
+        const char *s;
+    } cases[] = {
+        {dd_pi, "3.1415926535897932384626433832795"},
+        {0.1_dd, "0.1"},
+        // The lower part is 0, so all the digits of 0.1 are needed.
+        {DoubleDouble(0.1), "0.1000000000000000055511151231257827021181583404541015625"},
+        {DoubleDouble(1.0)/3, "0.333333333333333333333333333333332"},
+        {DoubleDouble(-0.5), "-0.5"},
+        {DoubleDouble(123456.0), "123456"},
+        {DoubleDouble(1e22), "1e+22"},
+        {DoubleDouble(2.0).powi(70), "1180591620717411303424"},
+        {dd_ln2*1e20, "69314718055994530941.7232121458178"},
+        {DoubleDouble(5e-324), "5e-324"},
+        {DoubleDouble(0.0), "0"},
+        {DoubleDouble(-0.0), "-0"},
+        {dd_inf, "inf"},
+        {-dd_inf, "-inf"},
+        {DoubleDouble(NAN), "nan"},
+    };
+    for (const auto& c : cases) {
+        std::string s = shortest(c.x);
+        assert_true(test, s == c.s, std::string("to_chars: ") + s + " == " + c.s);
+    }
+
+    const struct {
+        DoubleDouble x;
+        int precision;
+        const char *s;
+    } precision_cases[] = {
+        {dd_pi, 32, "3.1415926535897932384626433832795e+00"},
+        {DoubleDouble(0.1), 32, "1.0000000000000000555111512312578e-01"},
+        {-dd_e*1e-5, 32, "-2.7182818284590454577240424383195e-05"},
+        {DoubleDouble(5e-324), 32, "4.9406564584124654417656879286822e-324"},
+        {DoubleDouble(0.96), 1, "1e+00"},
+        {DoubleDouble(0.25), 1, "2e-01"},
+        {DoubleDouble(123456.0), 3, "1.23e+05"},
+    };
+    for (const auto& c : precision_cases) {
+        std::string s = with_precision(c.x, c.precision);
+        assert_true(test, s == c.s, std::string("to_chars: ") + s + " == " + c.s);
+    }
+
+    char buf[8];
+    auto r = to_chars(buf, buf + sizeof(buf), dd_pi);
+    assert_true(test, r.ec == std::errc::value_too_large && r.ptr == buf + sizeof(buf),
+                "to_chars: value_too_large");
+    r = to_chars(buf, buf + 2, dd_inf);
+    assert_true(test, r.ec == std::errc::value_too_large, "to_chars: inf, value_too_large");
+}
+
+//
+// The output of to_chars() is converted back to the same value.
+//
+void test_round_trip(CheckIt& test)
+{
+    std::mt19937_64 gen(42);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::uniform_int_distribution<int> exponent(-1000, 1000);
+    int failures = 0;
+    for (int i = 0; i < 2000; ++i) {
+        double hi = std::ldexp(u(gen), exponent(gen));
+        double lo = hi*1e-16*u(gen);
+        if (i % 4 == 0) {
+            lo = 0.0;
+        }
+        DoubleDouble x = two_sum(hi, lo);
+        char buf[1000];
+        auto r = to_chars(buf, buf + sizeof(buf), x);
+        DoubleDouble y{NAN};
+        auto q = from_chars(buf, r.ptr, y);
+        if (q.ec != std::errc{} || q.ptr != r.ptr || y.upper != x.upper
+                || y.lower != x.lower) {
+            ++failures;
+        }
+    }
+    assert_equal_integer(test, failures, 0, "to_chars/from_chars round trip");
+}
+
+void test_from_chars(CheckIt& test)
+{
+    const char *s = "0.1x";
+    DoubleDouble y;
+    auto r = from_chars(s, s + 4, y);
+    assert_true(test, r.ec == std::errc{} && r.ptr == s + 3 && y == 0.1_dd,
+                "from_chars(\"0.1x\")");
+
+    s = "x";
+    y = DoubleDouble(7.0);
+    r = from_chars(s, s + 1, y);
+    assert_true(test, r.ec == std::errc::invalid_argument && r.ptr == s && y == 7.0,
+                "from_chars(\"x\")");
+
+    s = "-1e400";
+    r = from_chars(s, s + 6, y);
+    assert_true(test, r.ec == std::errc::result_out_of_range && r.ptr == s + 6 && y == 7.0,
+                "from_chars(\"-1e400\")");
+
+    s = "-inf";
+    r = from_chars(s, s + 4, y);
+    assert_true(test, r.ec == std::errc{} && y.upper == -INFINITY, "from_chars(\"-inf\")");
+}
+
+int main(int argc, char *argv[])
+{
+    auto test = CheckIt(std::cerr);
+
+    test_parse(test);
+    test_parse_end(test);
+    test_literals(test);
+    test_to_chars(test);
+    test_round_trip(test);
+    test_from_chars(test);
+
+    return test.print_summary("Summary: ");
+}
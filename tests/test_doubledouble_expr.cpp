@@ -0,0 +1,200 @@
+
+#include <sstream>
+#include <cstdio>
+#include <vector>
+#include <cmath>
+#include <random>
+#include "checkit.h"
+#include "doubledouble_expr.h"
+
+using namespace doubledouble;
+
+
+static bool same(const DoubleDouble& x, const DoubleDouble& y)
+{
+    if (std::isnan(x.upper) && std::isnan(y.upper)) {
+        return std::isnan(x.lower) && std::isnan(y.lower);
+    }
+    return x.upper == y.upper && x.lower == y.lower;
+}
+
+//
+// Random DoubleDouble values with magnitudes in [lo, hi).
+//
+static std::vector<DoubleDouble> sample(std::size_t n, unsigned seed,
+                                        double lo, double hi)
+{
+    std::mt19937_64 gen(seed);
+    std::uniform_real_distribution<double> u(lo, hi);
+    std::uniform_real_distribution<double> v(-1.0, 1.0);
+    std::vector<DoubleDouble> x(n);
+    for (auto& xi : x) {
+        double h = u(gen);
+        xi = DoubleDouble(h, h*1e-17*v(gen));
+    }
+    return x;
+}
+
+//
+// With a single operation, there is nothing to fuse; the result must be
+// the same as that of the operator.
+//
+void test_single_operations(CheckIt& test)
+{
+    const std::size_t n = 500;
+    auto x = sample(n, 1, -4.0, 4.0);
+    auto y = sample(n, 2, 0.25, 4.0);
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        const DoubleDouble& a = x[i];
+        const DoubleDouble& b = y[i];
+        mismatches += !same(dd_lazy(a) + b, a + b);
+        mismatches += !same(dd_lazy(a) - b, a - b);
+        mismatches += !same(dd_lazy(a) * b, a * b);
+        mismatches += !same(dd_lazy(a) / b, a / b);
+        mismatches += !same(dd_lazy(a) + 2.5, a + 2.5);
+        mismatches += !same(2.5 - dd_lazy(a), 2.5 - a);
+        mismatches += !same(dd_lazy(a) * 3.0, a * 3.0);
+        mismatches += !same(dd_lazy(a) / 3.0, a / 3.0);
+        mismatches += !same(3.0 / dd_lazy(b), 3.0 / b);
+        mismatches += !same(-dd_lazy(a) + b, -a + b);
+    }
+    assert_equal_integer(test, mismatches, std::size_t(0),
+                         "single operations match the operators");
+
+    DoubleDouble z = dd_lazy(DoubleDouble(NAN))*2.0 + dd_one;
+    assert_true(test, std::isnan(z.upper) && std::isnan(z.lower), "NAN*2 + 1");
+    z = dd_one/dd_lazy(dd_zero) - dd_inf;
+    assert_true(test, std::isnan(z.upper) && std::isnan(z.lower), "1/0 - inf");
+}
+
+//
+// Fused expressions agree with the operators to within a few units of
+// 2**-106.  The operands are chosen so that there is no cancellation, so
+// the bound can be relative to the result.
+//
+template <typename Lazy, typename Eager>
+void check_expression(CheckIt& test, const char *name, Lazy lazy, Eager eager)
+{
+    const std::size_t n = 500;
+    auto a = sample(n, 3, 0.5, 2.0);
+    auto b = sample(n, 4, 0.5, 2.0);
+    auto c = sample(n, 5, 0.5, 2.0);
+    auto d = sample(n, 6, 3.0, 5.0);
+    double maxerr = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        DoubleDouble y = lazy(a[i], b[i], c[i], d[i]);
+        DoubleDouble z = eager(a[i], b[i], c[i], d[i]);
+        double err = ((y - z)/z).abs().upper;
+        maxerr = std::fmax(maxerr, err);
+    }
+    std::stringstream s;
+    s << name << ": max relative difference " << maxerr;
+    // 8 units of 2**-106.
+    assert_true(test, maxerr <= 9.860761315262648e-32, s.str());
+}
+
+void test_fused_expressions(CheckIt& test)
+{
+    check_expression(test, "a*b + c*d",
+        [](const auto& a, const auto& b, const auto& c, const auto& d) -> DoubleDouble {
+            return dd_lazy(a)*b + dd_lazy(c)*d;
+        },
+        [](const auto& a, const auto& b, const auto& c, const auto& d) {
+            return a*b + c*d;
+        });
+    check_expression(test, "(a + b)*(d - c)",
+        [](const auto& a, const auto& b, const auto& c, const auto& d) -> DoubleDouble {
+            return (dd_lazy(a) + b)*(dd_lazy(d) - c);
+        },
+        [](const auto& a, const auto& b, const auto& c, const auto& d) {
+            return (a + b)*(d - c);
+        });
+    check_expression(test, "a*b*c/d",
+        [](const auto& a, const auto& b, const auto& c, const auto& d) -> DoubleDouble {
+            return dd_lazy(a)*b*c/d;
+        },
+        [](const auto& a, const auto& b, const auto& c, const auto& d) {
+            return a*b*c/d;
+        });
+    check_expression(test, "a/d + b/d + c/d",
+        [](const auto& a, const auto& b, const auto& c, const auto& d) -> DoubleDouble {
+            return dd_lazy(a)/d + dd_lazy(b)/d + dd_lazy(c)/d;
+        },
+        [](const auto& a, const auto& b, const auto& c, const auto& d) {
+            return a/d + b/d + c/d;
+        });
+    check_expression(test, "((d*a + b)*a + c)*a + 1",
+        [](const auto& a, const auto& b, const auto& c, const auto& d) -> DoubleDouble {
+            return ((dd_lazy(d)*a + b)*a + c)*a + 1;
+        },
+        [](const auto& a, const auto& b, const auto& c, const auto& d) {
+            return ((d*a + b)*a + c)*a + 1;
+        });
+    check_expression(test, "pi*a**2*b/3",
+        [](const auto& a, const auto& b, const auto&, const auto&) -> DoubleDouble {
+            return dd_lazy(dd_pi)*a.powi(2)*b/3;
+        },
+        [](const auto& a, const auto& b, const auto&, const auto&) {
+            return dd_pi*a.powi(2)*b/3;
+        });
+}
+
+void test_cancellation(CheckIt& test)
+{
+    // The difference is renormalized before it is multiplied.
+    DoubleDouble a{1.0, 1e-20};
+    DoubleDouble b{1.0};
+    DoubleDouble c{3.0, 1e-17};
+    DoubleDouble y = (dd_lazy(a) - b)*c;
+    assert_true(test, same(y, (a - b)*c), "(a - b)*c with cancellation");
+
+    // The unnormalized product cancels exactly against the same product
+    // computed by the operator.
+    DoubleDouble x = DoubleDouble(1.0)/3;
+    y = dd_lazy(x)*x - x*x;
+    assert_true(test, same(y, dd_zero), "x*x - x*x");
+}
+
+void test_shared_divisor(CheckIt& test)
+{
+    DoubleDouble x{2.0, 1e-17};
+    DoubleDouble y{5.0, -2e-17};
+    DoubleDouble d{3.0, 1e-18};
+    auto e = dd_lazy(x)/d - dd_lazy(y)/d;
+    static_assert(decltype(e)::n_divisors == 2, "two divisions by a variable");
+    DoubleDouble r = e;
+    DoubleDouble ref = x/d - y/d;
+    assert_true(test, ((r - ref)/ref).abs() < 5e-32, "x/d - y/d");
+
+    // The expression refers to the variables, not to copies of them.
+    d = DoubleDouble(-1.0);
+    r = e;
+    assert_true(test, same(r, y - x), "x/d - y/d after d = -1");
+
+    // The reciprocal of a subnormal divisor overflows; the divisions must
+    // then be done as divisions.
+    DoubleDouble a{1e-300}, b{2e-300}, t{1e-310};
+    r = dd_lazy(a)/t + dd_lazy(b)/t;
+    ref = a/t + b/t;
+    assert_true(test, std::isfinite(ref.upper)
+                      && ((r - ref)/ref).abs() < 5e-32,
+                "a/t + b/t, t subnormal");
+    // The reciprocal of a huge divisor would have a subnormal lower part.
+    t = DoubleDouble(0x1.8p1000, 0x1p947);
+    r = dd_lazy(x)/t + dd_lazy(y)/t;
+    ref = x/t + y/t;
+    assert_true(test, ((r - ref)/ref).abs() < 5e-32, "x/t + y/t, t huge");
+}
+
+int main(int argc, char *argv[])
+{
+    auto test = CheckIt(std::cerr);
+
+    test_single_operations(test);
+    test_fused_expressions(test);
+    test_cancellation(test);
+    test_shared_divisor(test);
+
+    return test.print_summary("Summary: ");
+}
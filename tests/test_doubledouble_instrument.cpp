@@ -0,0 +1,127 @@
+
+// This test is compiled with -DDOUBLEDOUBLE_INSTRUMENT.
+
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <thread>
+#include "checkit.h"
+#include "doubledouble.h"
+#include "doubledouble_array.h"
+
+using namespace doubledouble;
+
+
+static std::uint64_t count(dd_counter c)
+{
+    return dd_counters_thread()[c];
+}
+
+void test_operator_counts(CheckIt& test)
+{
+    dd_counters_reset();
+    DoubleDouble a{1.5, 1e-17};
+    DoubleDouble b{0.25, -3e-18};
+    DoubleDouble c = a*b + a;
+    c -= 2.0;
+    c /= b;
+    assert_equal_integer(test, count(dd_counter::mul), std::uint64_t(1), "mul");
+    assert_equal_integer(test, count(dd_counter::add), std::uint64_t(1), "add");
+    assert_equal_integer(test, count(dd_counter::sub_double), std::uint64_t(1), "sub_double");
+    assert_equal_integer(test, count(dd_counter::div), std::uint64_t(1), "div");
+    assert_equal_integer(test, count(dd_counter::sub), std::uint64_t(0), "sub");
+
+    // x**8: three squarings and one multiplication.
+    dd_counters_reset();
+    c = a.powi(8);
+    assert_equal_integer(test, count(dd_counter::powi), std::uint64_t(1), "powi");
+    assert_equal_integer(test, count(dd_counter::powi_squarings), std::uint64_t(3),
+                         "powi_squarings");
+    assert_equal_integer(test, count(dd_counter::sqr), std::uint64_t(3), "sqr in powi");
+    assert_equal_integer(test, count(dd_counter::mul), std::uint64_t(1), "mul in powi");
+
+    DoubleDoubleArray x(10), y(10);
+    dd_counters_reset();
+    dd_add(x, x, y);
+    assert_equal_integer(test, count(dd_counter::add), std::uint64_t(10), "dd_add kernel");
+
+    // Constant evaluation is not counted (and still works).
+    constexpr DoubleDouble pi2 = dd_pi.sqr();
+    static_assert(pi2.upper > 9.86 && pi2.upper < 9.87, "constexpr sqr()");
+}
+
+void test_special_branches(CheckIt& test)
+{
+    dd_counters_reset();
+    DoubleDouble(1000.0).exp();
+    DoubleDouble(-1000.0).exp();
+    DoubleDouble(1.0).exp();
+    assert_equal_integer(test, count(dd_counter::exp), std::uint64_t(3), "exp");
+    assert_equal_integer(test, count(dd_counter::exp_overflow), std::uint64_t(1),
+                         "exp_overflow");
+    assert_equal_integer(test, count(dd_counter::exp_underflow), std::uint64_t(1),
+                         "exp_underflow");
+
+    DoubleDouble(1e-5).log1p();
+    DoubleDouble(0.5).log1p();
+    assert_equal_integer(test, count(dd_counter::log1p_taylor), std::uint64_t(1),
+                         "log1p_taylor");
+
+    dd_counters_reset();
+    DoubleDouble z(INFINITY, 1.0);
+    assert_true(test, z.upper == INFINITY, "DoubleDouble(INFINITY, 1.0)");
+    assert_equal_integer(test, count(dd_counter::constructor_nonfinite), std::uint64_t(1),
+                         "constructor_nonfinite");
+    DoubleDouble big(1e308);
+    z = big*10.0;
+    assert_equal_integer(test, count(dd_counter::nonfinite_result), std::uint64_t(1),
+                         "nonfinite_result");
+    z = big*0.5;
+    assert_equal_integer(test, count(dd_counter::nonfinite_result), std::uint64_t(1),
+                         "nonfinite_result (finite product)");
+}
+
+void test_threads(CheckIt& test)
+{
+    dd_counters_reset();
+    DoubleDouble a{1.5, 1e-17};
+    DoubleDouble r = a*a;
+    std::thread t([&]() {
+        DoubleDouble s = a;
+        for (int i = 0; i < 5; ++i) {
+            s = s*a;
+        }
+        r = s;
+    });
+    t.join();
+    assert_equal_integer(test, count(dd_counter::mul), std::uint64_t(1),
+                         "mul in this thread");
+    assert_equal_integer(test, dd_counters_total()[dd_counter::mul], std::uint64_t(6),
+                         "mul in all threads");
+
+    std::FILE *f = std::tmpfile();
+    dd_counters_dump(f);
+    std::rewind(f);
+    char line[100] = {0};
+    char *s = std::fgets(line, sizeof(line), f);
+    std::fclose(f);
+    assert_true(test, s != nullptr && std::strncmp(line, "mul ", 4) == 0
+                      && std::strstr(line, " 6\n") != nullptr,
+                std::string("dd_counters_dump(): ") + line);
+
+    dd_counters_reset();
+    assert_equal_integer(test, dd_counters_total()[dd_counter::mul], std::uint64_t(0),
+                         "dd_counters_reset()");
+}
+
+int main(int argc, char *argv[])
+{
+    auto test = CheckIt(std::cerr);
+
+    test_operator_counts(test);
+    test_special_branches(test);
+    test_threads(test);
+
+    return test.print_summary("Summary: ");
+}
@@ -0,0 +1,290 @@
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include "checkit.h"
+#include "doubledouble_io.h"
+
+using namespace doubledouble;
+
+
+static const char *tmp_path = "test_doubledouble_io.tmp";
+
+static bool same(const DoubleDouble& x, const DoubleDouble& y)
+{
+    if (std::isnan(x.upper) && std::isnan(y.upper)) {
+        return std::isnan(x.lower) && std::isnan(y.lower);
+    }
+    return x.upper == y.upper && x.lower == y.lower
+           && std::signbit(x.upper) == std::signbit(y.upper);
+}
+
+static std::vector<DoubleDouble> sample(std::size_t n, unsigned seed)
+{
+    std::mt19937_64 gen(seed);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::uniform_int_distribution<int> e(-300, 300);
+    std::vector<DoubleDouble> x(n);
+    for (auto& xi : x) {
+        double hi = std::ldexp(u(gen), e(gen));
+        xi = two_sum(hi, hi*1e-17*u(gen));
+    }
+    if (n > 3) {
+        x[0] = DoubleDouble(NAN);
+        x[1] = -dd_inf;
+        x[2] = DoubleDouble(-0.0);
+    }
+    return x;
+}
+
+static std::vector<unsigned char> read_bytes(const char *path)
+{
+    std::vector<unsigned char> bytes;
+    std::FILE *f = std::fopen(path, "rb");
+    if (f != nullptr) {
+        int c;
+        while ((c = std::fgetc(f)) != EOF) {
+            bytes.push_back((unsigned char) c);
+        }
+        std::fclose(f);
+    }
+    return bytes;
+}
+
+static void write_bytes(const char *path, const std::vector<unsigned char>& bytes)
+{
+    std::FILE *f = std::fopen(path, "wb");
+    std::fwrite(bytes.data(), 1, bytes.size(), f);
+    std::fclose(f);
+}
+
+static std::size_t count_mismatches(const DoubleDoubleFile& f,
+                                    const std::vector<DoubleDouble>& x)
+{
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        if (!same(f[i], x[i])) {
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
+void test_round_trip(CheckIt& test)
+{
+    for (std::size_t n : {std::size_t(0), std::size_t(1), std::size_t(1003)}) {
+        std::vector<DoubleDouble> x = sample(n, 17);
+        DoubleDoubleArray a(x);
+        for (auto layout : {dd_file_layout::pairs, dd_file_layout::planes}) {
+            std::string name = std::string(layout == dd_file_layout::pairs ? "pairs" : "planes")
+                               + ", n = " + std::to_string(n);
+            dd_file_status status = dd_write_file(tmp_path, x, layout);
+            assert_true(test, status == dd_file_status::ok, "write vector, " + name);
+            DoubleDoubleFile f;
+            status = f.open(tmp_path);
+            assert_true(test, status == dd_file_status::ok && f.is_open(), "open, " + name);
+            assert_true(test, f.size() == n && f.layout() == layout, "size and layout, " + name);
+            assert_equal_integer(test, count_mismatches(f, x), std::size_t(0),
+                                 "elements, " + name);
+
+            status = dd_write_file(tmp_path, a, layout);
+            assert_true(test, status == dd_file_status::ok, "write array, " + name);
+            status = f.open(tmp_path);
+            assert_true(test, status == dd_file_status::ok && f.size() == n,
+                        "reopen, " + name);
+            assert_equal_integer(test, count_mismatches(f, x), std::size_t(0),
+                                 "elements from array, " + name);
+        }
+    }
+}
+
+void test_zero_copy(CheckIt& test)
+{
+    std::vector<DoubleDouble> x = sample(1003, 5);
+    x[0] = DoubleDouble(0.5);
+    x[1] = DoubleDouble(-1e300);
+    x[2] = DoubleDouble(1e300);
+    DoubleDoubleArray a(x);
+
+    dd_write_file(tmp_path, a);
+    DoubleDoubleFile f;
+    f.open(tmp_path);
+#if DD_FILE_MMAP
+    assert_true(test, f.is_mapped(), "planes file is mapped");
+#endif
+    dd_const_span s = f.span();
+    assert_true(test, s.size == x.size() && f.data() == nullptr, "span() of planes file");
+    assert_true(test, reinterpret_cast<std::uintptr_t>(s.upper) % DD_ARRAY_ALIGNMENT == 0
+                      && reinterpret_cast<std::uintptr_t>(s.lower) % DD_ARRAY_ALIGNMENT == 0,
+                "planes are aligned");
+    DoubleDouble expected = dsum_dd(x.size(), &x[0]);
+    assert_true(test, same(dsum_dd(s), expected), "dsum_dd(span()) of planes file");
+
+    DoubleDoubleArray z(x.size());
+    dd_mul(z, s, a);
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        if (!same(z[i], x[i]*x[i])) {
+            ++mismatches;
+        }
+    }
+    assert_equal_integer(test, mismatches, std::size_t(0), "dd_mul with span() of planes file");
+
+    dd_write_file(tmp_path, x);
+    f.open(tmp_path);
+    const DoubleDouble *p = f.data();
+    assert_true(test, p != nullptr && f.span().size == 0, "data() of pairs file");
+    assert_true(test, same(dsum_dd(f.size(), p), expected), "dsum_dd(data()) of pairs file");
+    assert_true(test, same(p[3]*p[4] + p[5], x[3]*x[4] + x[5]), "operators with data()");
+
+    DoubleDoubleFile g(std::move(f));
+    assert_true(test, !f.is_open() && g.is_open() && g.data() == p, "move");
+    g.close();
+    assert_true(test, !g.is_open() && g.size() == 0, "close");
+}
+
+static std::uint32_t swap32(std::uint32_t x)
+{
+    return (x >> 24) | ((x >> 8) & 0xff00u) | ((x << 8) & 0xff0000u) | (x << 24);
+}
+
+static void reverse(std::vector<unsigned char>& bytes, std::size_t k, std::size_t size)
+{
+    std::reverse(bytes.begin() + k, bytes.begin() + k + size);
+}
+
+//
+// A file written on a machine with the other byte order is swapped.
+//
+void test_byte_order(CheckIt& test)
+{
+    std::vector<DoubleDouble> x = sample(100, 3);
+    for (auto layout : {dd_file_layout::pairs, dd_file_layout::planes}) {
+        dd_write_file(tmp_path, x, layout);
+        std::vector<unsigned char> bytes = read_bytes(tmp_path);
+        for (std::size_t k = 8; k < 24; k += 4) {
+            reverse(bytes, k, 4);
+        }
+        for (std::size_t k = 24; k < bytes.size(); k += 8) {
+            reverse(bytes, k, 8);
+        }
+        write_bytes(tmp_path, bytes);
+
+        std::string name = layout == dd_file_layout::pairs ? "pairs" : "planes";
+        DoubleDoubleFile f;
+        dd_file_status status = f.open(tmp_path);
+        assert_true(test, status == dd_file_status::ok && !f.is_mapped()
+                          && f.size() == x.size() && f.layout() == layout,
+                    "open swapped file, " + name);
+        assert_equal_integer(test, count_mismatches(f, x), std::size_t(0),
+                             "elements of swapped file, " + name);
+    }
+}
+
+void test_bad_files(CheckIt& test)
+{
+    DoubleDoubleFile f;
+    std::remove(tmp_path);
+    assert_true(test, f.open(tmp_path) == dd_file_status::open_failed, "missing file");
+
+    std::vector<DoubleDouble> x = sample(10, 1);
+    dd_write_file(tmp_path, x, dd_file_layout::planes);
+    const std::vector<unsigned char> good = read_bytes(tmp_path);
+    assert_equal_integer(test, good.size(), std::size_t(64 + 2*128), "file size");
+
+    std::vector<unsigned char> bytes = good;
+    bytes[0] = 'X';
+    write_bytes(tmp_path, bytes);
+    assert_true(test, f.open(tmp_path) == dd_file_status::bad_magic && !f.is_open(),
+                "bad magic");
+
+    bytes = good;
+    std::uint32_t version = DD_FILE_VERSION + 1;
+    std::memcpy(&bytes[12], &version, 4);
+    write_bytes(tmp_path, bytes);
+    assert_true(test, f.open(tmp_path) == dd_file_status::bad_version, "bad version");
+
+    // The same, written with the other byte order.
+    version = swap32(version);
+    std::memcpy(&bytes[12], &version, 4);
+    std::uint32_t byte_order = swap32(DD_FILE_BYTE_ORDER);
+    std::memcpy(&bytes[8], &byte_order, 4);
+    write_bytes(tmp_path, bytes);
+    assert_true(test, f.open(tmp_path) == dd_file_status::bad_version,
+                "bad version, swapped");
+
+    // A data offset near 2**64 in a swapped file must be rejected before
+    // any data is swapped.
+    bytes = good;
+    for (std::size_t k = 8; k < 24; k += 4) {
+        reverse(bytes, k, 4);
+    }
+    for (std::uint64_t offset : {~std::uint64_t(7), ~std::uint64_t(63)}) {
+        std::memcpy(&bytes[32], &offset, 8);
+        reverse(bytes, 32, 8);
+        write_bytes(tmp_path, bytes);
+        dd_file_status status = f.open(tmp_path);
+        assert_true(test, (status == dd_file_status::bad_header
+                           || status == dd_file_status::truncated)
+                          && !f.is_open(),
+                    "huge data offset, swapped");
+    }
+
+    bytes = good;
+    bytes[8] = 0x55;
+    write_bytes(tmp_path, bytes);
+    assert_true(test, f.open(tmp_path) == dd_file_status::bad_header, "bad byte order");
+
+    bytes = good;
+    std::uint32_t layout = 2;
+    std::memcpy(&bytes[16], &layout, 4);
+    write_bytes(tmp_path, bytes);
+    assert_true(test, f.open(tmp_path) == dd_file_status::bad_header, "bad layout");
+
+    bytes = good;
+    std::uint64_t count = 11;
+    std::memcpy(&bytes[24], &count, 8);
+    write_bytes(tmp_path, bytes);
+    assert_true(test, f.open(tmp_path) == dd_file_status::ok && f.size() == 11,
+                "count 11 fits in the padding");
+    count = 17;
+    std::memcpy(&bytes[24], &count, 8);
+    write_bytes(tmp_path, bytes);
+    assert_true(test, f.open(tmp_path) == dd_file_status::truncated, "count too large");
+    count = ~std::uint64_t(0)/8;
+    std::memcpy(&bytes[24], &count, 8);
+    write_bytes(tmp_path, bytes);
+    assert_true(test, f.open(tmp_path) == dd_file_status::bad_header, "huge count");
+
+    bytes = good;
+    bytes.resize(good.size() - 1);
+    write_bytes(tmp_path, bytes);
+    assert_true(test, f.open(tmp_path) == dd_file_status::truncated, "truncated data");
+    bytes.resize(40);
+    write_bytes(tmp_path, bytes);
+    assert_true(test, f.open(tmp_path) == dd_file_status::truncated, "truncated header");
+    bytes.clear();
+    write_bytes(tmp_path, bytes);
+    assert_true(test, f.open(tmp_path) == dd_file_status::bad_magic, "empty file");
+
+    assert_true(test, dd_write_file("no_such_directory/x.dd", x) == dd_file_status::open_failed,
+                "write to a missing directory");
+}
+
+int main(int argc, char *argv[])
+{
+    auto test = CheckIt(std::cerr);
+
+    test_round_trip(test);
+    test_zero_copy(test);
+    test_byte_order(test);
+    test_bad_files(test);
+    std::remove(tmp_path);
+
+    return test.print_summary("Summary: ");
+}
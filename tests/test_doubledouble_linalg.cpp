@@ -0,0 +1,273 @@
+
+#include <sstream>
+#include <cstdio>
+#include <vector>
+#include <cmath>
+#include <random>
+#include "checkit.h"
+#include "doubledouble_linalg.h"
+
+using namespace doubledouble;
+
+
+static std::vector<DoubleDouble> random_matrix(size_t m, size_t n,
+                                               unsigned seed)
+{
+    std::mt19937_64 gen(seed);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<DoubleDouble> a(m*n);
+    for (auto& v : a) {
+        v = DoubleDouble(u(gen)) / 3.0;
+    }
+    return a;
+}
+
+//
+// Check C against A*B computed with a triple loop.  The allowed error of
+// C[i, j] is 2**-100 * k * sum(|A[i, p]*B[p, j]|).
+//
+static void check_gemm(CheckIt& test, const std::string& label,
+                       size_t m, size_t n, size_t k,
+                       const std::vector<DoubleDouble>& A,
+                       const std::vector<DoubleDouble>& B,
+                       const std::vector<DoubleDouble>& C)
+{
+    size_t bad = 0;
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            DoubleDouble s{0.0};
+            double abs_sum = 0.0;
+            for (size_t p = 0; p < k; ++p) {
+                s = s + A[i*k + p]*B[p*n + j];
+                abs_sum += std::fabs(A[i*k + p].upper*B[p*n + j].upper);
+            }
+            double tol = std::ldexp(1.0, -100)*k*abs_sum;
+            bad += !((C[i*n + j] - s).abs() <= tol);
+        }
+    }
+    assert_equal_integer(test, bad, size_t(0), label);
+}
+
+void test_gemm(CheckIt& test)
+{
+    // Sizes that are not multiples of the block sizes, and a k larger
+    // than DD_GEMM_KC so that C is accumulated over several blocks.
+    size_t shapes[][3] = {{1, 1, 1}, {5, 9, 3}, {37, 29, 53},
+                          {70, 19, 2*DD_GEMM_KC + 7}};
+    for (auto& shape : shapes) {
+        size_t m = shape[0], n = shape[1], k = shape[2];
+        auto A = random_matrix(m, k, 1);
+        auto B = random_matrix(k, n, 2);
+        std::vector<DoubleDouble> C(m*n);
+        for (unsigned nthreads : {1u, 3u}) {
+            dd_gemm(m, n, k, A.data(), k, B.data(), n, C.data(), n, nthreads);
+            std::stringstream s;
+            s << "dd_gemm() " << m << "x" << k << " times " << k << "x" << n
+              << ", nthreads=" << nthreads;
+            check_gemm(test, s.str(), m, n, k, A, B, C);
+        }
+    }
+}
+
+void test_gemm_split_planes(CheckIt& test)
+{
+    // 3x2 times 2x2, with leading dimensions larger than the widths.
+    // The extra columns must not be read or written.
+    DoubleDoubleArray A(3*4), B(2*3), C(3*5);
+    double a[3][2] = {{1, 2}, {3, 4}, {5, 6}};
+    double b[2][2] = {{7, 8}, {9, 10}};
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 2; ++j) {
+            A.set(i*4 + j, DoubleDouble(a[i][j]));
+        }
+        A.set(i*4 + 2, DoubleDouble(NAN));
+    }
+    for (size_t i = 0; i < 2; ++i) {
+        for (size_t j = 0; j < 2; ++j) {
+            B.set(i*3 + j, DoubleDouble(b[i][j]));
+        }
+        B.set(i*3 + 2, DoubleDouble(NAN));
+    }
+    C.set(2, DoubleDouble(-1.0));
+    dd_gemm(3, 2, 2, A, 4, B, 3, C, 5);
+    double expected[3][2] = {{25, 28}, {57, 64}, {89, 100}};
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 2; ++j) {
+            std::stringstream s;
+            s << "dd_gemm() split planes C[" << i << ", " << j << "]";
+            assert_true(test, C[i*5 + j] == expected[i][j], s.str());
+        }
+    }
+    assert_true(test, C[2] == -1.0, "dd_gemm() does not write outside C");
+}
+
+void test_gemv(CheckIt& test)
+{
+    size_t m = 23, n = 101;
+    auto A = random_matrix(m, n, 3);
+    auto x = random_matrix(n, 1, 4);
+    std::vector<DoubleDouble> y(m);
+    dd_gemv(m, n, A.data(), n, x.data(), y.data());
+    check_gemm(test, "dd_gemv() DoubleDouble arrays", m, 1, n, A, x, y);
+
+    DoubleDoubleArray As(A), xs(x), ys(m);
+    dd_gemv(m, n, As, n, xs, ys, 2);
+    for (size_t i = 0; i < m; ++i) {
+        y[i] = ys[i];
+    }
+    check_gemm(test, "dd_gemv() split planes", m, 1, n, A, x, y);
+}
+
+void test_csr_spmv(CheckIt& test)
+{
+    // A row whose products need more than 53 bits and cancel:
+    // (1e10 + 1)*(1e10 - 1) - 1e10*(1e10 + 1) = -1e10 - 1.
+    // The second row is empty.
+    std::vector<int> row_ptr1{0, 2, 2};
+    std::vector<int> col_idx1{1, 0};
+    std::vector<double> values1{1e10 + 1, -1e10};
+    std::vector<double> x1{1e10 + 1, 1e10 - 1};
+    std::vector<DoubleDouble> y1(2);
+    dd_csr_spmv(2, row_ptr1.data(), col_idx1.data(), values1.data(), x1.data(),
+                y1.data());
+    assert_equal_fp(test, y1[0].upper, -1e10 - 1,
+                    "dd_csr_spmv() row 0 (upper)");
+    assert_equal_fp(test, y1[0].lower, 0.0, "dd_csr_spmv() row 0 (lower)");
+    assert_true(test, y1[1] == 0.0, "dd_csr_spmv() empty row");
+
+    // Random sparse matrix with 0 to 40 nonzeros per row, checked against
+    // a loop over the DoubleDouble operators.  Large enough that the
+    // rows are split over threads when nthreads > 1.
+    size_t m = 6000, n = 700;
+    std::mt19937_64 gen(5);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::uniform_int_distribution<size_t> len(0, 40), col(0, n - 1);
+    std::vector<size_t> row_ptr{0};
+    std::vector<size_t> col_idx;
+    std::vector<double> values;
+    for (size_t i = 0; i < m; ++i) {
+        size_t k = len(gen);
+        for (size_t p = 0; p < k; ++p) {
+            col_idx.push_back(col(gen));
+            values.push_back(u(gen)*1e3);
+        }
+        row_ptr.push_back(col_idx.size());
+    }
+    std::vector<double> x(n);
+    for (auto& v : x) {
+        v = u(gen);
+    }
+    for (unsigned nthreads : {1u, 3u}) {
+        std::vector<DoubleDouble> y(m);
+        std::vector<double> yd(m);
+        dd_csr_spmv(m, row_ptr.data(), col_idx.data(), values.data(), x.data(),
+                    y.data(), nthreads);
+        dd_csr_spmv(m, row_ptr.data(), col_idx.data(), values.data(), x.data(),
+                    yd.data(), nthreads);
+        size_t bad = 0;
+        for (size_t i = 0; i < m; ++i) {
+            DoubleDouble s{0.0};
+            double abs_sum = 0.0;
+            for (size_t p = row_ptr[i]; p < row_ptr[i + 1]; ++p) {
+                s += two_product(values[p], x[col_idx[p]]);
+                abs_sum += std::fabs(values[p]*x[col_idx[p]]);
+            }
+            double tol = std::ldexp(1.0, -100)*40*abs_sum;
+            bad += !((y[i] - s).abs() <= tol) || yd[i] != y[i].upper;
+        }
+        std::stringstream s;
+        s << "dd_csr_spmv() random matrix, nthreads=" << nthreads;
+        assert_equal_integer(test, bad, size_t(0), s.str());
+    }
+}
+
+void test_residual(CheckIt& test)
+{
+    // (1 + 2**-60)*3 is not a double, so b - A*x loses everything in
+    // double precision.
+    double A[]{3.0, 1.0};
+    double b[]{3.0};
+    DoubleDouble x[]{DoubleDouble(1.0, std::ldexp(1.0, -60)),
+                     DoubleDouble(0.0)};
+    DoubleDouble r[1];
+    dd_residual(1, 2, A, 2, b, x, r);
+    assert_equal_fp(test, r[0].upper, -3*std::ldexp(1.0, -60),
+                    "dd_residual() (upper)");
+    assert_equal_fp(test, r[0].lower, 0.0, "dd_residual() (lower)");
+}
+
+void test_solve_refine(CheckIt& test)
+{
+    // 4*x0 + x1 = 1, x0 + 3*x1 = 2 has the solution x = (1/11, 7/11).
+    double A1[]{4.0, 1.0, 1.0, 3.0};
+    double b1[]{1.0, 2.0};
+    DoubleDouble x1[2];
+    auto res1 = dd_solve_refine(2, A1, 2, b1, x1);
+    assert_true(test, res1.status == dd_refine_status::converged,
+                "dd_solve_refine() 2x2 converged");
+    DoubleDouble e1[]{DoubleDouble(1.0)/11, DoubleDouble(7.0)/11};
+    for (size_t i = 0; i < 2; ++i) {
+        assert_equal_fp(test, x1[i].upper, e1[i].upper,
+                        "dd_solve_refine() 2x2 (upper)");
+        assert_close_fp(test, x1[i].lower, e1[i].lower, 1e-14,
+                        "dd_solve_refine() 2x2 (lower)");
+    }
+
+    // The tridiagonal matrix with 2 on the diagonal and -1 on the off
+    // diagonals, with b = (1, 0, ..., 0).  The solution is
+    // x[i] = (n - i)/(n + 1), i = 0, ..., n-1.  A is stored with a
+    // leading dimension larger than n.
+    size_t n = 50, lda = 53;
+    std::vector<double> A2(n*lda, NAN), b2(n, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            A2[i*lda + j] = (i == j) ? 2.0
+                            : (i == j + 1 || j == i + 1) ? -1.0 : 0.0;
+        }
+    }
+    b2[0] = 1.0;
+    std::vector<DoubleDouble> x2(n);
+    auto res2 = dd_solve_refine(n, A2.data(), lda, b2.data(), x2.data(), 10, 2);
+    assert_true(test, res2.status == dd_refine_status::converged,
+                "dd_solve_refine() tridiagonal converged");
+    size_t bad = 0;
+    for (size_t i = 0; i < n; ++i) {
+        DoubleDouble expected = DoubleDouble(double(n - i)) / double(n + 1);
+        bad += !((x2[i] - expected).abs() <= 1e-30);
+    }
+    assert_equal_integer(test, bad, size_t(0),
+                         "dd_solve_refine() tridiagonal solution");
+
+    double A3[]{1.0, 2.0, 2.0, 4.0};
+    DoubleDouble x3[2];
+    auto res3 = dd_solve_refine(2, A3, 2, b1, x3);
+    assert_true(test, res3.status == dd_refine_status::singular,
+                "dd_solve_refine() singular");
+
+    // A NaN in A or an infinity in b must not be reported as convergence.
+    double A4[]{2.0, 1.0, 1.0, NAN};
+    DoubleDouble x4[2];
+    auto res4 = dd_solve_refine(2, A4, 2, b1, x4);
+    assert_true(test, res4.status == dd_refine_status::nonfinite,
+                "dd_solve_refine() NaN in A");
+    double b5[]{INFINITY, 2.0};
+    DoubleDouble x5[2];
+    auto res5 = dd_solve_refine(2, A1, 2, b5, x5);
+    assert_true(test, res5.status == dd_refine_status::nonfinite,
+                "dd_solve_refine() infinity in b");
+}
+
+
+int main(int argc, char *argv[])
+{
+    auto test = CheckIt(std::cerr);
+
+    test_gemm(test);
+    test_gemm_split_planes(test);
+    test_gemv(test);
+    test_csr_spmv(test);
+    test_residual(test);
+    test_solve_refine(test);
+
+    return test.print_summary("Summary: ");
+}
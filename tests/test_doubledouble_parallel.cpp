@@ -0,0 +1,122 @@
+
+#include <sstream>
+#include <cstdio>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+#include <cmath>
+#include "checkit.h"
+#include "doubledouble_parallel.h"
+
+using namespace doubledouble;
+
+
+void test_dsum_parallel_small(CheckIt& test)
+{
+    std::vector<double> empty;
+    assert_equal_fp(test, dsum_parallel(0, empty.data(), 4), 0.0,
+                    "dsum_parallel() of empty array");
+
+    std::vector<double> data{1.0, 2.0, 2e-17, -2.0, 10.0, -1.0, -10.0};
+    assert_equal_fp(test, dsum_parallel(data, 4), 2e-17,
+                    "dsum_parallel() of short array");
+}
+
+void test_dsum_parallel(CheckIt& test)
+{
+    // 10 full chunks plus a partial one.  The large terms cancel exactly;
+    // the sum of the rest is n/4 + (n/4)*2**-60.
+    size_t n = 10*DD_PARALLEL_CHUNK + 1236;
+    std::vector<double> x(n);
+    for (size_t i = 0; i < n; i += 4) {
+        x[i] = std::ldexp(1.0, 40)*(double(i % 7) - 3);
+        x[i + 1] = 1.0;
+        x[i + 2] = -x[i];
+        x[i + 3] = std::ldexp(1.0, -60);
+    }
+    double q = double(n/4);
+    for (unsigned nthreads : {0u, 1u, 2u, 3u, 7u, 64u}) {
+        DoubleDouble s = dsum_parallel_dd(n, x.data(), nthreads);
+        std::stringstream s1, s2;
+        s1 << "dsum_parallel_dd(), nthreads=" << nthreads << " (upper)";
+        s2 << "dsum_parallel_dd(), nthreads=" << nthreads << " (lower)";
+        assert_equal_fp(test, s.upper, q, s1.str());
+        assert_equal_fp(test, s.lower, q*std::ldexp(1.0, -60), s2.str());
+    }
+}
+
+void test_ddot_parallel(CheckIt& test)
+{
+    // Each group of three terms sums to -1e10 - 1 + 1e-5 exactly.
+    size_t m = 2*DD_PARALLEL_CHUNK + 11;
+    std::vector<double> x, y;
+    for (size_t k = 0; k < m; ++k) {
+        x.insert(x.end(), {1e10 + 1, -1e10, 1e-5});
+        y.insert(y.end(), {1e10 - 1, 1e10 + 1, 1.0});
+    }
+    DoubleDouble expected = double(m)*two_sum(-1e10 - 1, 1e-5);
+    double abs_sum = m*(2e20 + 1e10);
+    for (unsigned nthreads : {1u, 2u, 5u}) {
+        DoubleDouble d = ddot_parallel_dd(x.size(), x.data(), y.data(),
+                                          nthreads);
+        std::stringstream s1, s2;
+        s1 << "ddot_parallel_dd(), nthreads=" << nthreads << " (upper)";
+        s2 << "ddot_parallel_dd(), nthreads=" << nthreads << " (error)";
+        assert_equal_fp(test, d.upper, expected.upper, s1.str());
+        // See test_ddot() in test_doubledouble.cpp for this bound.
+        assert_true(test, (d - expected).abs() < 1e-30*abs_sum, s2.str());
+    }
+    assert_equal_fp(test, ddot_parallel(x, y, 3), expected.upper,
+                    "ddot_parallel(vector, vector)");
+}
+
+void test_dd_parallel_nthreads(CheckIt& test)
+{
+    assert_equal_integer(test, dd_parallel_nthreads(0, 8), 1u,
+                         "no elements -> 1 thread");
+    assert_equal_integer(test, dd_parallel_nthreads(DD_PARALLEL_CHUNK, 8), 1u,
+                         "one chunk -> 1 thread");
+    assert_equal_integer(test, dd_parallel_nthreads(3*DD_PARALLEL_CHUNK - 1, 8),
+                         3u, "three chunks -> 3 threads");
+    assert_equal_integer(test, dd_parallel_nthreads(100*DD_PARALLEL_CHUNK, 8),
+                         8u, "many chunks -> 8 threads");
+    assert_true(test, dd_parallel_nthreads(100*DD_PARALLEL_CHUNK, 0) >= 1,
+                "nthreads=0 -> at least 1 thread");
+}
+
+void test_dd_parallel_run_throws(CheckIt& test)
+{
+    // f(0) throws after the other threads have been started; they must be
+    // joined (not left running, which would call std::terminate()) before
+    // the exception reaches the caller.
+    std::atomic<unsigned> nrun{0};
+    bool caught = false;
+    try {
+        dd_parallel_run(4, [&](unsigned k) {
+            if (k == 0) {
+                throw std::runtime_error("f(0)");
+            }
+            ++nrun;
+        });
+    }
+    catch (const std::runtime_error&) {
+        caught = true;
+    }
+    assert_true(test, caught, "dd_parallel_run() rethrows");
+    assert_equal_integer(test, nrun.load(), 3u,
+                         "dd_parallel_run() joins the started threads");
+}
+
+
+int main(int argc, char *argv[])
+{
+    auto test = CheckIt(std::cerr);
+
+    test_dsum_parallel_small(test);
+    test_dsum_parallel(test);
+    test_ddot_parallel(test);
+    test_dd_parallel_nthreads(test);
+    test_dd_parallel_run_throws(test);
+
+    return test.print_summary("Summary: ");
+}
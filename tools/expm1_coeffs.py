@@ -18,7 +18,7 @@ def print_doubledouble_list(dds):
 
 def print_doubledouble_array(name, dds):
     n = len(dds)
-    print(f"static const std::array<DoubleDouble, {n}> {name}{{")
+    print(f"inline constexpr std::array<DoubleDouble, {n}> {name}{{")
     print_doubledouble_list(dds)
     print('};')
 